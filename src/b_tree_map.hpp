@@ -0,0 +1,927 @@
+#ifndef B_TREE_MAP_HPP_
+#define B_TREE_MAP_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include "ics_exceptions.hpp"
+#include "functor.hpp"
+#include "pair.hpp"
+
+
+namespace ics {
+
+
+//A B+ tree: the same interface as BSTMap, but each node stores many keys in
+//  contiguous arrays (sized to a few cache lines), so a lookup touches
+//  O(log_B N) nodes instead of O(log_2 N), and every leaf is linked to the
+//  next one so iteration in key order is a simple walk along the leaves.
+//Instantiate such that tlt(a,b) is true, iff a is ordered before b
+//With a tlt specified in the template, the constructor cannot specify a clt.
+//If a tlt is defaulted, then the constructor must supply a clt (they cannot both be nullptr)
+//Instead, LT can be a functor type whose LT()(a,b) is the ordering (then neither tlt nor clt is supplied)
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr, class LT = void> class BTreeMap {
+  public:
+    typedef pair<KEY,T> Entry;
+
+    //Destructor/Constructors
+    ~BTreeMap();
+
+    BTreeMap          (bool (*clt)(const KEY& a, const KEY& b) = nullptr);
+    BTreeMap          (const BTreeMap<KEY,T,tlt,LT>& to_copy, bool (*clt)(const KEY& a, const KEY& b) = nullptr);
+    explicit BTreeMap (const std::initializer_list<Entry>& il, bool (*clt)(const KEY& a, const KEY& b) = nullptr);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit BTreeMap (const Iterable& i, bool (*clt)(const KEY& a, const KEY& b) = nullptr);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    int  height     () const; //# of levels (0 for an empty map, 1 when the root is a leaf)
+    bool has_key    (const KEY& key) const;
+    bool has_value  (const T& value) const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    T    put   (const KEY& key, const T& value);
+    T    erase (const KEY& key);
+    void clear ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int put_all(const Iterable& i);
+
+
+    //Operators
+
+    T&       operator [] (const KEY&);
+    const T& operator [] (const KEY&) const;
+    BTreeMap<KEY,T,tlt,LT>& operator = (const BTreeMap<KEY,T,tlt,LT>& rhs);
+    bool operator == (const BTreeMap<KEY,T,tlt,LT>& rhs) const;
+    bool operator != (const BTreeMap<KEY,T,tlt,LT>& rhs) const;
+
+    template<class KEY2,class T2, bool (*lt2)(const KEY2& a, const KEY2& b), class LT2>
+    friend std::ostream& operator << (std::ostream& outs, const BTreeMap<KEY2,T2,lt2,LT2>& m);
+
+
+
+  private:
+    class Node;
+    class LN;
+    class IN;
+
+  public:
+    class Iterator {
+      public:
+        typedef pair<LN*,int> Cursor;
+
+        //Private constructor called in begin/end, which are friends of BTreeMap<T>
+        ~Iterator();
+        Entry       erase();
+        std::string str  () const;
+        BTreeMap<KEY,T,tlt,LT>::Iterator& operator ++ ();
+        BTreeMap<KEY,T,tlt,LT>::Iterator  operator ++ (int);
+        bool operator == (const BTreeMap<KEY,T,tlt,LT>::Iterator& rhs) const;
+        bool operator != (const BTreeMap<KEY,T,tlt,LT>::Iterator& rhs) const;
+        Entry& operator *  () const;
+        Entry* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const BTreeMap<KEY,T,tlt,LT>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+        friend Iterator BTreeMap<KEY,T,tlt,LT>::begin () const;
+        friend Iterator BTreeMap<KEY,T,tlt,LT>::end   () const;
+
+      private:
+        //If can_erase is false, current indexes the "next" value (must ++ to reach it)
+        Cursor                  current; //Leaf and index in it; stop: LN* == nullptr
+        BTreeMap<KEY,T,tlt,LT>* ref_map;
+        int                     expected_mod_count;
+        bool                    can_erase = true;
+
+        //Called in friends begin/end
+        Iterator(BTreeMap<KEY,T,tlt,LT>* iterate_over, bool from_begin);
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+    //Node sizes are chosen so the key/value arrays of one node span about
+    //  node_bytes bytes (4 cache lines); each array has one extra slot so a
+    //  node may overflow by one before it is split
+    static const int node_bytes      = 256;
+    static const int leaf_capacity   = sizeof(Entry) >= node_bytes/4 ? 4 : node_bytes/sizeof(Entry) - 1;
+    static const int inner_capacity  = sizeof(KEY)   >= node_bytes/4 ? 4 : node_bytes/sizeof(KEY)   - 1;
+    static const int leaf_minimum    = leaf_capacity/2;
+    static const int inner_minimum   = inner_capacity/2;
+
+    class Node {
+      public:
+        Node (bool l) : leaf(l) {}
+
+        bool leaf;
+        int  count = 0;                          //# values (in LN) or keys (in IN)
+    };
+
+    class LN : public Node {                     //Leaf Node: count sorted values
+      public:
+        LN () : Node(true) {}
+
+        Entry values[leaf_capacity+1];
+        LN*   next = nullptr;                    //Next leaf in key order
+    };
+
+    class IN : public Node {                     //Inner Node: count keys separate count+1 children
+      public:
+        IN () : Node(false) {}
+
+        KEY   keys    [inner_capacity+1];        //keys[i] is the smallest key in children[i+1]
+        Node* children[inner_capacity+2];
+    };
+
+  static_assert(std::is_void<LT>::value || tlt == nullptr, "BTreeMap: specify tlt or LT, not both");
+  bool (*lt) (const KEY& a, const KEY& b); // The lt used for searching (from template or constructor)
+  Node* map       = nullptr;                 //Root of the B+ tree
+  LN*   first     = nullptr;                 //Leftmost leaf: start of iteration
+  int   used      = 0;                       //Cache for number of key->value pairs in the tree
+  int   mod_count = 0;                       //For sensing concurrent modification
+
+  //Helper methods
+  bool is_lt (const KEY& a, const KEY& b) const; //True iff a < b: via the functor type, tlt or lt (see functor.hpp)
+  int    leaf_position (LN* l, const KEY& key)        const; //Index of first value whose key is not < key
+  int    child_index   (IN* n, const KEY& key)        const; //Index of child whose subtree could contain key
+  LN*    find_leaf     (const KEY& key)               const; //Leaf that key is in (or would be inserted in)
+  Entry* find_key      (const KEY& key)               const; //Returns pointer to key's entry or nullptr
+  pair<LN*,int>
+         lower_bound   (const KEY& key)               const; //Cursor at first entry whose key is not < key
+  Node*  copy          (Node* root, LN*& last);             //Copy root's tree, linking its leaves after last
+  std::string string_indented(Node* root, std::string indent) const; //Returns string representing root's tree
+
+  T      insert        (Node* root, const KEY& key, const T& value, KEY& split_key, Node*& split_node);
+  bool   remove        (Node* root, const KEY& key, T& old_value);
+  void   fix_underflow (IN* parent, int c);                  //Borrow from or merge with a sibling of parent->children[c]
+  void   delete_tree   (Node*& root);                        //Deallocate all nodes in tree; root == nullptr
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//BTreeMap class and related definitions
+
+//Destructor/Constructors
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BTreeMap<KEY,T,tlt,LT>::~BTreeMap() {
+  delete_tree(map);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BTreeMap<KEY,T,tlt,LT>::BTreeMap(bool (*clt)(const KEY& a, const KEY& b))
+: lt(tlt != nullptr ? tlt : clt) {
+  if (lt == nullptr && std::is_void<LT>::value)
+    throw TemplateFunctionError("BTreeMap::default constructor: neither specified");
+  if ((tlt != nullptr || !std::is_void<LT>::value) && clt != nullptr && tlt != clt)
+    throw TemplateFunctionError("BTreeMap::default constructor: both specified and different");
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BTreeMap<KEY,T,tlt,LT>::BTreeMap(const BTreeMap<KEY,T,tlt,LT>& to_copy, bool (*clt)(const KEY& a, const KEY& b))
+: lt(tlt != nullptr ? tlt : clt) {
+  if (lt == nullptr)
+    lt = to_copy.lt;
+  if ((tlt != nullptr || !std::is_void<LT>::value) && clt != nullptr && tlt != clt)
+    throw TemplateFunctionError("BTreeMap::copy constructor: both specified and different");
+
+  if (lt == to_copy.lt) {
+    LN* last = nullptr;
+    map  = copy(to_copy.map,last);
+    used = to_copy.used;
+  }else
+    for (LN* l = to_copy.first; l != nullptr; l = l->next)
+      for (int i=0; i<l->count; ++i)
+        put(l->values[i].first,l->values[i].second);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BTreeMap<KEY,T,tlt,LT>::BTreeMap(const std::initializer_list<Entry>& il, bool (*clt)(const KEY& a, const KEY& b))
+: lt(tlt != nullptr ? tlt : clt) {
+  if (lt == nullptr && std::is_void<LT>::value)
+    throw TemplateFunctionError("BTreeMap::initializer_list constructor: neither specified");
+  if ((tlt != nullptr || !std::is_void<LT>::value) && clt != nullptr && tlt != clt)
+    throw TemplateFunctionError("BTreeMap::initializer_list constructor: both specified and different");
+
+  for (const Entry& m_entry : il)
+    put(m_entry.first,m_entry.second);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+template <class Iterable>
+BTreeMap<KEY,T,tlt,LT>::BTreeMap(const Iterable& i, bool (*clt)(const KEY& a, const KEY& b))
+: lt(tlt != nullptr ? tlt : clt) {
+  if (lt == nullptr && std::is_void<LT>::value)
+    throw TemplateFunctionError("BTreeMap::Iterable constructor: neither specified");
+  if ((tlt != nullptr || !std::is_void<LT>::value) && clt != nullptr && tlt != clt)
+    throw TemplateFunctionError("BTreeMap::Iterable constructor: both specified and different");
+
+  for (const Entry& m_entry : i)
+    put(m_entry.first,m_entry.second);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BTreeMap<KEY,T,tlt,LT>::empty() const {
+  return used == 0;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+int BTreeMap<KEY,T,tlt,LT>::size() const {
+  return used;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+int BTreeMap<KEY,T,tlt,LT>::height() const {
+  int levels = 0;
+  for (Node* n = map; n != nullptr; n = (n->leaf ? nullptr : static_cast<IN*>(n)->children[0]))
+    ++levels;
+  return levels;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BTreeMap<KEY,T,tlt,LT>::has_key (const KEY& key) const {
+  return find_key(key) != nullptr;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BTreeMap<KEY,T,tlt,LT>::has_value (const T& value) const {
+  for (LN* l = first; l != nullptr; l = l->next)
+    for (int i=0; i<l->count; ++i)
+      if (value == l->values[i].second)
+        return true;
+
+  return false;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+std::string BTreeMap<KEY,T,tlt,LT>::str() const {
+  std::ostringstream answer;
+  answer << "BTreeMap[\n" << string_indented(map,"");
+  answer << "](used=" << used << ",height=" << height() << ",leaf_capacity=" << leaf_capacity
+         << ",inner_capacity=" << inner_capacity << ",mod_count=" << mod_count << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T BTreeMap<KEY,T,tlt,LT>::put(const KEY& key, const T& value) {
+  ++mod_count;
+  if (map == nullptr) {
+    LN* root = new LN();
+    root->values[0] = Entry(key,value);
+    root->count = 1;
+    map = first = root;
+    ++used;
+    return value;
+  }
+
+  KEY   split_key;
+  Node* split_node = nullptr;
+  T to_return = insert(map, key, value, split_key, split_node);
+  if (split_node != nullptr) {
+    //Root was split: grow the tree by one level
+    IN* root = new IN();
+    root->keys[0]     = split_key;
+    root->children[0] = map;
+    root->children[1] = split_node;
+    root->count = 1;
+    map = root;
+  }
+  return to_return;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T BTreeMap<KEY,T,tlt,LT>::erase(const KEY& key) {
+  T to_return;
+  if (map == nullptr || !remove(map, key, to_return)) {
+    std::ostringstream answer;
+    answer << "BTreeMap::erase: key(" << key << ") not in Map";
+    throw KeyError(answer.str());
+  }
+
+  //Shrink the tree by one level if the root has a single child (or no values)
+  if (!map->leaf && map->count == 0) {
+    IN* old_root = static_cast<IN*>(map);
+    map = old_root->children[0];
+    delete old_root;
+  }else if (map->leaf && map->count == 0) {
+    delete static_cast<LN*>(map);
+    map = first = nullptr;
+  }
+
+  --used;
+  ++mod_count;
+  return to_return;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BTreeMap<KEY,T,tlt,LT>::clear() {
+  delete_tree(map);
+  first = nullptr;
+  used = 0;
+  ++mod_count;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+template<class Iterable>
+int BTreeMap<KEY,T,tlt,LT>::put_all(const Iterable& i) {
+  int count = 0;
+  for (const Entry& m_entry : i) {
+    ++count;
+    put(m_entry.first, m_entry.second);
+  }
+
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T& BTreeMap<KEY,T,tlt,LT>::operator [] (const KEY& key) {
+  Entry* e = find_key(key);
+  if (e != nullptr)
+    return e->second;
+
+  put(key,T());
+  return find_key(key)->second;   //put may have moved entries while splitting
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+const T& BTreeMap<KEY,T,tlt,LT>::operator [] (const KEY& key) const {
+  Entry* e = find_key(key);
+  if (e != nullptr)
+    return e->second;
+
+  std::ostringstream answer;
+  answer << "BTreeMap::operator []: key(" << key << ") not in Map";
+  throw KeyError(answer.str());
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BTreeMap<KEY,T,tlt,LT>& BTreeMap<KEY,T,tlt,LT>::operator = (const BTreeMap<KEY,T,tlt,LT>& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  delete_tree(map);
+  first = nullptr;
+  lt = rhs.lt;   // if tlt != nullptr, lts are already equal (or compiler error)
+  LN* last = nullptr;
+  map  = copy(rhs.map,last);
+  used = rhs.used;
+  ++mod_count;
+  return *this;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BTreeMap<KEY,T,tlt,LT>::operator == (const BTreeMap<KEY,T,tlt,LT>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (used != rhs.size() || lt != rhs.lt)
+    return false;
+
+  //Same ordering: both leaf chains list the same entries in the same order
+  LN* l = first;       int li = 0;
+  LN* r = rhs.first;   int ri = 0;
+  for (int i=0; i<used; ++i) {
+    if (li == l->count) l = l->next, li = 0;
+    if (ri == r->count) r = r->next, ri = 0;
+    if (l->values[li].first != r->values[ri].first || l->values[li].second != r->values[ri].second)
+      return false;
+    ++li, ++ri;
+  }
+
+  return true;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BTreeMap<KEY,T,tlt,LT>::operator != (const BTreeMap<KEY,T,tlt,LT>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+std::ostream& operator << (std::ostream& outs, const BTreeMap<KEY,T,tlt,LT>& m) {
+  outs << "map[";
+
+  int printed = 0;
+  for (typename BTreeMap<KEY,T,tlt,LT>::LN* l = m.first; l != nullptr; l = l->next)
+    for (int i=0; i<l->count; ++i)
+      outs << (printed++ == 0? "" : ",") << l->values[i].first << "->" << l->values[i].second;
+
+  outs << "]";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BTreeMap<KEY,T,tlt,LT>::begin () const -> BTreeMap<KEY,T,tlt,LT>::Iterator {
+  return Iterator(const_cast<BTreeMap<KEY,T,tlt,LT>*>(this),true);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BTreeMap<KEY,T,tlt,LT>::end () const -> BTreeMap<KEY,T,tlt,LT>::Iterator {
+  return Iterator(const_cast<BTreeMap<KEY,T,tlt,LT>*>(this),false);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BTreeMap<KEY,T,tlt,LT>::is_lt (const KEY& a, const KEY& b) const {
+  return Functor<LT>::call(tlt != nullptr ? tlt : lt, a, b);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+int BTreeMap<KEY,T,tlt,LT>::leaf_position (LN* l, const KEY& key) const {
+  int low = 0, high = l->count;
+  while (low < high) {
+    int mid = (low+high)/2;
+    if (is_lt(l->values[mid].first,key))
+      low = mid+1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+int BTreeMap<KEY,T,tlt,LT>::child_index (IN* n, const KEY& key) const {
+  int low = 0, high = n->count;
+  while (low < high) {
+    int mid = (low+high)/2;
+    if (is_lt(key,n->keys[mid]))
+      high = mid;
+    else
+      low = mid+1;
+  }
+  return low;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+typename BTreeMap<KEY,T,tlt,LT>::LN* BTreeMap<KEY,T,tlt,LT>::find_leaf (const KEY& key) const {
+  Node* n = map;
+  while (n != nullptr && !n->leaf)
+    n = static_cast<IN*>(n)->children[child_index(static_cast<IN*>(n),key)];
+  return static_cast<LN*>(n);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BTreeMap<KEY,T,tlt,LT>::find_key (const KEY& key) const -> Entry* {
+  LN* l = find_leaf(key);
+  if (l == nullptr)
+    return nullptr;
+  int i = leaf_position(l,key);
+  return i < l->count && l->values[i].first == key ? &l->values[i] : nullptr;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BTreeMap<KEY,T,tlt,LT>::lower_bound (const KEY& key) const -> pair<LN*,int> {
+  LN* l = find_leaf(key);
+  if (l == nullptr)
+    return pair<LN*,int>(nullptr,0);
+  int i = leaf_position(l,key);
+  if (i == l->count)                           //All keys in l are < key: start of next leaf
+    l = l->next, i = 0;
+  return pair<LN*,int>(l,i);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+typename BTreeMap<KEY,T,tlt,LT>::Node* BTreeMap<KEY,T,tlt,LT>::copy (Node* root, LN*& last) {
+  if (root == nullptr)
+    return nullptr;
+
+  if (root->leaf) {
+    LN* from = static_cast<LN*>(root);
+    LN* to   = new LN();
+    for (int i=0; i<from->count; ++i)
+      to->values[i] = from->values[i];
+    to->count = from->count;
+    (last == nullptr ? first : last->next) = to;
+    last = to;
+    return to;
+  }
+
+  IN* from = static_cast<IN*>(root);
+  IN* to   = new IN();
+  for (int i=0; i<from->count; ++i)
+    to->keys[i] = from->keys[i];
+  for (int i=0; i<=from->count; ++i)
+    to->children[i] = copy(from->children[i],last);
+  to->count = from->count;
+  return to;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+std::string BTreeMap<KEY,T,tlt,LT>::string_indented(Node* root, std::string indent) const {
+  if (root == nullptr)
+    return "";
+  std::ostringstream answer;
+  answer << indent;
+  if (root->leaf) {
+    LN* l = static_cast<LN*>(root);
+    answer << "(";
+    for (int i=0; i<l->count; ++i)
+      answer << (i == 0 ? "" : ",") << l->values[i].first << "->" << l->values[i].second;
+    answer << ")\n";
+  }else {
+    IN* n = static_cast<IN*>(root);
+    answer << "[";
+    for (int i=0; i<n->count; ++i)
+      answer << (i == 0 ? "" : ",") << n->keys[i];
+    answer << "]\n";
+    for (int i=0; i<=n->count; ++i)
+      answer << string_indented(n->children[i], indent + "--");
+  }
+  return answer.str();
+}
+
+
+//Put key->value in root's subtree, returning key's old value (or value, if key absent).
+//If root overflows it is split in two: split_node is the new right half and
+//  split_key the smallest key in it (split_node is otherwise unchanged)
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T BTreeMap<KEY,T,tlt,LT>::insert (Node* root, const KEY& key, const T& value, KEY& split_key, Node*& split_node) {
+  if (root->leaf) {
+    LN* l = static_cast<LN*>(root);
+    int i = leaf_position(l,key);
+    if (i < l->count && l->values[i].first == key) {
+      T old = l->values[i].second;
+      l->values[i].second = value;
+      return old;
+    }
+
+    for (int j=l->count; j>i; --j)
+      l->values[j] = l->values[j-1];
+    l->values[i] = Entry(key,value);
+    ++l->count;
+    ++used;
+
+    if (l->count > leaf_capacity) {
+      LN* right = new LN();
+      int keep  = l->count/2;
+      for (int j=keep; j<l->count; ++j)
+        right->values[j-keep] = l->values[j];
+      right->count = l->count-keep;
+      l->count     = keep;
+      right->next  = l->next;
+      l->next      = right;
+      split_key  = right->values[0].first;
+      split_node = right;
+    }
+    return value;
+  }
+
+  IN* n = static_cast<IN*>(root);
+  int c = child_index(n,key);
+  KEY   child_key;
+  Node* child_split = nullptr;
+  T to_return = insert(n->children[c], key, value, child_key, child_split);
+  if (child_split == nullptr)
+    return to_return;
+
+  //Child was split: its new right half becomes children[c+1]
+  for (int j=n->count; j>c; --j) {
+    n->keys    [j]   = n->keys[j-1];
+    n->children[j+1] = n->children[j];
+  }
+  n->keys    [c]   = child_key;
+  n->children[c+1] = child_split;
+  ++n->count;
+
+  if (n->count > inner_capacity) {
+    //Middle key moves up; keys/children to its right move to a new node
+    IN* right = new IN();
+    int mid   = n->count/2;
+    for (int j=mid+1; j<n->count; ++j)
+      right->keys[j-mid-1] = n->keys[j];
+    for (int j=mid+1; j<=n->count; ++j)
+      right->children[j-mid-1] = n->children[j];
+    right->count = n->count-mid-1;
+    n->count     = mid;
+    split_key  = n->keys[mid];
+    split_node = right;
+  }
+  return to_return;
+}
+
+
+//Remove key from root's subtree, storing its value in old_value; return whether it was there.
+//Children left with too few values/keys borrow from or merge with a sibling.
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BTreeMap<KEY,T,tlt,LT>::remove (Node* root, const KEY& key, T& old_value) {
+  if (root->leaf) {
+    LN* l = static_cast<LN*>(root);
+    int i = leaf_position(l,key);
+    if (i == l->count || l->values[i].first != key)
+      return false;
+    old_value = l->values[i].second;
+    for (int j=i+1; j<l->count; ++j)
+      l->values[j-1] = l->values[j];
+    --l->count;
+    return true;
+  }
+
+  IN* n = static_cast<IN*>(root);
+  int c = child_index(n,key);
+  if (!remove(n->children[c], key, old_value))
+    return false;
+
+  Node* child = n->children[c];
+  if (child->count < (child->leaf ? leaf_minimum : inner_minimum))
+    fix_underflow(n,c);
+  return true;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BTreeMap<KEY,T,tlt,LT>::fix_underflow (IN* parent, int c) {
+  Node* child = parent->children[c];
+  Node* left  = (c > 0             ? parent->children[c-1] : nullptr);
+  Node* right = (c < parent->count ? parent->children[c+1] : nullptr);
+
+  if (child->leaf) {
+    LN* l = static_cast<LN*>(child);
+    LN* ls = static_cast<LN*>(left);
+    LN* rs = static_cast<LN*>(right);
+    if (ls != nullptr && ls->count > leaf_minimum) {          //Borrow largest from left sibling
+      for (int j=l->count; j>0; --j)
+        l->values[j] = l->values[j-1];
+      l->values[0] = ls->values[--ls->count];
+      ++l->count;
+      parent->keys[c-1] = l->values[0].first;
+      return;
+    }
+    if (rs != nullptr && rs->count > leaf_minimum) {          //Borrow smallest from right sibling
+      l->values[l->count++] = rs->values[0];
+      for (int j=1; j<rs->count; ++j)
+        rs->values[j-1] = rs->values[j];
+      --rs->count;
+      parent->keys[c] = rs->values[0].first;
+      return;
+    }
+    //Merge the pair (ls,l) or (l,rs) into its left node
+    if (ls == nullptr)
+      ls = l, l = rs, ++c;
+    for (int j=0; j<l->count; ++j)
+      ls->values[ls->count++] = l->values[j];
+    ls->next = l->next;
+    delete l;
+  }else {
+    IN* n  = static_cast<IN*>(child);
+    IN* ls = static_cast<IN*>(left);
+    IN* rs = static_cast<IN*>(right);
+    if (ls != nullptr && ls->count > inner_minimum) {         //Rotate through parent from left sibling
+      for (int j=n->count; j>0; --j)
+        n->keys[j] = n->keys[j-1];
+      for (int j=n->count+1; j>0; --j)
+        n->children[j] = n->children[j-1];
+      n->keys[0]        = parent->keys[c-1];
+      n->children[0]    = ls->children[ls->count];
+      parent->keys[c-1] = ls->keys[ls->count-1];
+      --ls->count;
+      ++n->count;
+      return;
+    }
+    if (rs != nullptr && rs->count > inner_minimum) {         //Rotate through parent from right sibling
+      n->keys[n->count]       = parent->keys[c];
+      n->children[n->count+1] = rs->children[0];
+      parent->keys[c]         = rs->keys[0];
+      for (int j=1; j<rs->count; ++j)
+        rs->keys[j-1] = rs->keys[j];
+      for (int j=1; j<=rs->count; ++j)
+        rs->children[j-1] = rs->children[j];
+      --rs->count;
+      ++n->count;
+      return;
+    }
+    //Merge the pair (ls,n) or (n,rs) into its left node, pulling down the separating key
+    if (ls == nullptr)
+      ls = n, n = rs, ++c;
+    ls->keys[ls->count] = parent->keys[c-1];
+    for (int j=0; j<n->count; ++j)
+      ls->keys[ls->count+1+j] = n->keys[j];
+    for (int j=0; j<=n->count; ++j)
+      ls->children[ls->count+1+j] = n->children[j];
+    ls->count += 1+n->count;
+    delete n;
+  }
+
+  //children[c] was merged into children[c-1]: remove keys[c-1] and children[c] from parent
+  for (int j=c; j<parent->count; ++j) {
+    parent->keys    [j-1] = parent->keys[j];
+    parent->children[j]   = parent->children[j+1];
+  }
+  --parent->count;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BTreeMap<KEY,T,tlt,LT>::delete_tree (Node*& root) {
+  if (root == nullptr)
+    return;
+  if (root->leaf)
+    delete static_cast<LN*>(root);
+  else {
+    IN* n = static_cast<IN*>(root);
+    for (int i=0; i<=n->count; ++i)
+      delete_tree(n->children[i]);
+    delete n;
+  }
+  root = nullptr;
+}
+
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BTreeMap<KEY,T,tlt,LT>::Iterator::Iterator(BTreeMap<KEY,T,tlt,LT>* iterate_over, bool from_begin)
+: current(nullptr,0), ref_map(iterate_over), expected_mod_count(ref_map->mod_count) {
+  if (from_begin)
+    current.first = ref_map->first;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BTreeMap<KEY,T,tlt,LT>::Iterator::~Iterator()
+{}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BTreeMap<KEY,T,tlt,LT>::Iterator::erase() -> Entry {
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("BTreeMap::Iterator::erase");
+  if (!can_erase)
+    throw CannotEraseError("BTreeMap::Iterator::erase Iterator cursor already erased");
+  if (current.first == nullptr)
+    throw CannotEraseError("BTreeMap::Iterator::erase Iterator cursor beyond data structure");
+
+  can_erase = false;
+  Entry to_return = current.first->values[current.second];
+  ref_map->erase(to_return.first);
+
+  //Erasing may move entries between leaves: find the entry after the erased one
+  current = ref_map->lower_bound(to_return.first);
+  expected_mod_count = ref_map->mod_count;
+  return to_return;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+std::string BTreeMap<KEY,T,tlt,LT>::Iterator::str() const {
+  std::ostringstream answer;
+  answer << ref_map->str() << "(current=" << current.first << "/" << current.second << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
+  return answer.str();
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BTreeMap<KEY,T,tlt,LT>::Iterator::operator ++ () -> BTreeMap<KEY,T,tlt,LT>::Iterator& {
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("BTreeMap::Iterator::operator ++");
+
+  if (current.first == nullptr)
+    return *this;
+
+  if (can_erase && ++current.second == current.first->count)
+    current = Cursor(current.first->next,0);
+
+  can_erase = true;
+  return *this;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BTreeMap<KEY,T,tlt,LT>::Iterator::operator ++ (int) -> BTreeMap<KEY,T,tlt,LT>::Iterator {
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("BTreeMap::Iterator::operator ++(int)");
+
+  Iterator to_return(*this);
+
+  if (current.first == nullptr)
+    return to_return;
+
+  if (can_erase && ++current.second == current.first->count)
+    current = Cursor(current.first->next,0);
+
+  can_erase = true;
+  return to_return;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BTreeMap<KEY,T,tlt,LT>::Iterator::operator == (const BTreeMap<KEY,T,tlt,LT>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("BTreeMap::Iterator::operator ==");
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("BTreeMap::Iterator::operator ==");
+  if (ref_map != rhsASI->ref_map)
+    throw ComparingDifferentIteratorsError("BTreeMap::Iterator::operator ==");
+
+  return current.first == rhsASI->current.first && current.second == rhsASI->current.second;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BTreeMap<KEY,T,tlt,LT>::Iterator::operator != (const BTreeMap<KEY,T,tlt,LT>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("BTreeMap::Iterator::operator !=");
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("BTreeMap::Iterator::operator !=");
+  if (ref_map != rhsASI->ref_map)
+    throw ComparingDifferentIteratorsError("BTreeMap::Iterator::operator !=");
+
+  return current.first != rhsASI->current.first || current.second != rhsASI->current.second;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+pair<KEY,T>& BTreeMap<KEY,T,tlt,LT>::Iterator::operator *() const {
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("BTreeMap::Iterator::operator *");
+  if (!can_erase || current.first == nullptr)
+    throw IteratorPositionIllegal("BTreeMap::Iterator::operator * Iterator illegal: exhausted");
+
+  return current.first->values[current.second];
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+pair<KEY,T>* BTreeMap<KEY,T,tlt,LT>::Iterator::operator ->() const {
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("BTreeMap::Iterator::operator ->");
+  if (!can_erase || current.first == nullptr)
+    throw IteratorPositionIllegal("BTreeMap::Iterator::operator -> Iterator illegal: exhausted");
+
+  return &current.first->values[current.second];
+}
+
+
+}
+
+#endif /* B_TREE_MAP_HPP_ */
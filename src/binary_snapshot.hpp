@@ -0,0 +1,624 @@
+#ifndef BINARY_SNAPSHOT_HPP_
+#define BINARY_SNAPSHOT_HPP_
+
+#include <string>
+#include <iostream>
+#include <vector>
+#include <algorithm>            //For std::max/std::min
+#include <cstdint>              //For std::uint8_t/std::uint32_t/std::uint64_t/std::int64_t
+#include <cstring>              //For std::memcpy/std::memcmp
+#include <type_traits>          //For std::is_integral/std::is_signed/std::is_trivially_copyable/std::enable_if
+#include <utility>              //For std::declval
+#include "ics_exceptions.hpp"
+#include "pair.hpp"
+
+
+namespace ics {
+
+
+//A compact binary alternative to operator << (which writes text that nothing
+//  parses) for saving containers and restoring them:
+//  SnapshotWriter w(out_stream);  save_container(w, m1);  save_container(w, s2);  w.finish();
+//  SnapshotReader r(in_stream);   load_container(r, m1);  load_container(r, s2);  r.finish();
+//Both stream through a fixed-size buffer (buffer_bytes), so saving or loading a
+//  container never builds a second copy of it in memory.
+//A snapshot is a header (magic, version, flags, byte order), then for each
+//  container its element count (a varint) followed by its elements, then (if
+//  checksummed) the CRC-32C of everything before it; finish on the reader
+//  raises IcsError if it does not match.
+//Elements are written by Snapshot<V> (below): integers as (zigzag) varints, so
+//  small values take a byte or two; std::string as a varint length and its
+//  characters; pair as its two parts; other trivially copyable types as their
+//  bytes. Specialize Snapshot<V> (save/load) for any other element type.
+class SnapshotWriter {
+  public:
+    //Destructor/Constructors
+    ~SnapshotWriter();
+    explicit SnapshotWriter (std::ostream& out, bool checksum = true, int buffer_bytes = 1 << 16);
+    SnapshotWriter          (const SnapshotWriter& to_copy) = delete;
+    SnapshotWriter& operator = (const SnapshotWriter& rhs) = delete;
+
+
+    //Queries
+    bool checksummed () const;
+    long bytes       () const;   //Written so far (including what is still buffered)
+
+
+    //Commands
+    void write_bytes  (const void* data, long bytes);
+    void write_varint (std::uint64_t value);
+    template<class V>
+    void write        (const V& value);    //By Snapshot<V>::save
+    void finish       ();                  //Write the checksum (if any) and flush; call once, after the last write
+
+
+  private:
+    std::ostream& out;
+    char*         buffer;
+    int           capacity;
+    int           used     = 0;
+    long          flushed  = 0;          //Bytes already written to out
+    bool          with_checksum;
+    std::uint32_t crc      = 0;          //CRC-32C of the bytes flushed so far
+    bool          finished = false;
+
+    //Helper methods
+    void flush ();                       //Write buffer to out (updating crc) and empty it
+};
+
+
+class SnapshotReader {
+  public:
+    //Destructor/Constructors
+    ~SnapshotReader();
+    explicit SnapshotReader (std::istream& in, int buffer_bytes = 1 << 16);  //Reads and checks the header
+    SnapshotReader          (const SnapshotReader& to_copy) = delete;
+    SnapshotReader& operator = (const SnapshotReader& rhs) = delete;
+
+
+    //Queries
+    bool checksummed () const;
+    long bytes       () const;   //Read so far (not counting what is buffered but unread)
+
+
+    //Commands
+    void          read_bytes  (void* into, long bytes);  //Raises IcsError if the snapshot ends first
+    std::uint64_t read_varint ();
+    template<class V>
+    V             read        ();                        //By Snapshot<V>::load
+    void          finish      ();                        //Read and check the checksum (if any)
+
+
+  private:
+    std::istream& in;
+    char*         buffer;
+    int           capacity;
+    int           position  = 0;         //Next unread byte in buffer
+    int           end       = 0;         //Bytes in buffer
+    int           checked   = 0;         //buffer[0,checked) is included in crc
+    long          discarded = 0;         //Bytes read (and consumed) before buffer's contents
+    bool          with_checksum;
+    bool          in_trailer = false;    //Reading the checksum itself (not included in crc)
+    std::uint32_t crc       = 0;
+
+    //Helper methods
+    void check_consumed ();              //Include buffer[checked,position) in crc
+    bool refill         ();              //Replace the (consumed) buffer by the next block; false at end of stream
+};
+
+
+//Update crc (initially 0) with data's bytes: CRC-32C (Castagnoli), computed 8 bytes at a time
+std::uint32_t crc32c (std::uint32_t crc, const void* data, long bytes);
+
+
+//How an element of type V is written/read: trivially copyable types (that are
+//  not integers) as their bytes
+template<class V, class Enable = void> class Snapshot {
+  public:
+    static_assert(std::is_trivially_copyable<V>::value, "Snapshot: specialize Snapshot<V> (save/load) for this type");
+
+    static void save (SnapshotWriter& out, const V& value) {out.write_bytes(&value, sizeof(V));}
+    static V    load (SnapshotReader& in)                   {V value; in.read_bytes(&value, sizeof(V)); return value;}
+};
+
+
+//Integers (and bool/char) as varints; signed ones zigzagged first (0,-1,1,-2,... -> 0,1,2,3,...)
+template<class V> class Snapshot<V, typename std::enable_if<std::is_integral<V>::value>::type> {
+  public:
+    static void save (SnapshotWriter& out, const V& value) {
+      if (std::is_signed<V>::value) {
+        std::int64_t v = value;
+        out.write_varint((std::uint64_t(v) << 1) ^ std::uint64_t(v >> 63));
+      }else
+        out.write_varint(std::uint64_t(value));
+    }
+    static V load (SnapshotReader& in) {
+      std::uint64_t u = in.read_varint();
+      if (std::is_signed<V>::value)
+        return static_cast<V>(std::int64_t(u >> 1) ^ -std::int64_t(u & 1));
+      return static_cast<V>(u);
+    }
+};
+
+
+template<> class Snapshot<std::string> {
+  public:
+    static void save (SnapshotWriter& out, const std::string& value) {
+      out.write_varint(value.size());
+      out.write_bytes(value.data(), value.size());
+    }
+    //A corrupt length must raise IcsError (truncated), not allocate it all up
+    //  front: grow value a chunk at a time as its bytes are actually read
+    static std::string load (SnapshotReader& in) {
+      std::uint64_t length = in.read_varint();
+      std::string   value;
+      if (length > value.max_size())
+        throw IcsError("Snapshot<std::string>::load: string too long (corrupt snapshot)");
+      value.reserve(std::min(length, std::uint64_t(chunk)));
+      while (value.size() < length) {
+        std::size_t done = value.size();
+        value.resize(done + std::min(length-done, std::uint64_t(chunk)));
+        in.read_bytes(&value[done], value.size()-done);
+      }
+      return value;
+    }
+
+  private:
+    static const long chunk = 1 << 20;
+};
+
+
+template<class A, class B> class Snapshot<pair<A,B>> {
+  public:
+    static void save (SnapshotWriter& out, const pair<A,B>& value) {
+      Snapshot<A>::save(out, value.first);
+      Snapshot<B>::save(out, value.second);
+    }
+    static pair<A,B> load (SnapshotReader& in) {
+      A first = Snapshot<A>::load(in);                   //Named, so first is read before second
+      return pair<A,B>(first, Snapshot<B>::load(in));
+    }
+};
+
+
+//Save c's size, then its elements (in iteration order); c must support
+//  .size() and "for-each" loops, and must not change while it is saved
+template<class Container>
+void save_container (SnapshotWriter& out, const Container& c);
+
+//Clear c, then add the elements of a container saved by save_container: by
+//  put (maps: elements are pairs), insert (sets) or enqueue (queues and
+//  priority queues), so queues/insertion-ordered sets keep their order.
+//A map with join/rebalance (BSTMap, PersistentBSTMap) arrives in key order,
+//  which would build a BSTMap vine (or rotate a PersistentBSTMap at every
+//  put): instead, each chunk of snapshot_chunk entries is put (middle first)
+//  into a balanced map that is joined onto c, and c is rebalanced at the end.
+template<class Container>
+void load_container (SnapshotReader& in, Container& c);
+
+//Save a HashGraph's nodes (so isolated nodes survive), then its edges/values
+template<class T> class HashGraph;
+template<class T>
+void save_container (SnapshotWriter& out, const HashGraph<T>& g);
+template<class T>
+void load_container (SnapshotReader& in, HashGraph<T>& g);
+
+//A whole snapshot of one container
+template<class Container>
+void save_snapshot (std::ostream& out, const Container& c, bool checksum = true);
+template<class Container>
+void load_snapshot (std::istream& in, Container& c);
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//SnapshotWriter class and related definitions
+
+//Destructor/Constructors
+
+//Without finish, the snapshot is incomplete (and buffered bytes are lost)
+inline SnapshotWriter::~SnapshotWriter() {
+  delete[] buffer;
+}
+
+
+//Header: magic (7 bytes), version (1), flags (bit 0: checksummed), byte order
+//  (trivially copyable elements are written in the writer's byte order)
+inline SnapshotWriter::SnapshotWriter(std::ostream& out, bool checksum, int buffer_bytes)
+: out(out), capacity(std::max(buffer_bytes, 64)), with_checksum(checksum) {
+  buffer = new char[capacity];
+  char          flags      = checksum ? 1 : 0;
+  std::uint32_t byte_order = 0x01020304;
+  write_bytes("ICSSNAP\1", 8);
+  write_bytes(&flags, 1);
+  write_bytes(&byte_order, sizeof(byte_order));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+inline bool SnapshotWriter::checksummed() const {
+  return with_checksum;
+}
+
+
+inline long SnapshotWriter::bytes() const {
+  return flushed + used;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+//Writes too big for the buffer go straight to out
+inline void SnapshotWriter::write_bytes(const void* data, long bytes) {
+  if (finished)
+    throw IcsError("SnapshotWriter::write_bytes: already finished");
+  if (bytes > capacity - used) {
+    flush();
+    if (bytes >= capacity) {
+      if (with_checksum)
+        crc = crc32c(crc, data, bytes);
+      if (!out.write(static_cast<const char*>(data), bytes))
+        throw IcsError("SnapshotWriter::write_bytes: write failed");
+      flushed += bytes;
+      return;
+    }
+  }
+  std::memcpy(buffer+used, data, bytes);
+  used += bytes;
+}
+
+
+//7 bits per byte, low bits first; the high bit is set in all but the last byte
+inline void SnapshotWriter::write_varint(std::uint64_t value) {
+  if (finished)
+    throw IcsError("SnapshotWriter::write_varint: already finished");
+  if (capacity - used < 10)
+    flush();
+  for (; value >= 0x80; value >>= 7)
+    buffer[used++] = char(value | 0x80);
+  buffer[used++] = char(value);
+}
+
+
+template<class V>
+void SnapshotWriter::write(const V& value) {
+  Snapshot<V>::save(*this, value);
+}
+
+
+inline void SnapshotWriter::finish() {
+  if (finished)
+    throw IcsError("SnapshotWriter::finish: already finished");
+  flush();
+  finished = true;
+  if (with_checksum && !out.write(reinterpret_cast<const char*>(&crc), sizeof(crc)))
+    throw IcsError("SnapshotWriter::finish: write failed");
+  flushed += with_checksum ? sizeof(crc) : 0;
+  if (!out.flush())
+    throw IcsError("SnapshotWriter::finish: flush failed");
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+inline void SnapshotWriter::flush() {
+  if (used == 0)
+    return;
+  if (with_checksum)
+    crc = crc32c(crc, buffer, used);
+  if (!out.write(buffer, used))
+    throw IcsError("SnapshotWriter::flush: write failed");
+  flushed += used;
+  used = 0;
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//SnapshotReader class and related definitions
+
+//Destructor/Constructors
+
+inline SnapshotReader::~SnapshotReader() {
+  delete[] buffer;
+}
+
+
+inline SnapshotReader::SnapshotReader(std::istream& in, int buffer_bytes)
+: in(in), capacity(std::max(buffer_bytes, 64)), with_checksum(false) {
+  buffer = new char[capacity];
+
+  char          magic[8];
+  char          flags;
+  std::uint32_t byte_order;
+  read_bytes(magic, sizeof(magic));
+  if (std::memcmp(magic, "ICSSNAP\1", 8) != 0)
+    throw IcsError("SnapshotReader::constructor: not a snapshot (or a different version)");
+  read_bytes(&flags, 1);
+  read_bytes(&byte_order, sizeof(byte_order));
+  if (byte_order != 0x01020304)
+    throw IcsError("SnapshotReader::constructor: snapshot written with a different byte order");
+  with_checksum = (flags & 1) != 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+inline bool SnapshotReader::checksummed() const {
+  return with_checksum;
+}
+
+
+inline long SnapshotReader::bytes() const {
+  return discarded + position;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+//Reads too big for the buffer go straight into into (once the buffer is used up)
+inline void SnapshotReader::read_bytes(void* into, long bytes) {
+  char* to = static_cast<char*>(into);
+  while (bytes > 0) {
+    if (position == end) {
+      if (bytes >= capacity) {
+        check_consumed();
+        if (!in.read(to, bytes))
+          throw IcsError("SnapshotReader::read_bytes: snapshot truncated");
+        if (with_checksum && !in_trailer)
+          crc = crc32c(crc, to, bytes);
+        discarded += bytes;
+        return;
+      }
+      if (!refill())
+        throw IcsError("SnapshotReader::read_bytes: snapshot truncated");
+    }
+    long part = std::min(bytes, long(end - position));
+    std::memcpy(to, buffer+position, part);
+    position += part;
+    to       += part;
+    bytes    -= part;
+  }
+}
+
+
+inline std::uint64_t SnapshotReader::read_varint() {
+  std::uint64_t value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (position == end && !refill())
+      throw IcsError("SnapshotReader::read_varint: snapshot truncated");
+    std::uint8_t b = buffer[position++];
+    value |= std::uint64_t(b & 0x7f) << shift;
+    if (b < 0x80)
+      return value;
+  }
+  throw IcsError("SnapshotReader::read_varint: varint too long (corrupt snapshot)");
+}
+
+
+template<class V>
+V SnapshotReader::read() {
+  return Snapshot<V>::load(*this);
+}
+
+
+inline void SnapshotReader::finish() {
+  if (!with_checksum)
+    return;
+  check_consumed();
+  std::uint32_t expected = crc, stored;
+  in_trailer = true;
+  read_bytes(&stored, sizeof(stored));
+  if (stored != expected)
+    throw IcsError("SnapshotReader::finish: checksum mismatch (corrupt snapshot)");
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+inline void SnapshotReader::check_consumed() {
+  if (with_checksum && !in_trailer && checked < position)
+    crc = crc32c(crc, buffer+checked, position-checked);
+  checked = position;
+}
+
+
+inline bool SnapshotReader::refill() {
+  check_consumed();
+  discarded += end;
+  in.read(buffer, capacity);
+  position = checked = 0;
+  end = in.gcount();
+  return end > 0;
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//CRC-32C
+
+//table[0] is the usual byte-at-a-time table; table[k][b] is the CRC of byte b
+//  followed by k zero bytes, so 8 lookups process 8 bytes ("slicing by 8")
+inline std::uint32_t crc32c(std::uint32_t crc, const void* data, long bytes) {
+  struct Table {
+    std::uint32_t t[8][256];
+    Table() {
+      for (std::uint32_t b=0; b<256; ++b) {
+        std::uint32_t c = b;
+        for (int k=0; k<8; ++k)
+          c = (c >> 1) ^ (0x82f63b78U & -(c & 1));
+        t[0][b] = c;
+      }
+      for (int k=1; k<8; ++k)
+        for (int b=0; b<256; ++b)
+          t[k][b] = (t[k-1][b] >> 8) ^ t[0][t[k-1][b] & 0xff];
+    }
+  };
+  static const Table table;
+  static const std::uint32_t one = 1;
+  static const bool          little_endian = *reinterpret_cast<const std::uint8_t*>(&one) == 1;
+  const std::uint32_t (&t)[8][256] = table.t;
+
+  const std::uint8_t* p = static_cast<const std::uint8_t*>(data);
+  crc = ~crc;
+  if (little_endian)
+    for (; bytes >= 8; p += 8, bytes -= 8) {
+      std::uint32_t low, high;
+      std::memcpy(&low,  p,   4);
+      std::memcpy(&high, p+4, 4);
+      low ^= crc;
+      crc = t[7][low & 0xff]  ^ t[6][(low >> 8) & 0xff]  ^ t[5][(low >> 16) & 0xff]  ^ t[4][low >> 24] ^
+            t[3][high & 0xff] ^ t[2][(high >> 8) & 0xff] ^ t[1][(high >> 16) & 0xff] ^ t[0][high >> 24];
+    }
+  for (; bytes > 0; ++p, --bytes)
+    crc = t[0][(crc ^ *p) & 0xff] ^ (crc >> 8);
+  return ~crc;
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Saving and loading containers
+
+//Overloads choosing how load_container adds an element e to c: the int
+//  parameter prefers put (maps) to insert (sets) to enqueue (queues); the
+//  unused (decltype) parameter removes an overload if c lacks the member
+template<class Container, class E>
+auto snapshot_add (Container& c, const E& e, int) -> decltype(c.put(e.first, e.second), void()) {
+  c.put(e.first, e.second);
+}
+
+template<class Container, class E>
+auto snapshot_add (Container& c, const E& e, long) -> decltype(c.insert(e), void()) {
+  c.insert(e);
+}
+
+template<class Container, class E>
+auto snapshot_add (Container& c, const E& e, ...) -> decltype(c.enqueue(e), void()) {
+  c.enqueue(e);
+}
+
+
+//Put chunk[low,high) into c, middle first, so c is balanced
+template<class Container, class E>
+void snapshot_put_middle_first (Container& c, const std::vector<E>& chunk, int low, int high) {
+  if (low >= high)
+    return;
+  int middle = low + (high-low)/2;
+  c.put(chunk[middle].first, chunk[middle].second);
+  snapshot_put_middle_first(c, chunk, low, middle);
+  snapshot_put_middle_first(c, chunk, middle+1, high);
+}
+
+
+static const int snapshot_chunk = 4096;
+
+//Overloads choosing how load_container adds n elements of type E to (empty) c
+template<class Container, class E>
+auto snapshot_add_all (SnapshotReader& in, Container& c, std::uint64_t n, int) -> decltype(c.join(c), c.rebalance(), void()) {
+  Container      empty(c);          //c is empty: copies only its ordering
+  std::vector<E> chunk;
+  chunk.reserve(std::min(n, std::uint64_t(snapshot_chunk)));
+  while (n > 0) {
+    chunk.clear();
+    for (; n > 0 && chunk.size() < std::size_t(snapshot_chunk); --n)
+      chunk.push_back(in.read<E>());
+    Container part(empty);
+    snapshot_put_middle_first(part, chunk, 0, chunk.size());
+    c.join(part);
+  }
+  c.rebalance();
+}
+
+template<class Container, class E>
+void snapshot_add_all (SnapshotReader& in, Container& c, std::uint64_t n, long) {
+  for (; n > 0; --n)
+    snapshot_add(c, in.read<E>(), 0);
+}
+
+
+template<class Container>
+void save_container (SnapshotWriter& out, const Container& c) {
+  out.write_varint(c.size());
+  std::uint64_t written = 0;
+  for (const auto& e : c) {
+    out.write(e);
+    ++written;
+  }
+  if (written != std::uint64_t(c.size()))
+    throw IcsError("save_container: container changed while it was saved");
+}
+
+
+template<class Container>
+void load_container (SnapshotReader& in, Container& c) {
+  typedef typename std::decay<decltype(*std::declval<const Container&>().begin())>::type E;
+  c.clear();
+  snapshot_add_all<Container,E>(in, c, in.read_varint(), 0);
+}
+
+
+template<class T>
+void save_container (SnapshotWriter& out, const HashGraph<T>& g) {
+  out.write_varint(g.node_count());
+  for (const auto& n : g.all_nodes())
+    out.write(n.first);
+  out.write_varint(g.edge_count());
+  for (const auto& e : g.all_edges())
+    out.write(e);
+}
+
+
+template<class T>
+void load_container (SnapshotReader& in, HashGraph<T>& g) {
+  typedef typename HashGraph<T>::EdgeMapEntry EdgeMapEntry;
+  g.clear();
+  for (std::uint64_t n = in.read_varint(); n > 0; --n)
+    g.add_node(in.read<std::string>());
+  for (std::uint64_t n = in.read_varint(); n > 0; --n) {
+    EdgeMapEntry e = in.read<EdgeMapEntry>();
+    g.add_edge(e.first.first, e.first.second, e.second);
+  }
+}
+
+
+template<class Container>
+void save_snapshot (std::ostream& out, const Container& c, bool checksum) {
+  SnapshotWriter writer(out, checksum);
+  save_container(writer, c);
+  writer.finish();
+}
+
+
+template<class Container>
+void load_snapshot (std::istream& in, Container& c) {
+  SnapshotReader reader(in);
+  load_container(reader, c);
+  reader.finish();
+}
+
+
+}
+
+#endif /* BINARY_SNAPSHOT_HPP_ */
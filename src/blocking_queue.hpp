@@ -0,0 +1,415 @@
+#ifndef BLOCKING_QUEUE_HPP_
+#define BLOCKING_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "ics_exceptions.hpp"
+#include "linked_queue.hpp"
+
+//co_await q.pop() needs C++20 coroutines; define ICS_NO_COROUTINES to omit it
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && !defined(ICS_NO_COROUTINES)
+#define ICS_BLOCKING_QUEUE_COROUTINES
+#include <coroutine>
+#include <optional>
+#endif
+
+
+namespace ics {
+
+
+//A LinkedQueue that many threads can use at once (every operation holds one
+//  mutex), whose consumers can wait for values instead of spinning on empty:
+//  wait_dequeue blocks until a value arrives (wait_dequeue_for/until give up
+//  after a timeout), and dequeue_bulk waits for one value, then takes up to n.
+//close() ends the queue's input: later enqueues are ignored (returning 0), and
+//  once the values already enqueued are dequeued (or drained), waiting
+//  dequeues return false/0 instead of blocking. dequeue/try_dequeue never wait.
+//With C++20 coroutines, a coroutine can co_await q.pop(): it is suspended until
+//  a value arrives, then resumed (by the enqueueing thread) with that value, or
+//  with an empty std::optional if the queue is closed.
+template<class T> class BlockingQueue {
+  public:
+    //Destructor/Constructors
+    ~BlockingQueue();
+
+    BlockingQueue          ();
+    explicit BlockingQueue (const std::initializer_list<T>& il);
+    BlockingQueue          (const BlockingQueue<T>& to_copy) = delete;
+    BlockingQueue<T>& operator = (const BlockingQueue<T>& rhs) = delete;
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit BlockingQueue (const Iterable& i);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    bool closed     () const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    int  enqueue      (const T& element);   //Returns 0 (ignoring element) if closed
+    T    dequeue      ();                   //Raises EmptyError if empty: does not wait
+    bool try_dequeue  (T& into);
+    bool wait_dequeue (T& into);            //Waits until a value (true) or closed and empty (false)
+    template <class Rep, class Period>
+    bool wait_dequeue_for   (T& into, const std::chrono::duration<Rep,Period>& timeout);
+    template <class Clock, class Duration>
+    bool wait_dequeue_until (T& into, const std::chrono::time_point<Clock,Duration>& deadline);
+    int  dequeue_bulk (int n, LinkedQueue<T>& into); //Waits like wait_dequeue, then dequeues up to n; return #
+    int  drain        (LinkedQueue<T>& into);        //Dequeue every value now; return #
+    void close        ();
+    void clear        ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    //Enqueues all values atomically (unless closed: then returns 0); suspended
+    //  coroutines given values are resumed, in order, only after the whole batch
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+
+#ifdef ICS_BLOCKING_QUEUE_COROUTINES
+    class PopAwaiter {
+      public:
+        bool             await_ready   ();
+        bool             await_suspend (std::coroutine_handle<> waiting);
+        std::optional<T> await_resume  ();
+
+        friend class BlockingQueue<T>;
+      private:
+        PopAwaiter(BlockingQueue<T>* ref_queue) : ref_queue(ref_queue) {}
+
+        BlockingQueue<T>*       ref_queue;
+        std::optional<T>        value;       //Filled by await_ready, or by enqueue before resuming
+        std::coroutine_handle<> handle;
+    };
+
+    PopAwaiter pop ();                       //co_await q.pop(): the next value, or empty if closed
+#endif
+
+
+    //Operators
+    template<class T2>
+    friend std::ostream& operator << (std::ostream& outs, const BlockingQueue<T2>& q);
+
+
+  private:
+    mutable std::mutex      lock;            //Protects all the data members below
+    std::condition_variable not_empty;       //Notified when a value is enqueued or the queue is closed
+    LinkedQueue<T>          values;
+    bool                    is_closed = false;
+#ifdef ICS_BLOCKING_QUEUE_COROUTINES
+    LinkedQueue<PopAwaiter*> suspended;      //Coroutines waiting (in order) for values; only when values is empty
+#endif
+
+    //Helper methods
+    int hand_off (const T& element, std::unique_lock<std::mutex>& held); //Enqueue element (or resume a coroutine with it); unlocks held
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//BlockingQueue class and related definitions
+
+//Destructor/Constructors
+
+//No thread may be waiting (nor coroutine suspended) when the queue is destroyed
+template<class T>
+BlockingQueue<T>::~BlockingQueue()
+{}
+
+
+template<class T>
+BlockingQueue<T>::BlockingQueue()
+{}
+
+
+template<class T>
+BlockingQueue<T>::BlockingQueue(const std::initializer_list<T>& il)
+: values(il)
+{}
+
+
+template<class T>
+template<class Iterable>
+BlockingQueue<T>::BlockingQueue(const Iterable& i)
+: values(i)
+{}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T>
+bool BlockingQueue<T>::empty() const {
+  std::lock_guard<std::mutex> hold(lock);
+  return values.empty();
+}
+
+
+template<class T>
+int BlockingQueue<T>::size() const {
+  std::lock_guard<std::mutex> hold(lock);
+  return values.size();
+}
+
+
+template<class T>
+bool BlockingQueue<T>::closed() const {
+  std::lock_guard<std::mutex> hold(lock);
+  return is_closed;
+}
+
+
+template<class T>
+std::string BlockingQueue<T>::str() const {
+  std::lock_guard<std::mutex> hold(lock);
+  std::ostringstream answer;
+  answer << "blocking_queue[" << values.str() << "](closed=" << is_closed;
+#ifdef ICS_BLOCKING_QUEUE_COROUTINES
+  answer << ",suspended=" << suspended.size();
+#endif
+  answer << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T>
+int BlockingQueue<T>::enqueue(const T& element) {
+  std::unique_lock<std::mutex> hold(lock);
+  if (is_closed)
+    return 0;
+  return hand_off(element, hold);
+}
+
+
+template<class T>
+T BlockingQueue<T>::dequeue() {
+  std::lock_guard<std::mutex> hold(lock);
+  if (values.empty())
+    throw EmptyError("BlockingQueue::dequeue");
+  return values.dequeue();
+}
+
+
+template<class T>
+bool BlockingQueue<T>::try_dequeue(T& into) {
+  std::lock_guard<std::mutex> hold(lock);
+  if (values.empty())
+    return false;
+  into = values.dequeue();
+  return true;
+}
+
+
+template<class T>
+bool BlockingQueue<T>::wait_dequeue(T& into) {
+  std::unique_lock<std::mutex> hold(lock);
+  not_empty.wait(hold, [this]{return !values.empty() || is_closed;});
+  if (values.empty())
+    return false;
+  into = values.dequeue();
+  return true;
+}
+
+
+template<class T>
+template<class Rep, class Period>
+bool BlockingQueue<T>::wait_dequeue_for(T& into, const std::chrono::duration<Rep,Period>& timeout) {
+  return wait_dequeue_until(into, std::chrono::steady_clock::now() + timeout);
+}
+
+
+template<class T>
+template<class Clock, class Duration>
+bool BlockingQueue<T>::wait_dequeue_until(T& into, const std::chrono::time_point<Clock,Duration>& deadline) {
+  std::unique_lock<std::mutex> hold(lock);
+  if (!not_empty.wait_until(hold, deadline, [this]{return !values.empty() || is_closed;}))
+    return false;
+  if (values.empty())
+    return false;
+  into = values.dequeue();
+  return true;
+}
+
+
+template<class T>
+int BlockingQueue<T>::dequeue_bulk(int n, LinkedQueue<T>& into) {
+  std::unique_lock<std::mutex> hold(lock);
+  not_empty.wait(hold, [this]{return !values.empty() || is_closed;});
+  int count = 0;
+  for (; count < n && !values.empty(); ++count)
+    into.enqueue(values.dequeue());
+  return count;
+}
+
+
+template<class T>
+int BlockingQueue<T>::drain(LinkedQueue<T>& into) {
+  std::lock_guard<std::mutex> hold(lock);
+  int count = 0;
+  for (; !values.empty(); ++count)
+    into.enqueue(values.dequeue());
+  return count;
+}
+
+
+//Wakes every waiting thread, and resumes every suspended coroutine (with no
+//  value: only an empty queue has suspended coroutines) in this thread
+template<class T>
+void BlockingQueue<T>::close() {
+  std::unique_lock<std::mutex> hold(lock);
+  is_closed = true;
+#ifdef ICS_BLOCKING_QUEUE_COROUTINES
+  LinkedQueue<PopAwaiter*> to_resume;
+  while (!suspended.empty())
+    to_resume.enqueue(suspended.dequeue());
+#endif
+  hold.unlock();
+  not_empty.notify_all();
+#ifdef ICS_BLOCKING_QUEUE_COROUTINES
+  while (!to_resume.empty())
+    to_resume.dequeue()->handle.resume();
+#endif
+}
+
+
+template<class T>
+void BlockingQueue<T>::clear() {
+  std::lock_guard<std::mutex> hold(lock);
+  values.clear();
+}
+
+
+template<class T>
+template<class Iterable>
+int BlockingQueue<T>::enqueue_all(const Iterable& i) {
+  std::unique_lock<std::mutex> hold(lock);
+  if (is_closed)
+    return 0;
+
+  int count = 0;
+#ifdef ICS_BLOCKING_QUEUE_COROUTINES
+  LinkedQueue<PopAwaiter*> to_resume;     //Given their values under the lock; resumed after unlocking
+#endif
+  for (const T& v : i) {
+#ifdef ICS_BLOCKING_QUEUE_COROUTINES
+    if (!suspended.empty()) {
+      PopAwaiter* waiting = suspended.dequeue();
+      waiting->value.emplace(v);
+      to_resume.enqueue(waiting);
+      ++count;
+      continue;
+    }
+#endif
+    count += values.enqueue(v);
+  }
+  hold.unlock();
+  not_empty.notify_all();
+#ifdef ICS_BLOCKING_QUEUE_COROUTINES
+  while (!to_resume.empty())
+    to_resume.dequeue()->handle.resume();
+#endif
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Coroutine adapter
+
+#ifdef ICS_BLOCKING_QUEUE_COROUTINES
+template<class T>
+auto BlockingQueue<T>::pop() -> PopAwaiter {
+  return PopAwaiter(this);
+}
+
+
+//Does not suspend if a value is ready (or the queue is closed)
+template<class T>
+bool BlockingQueue<T>::PopAwaiter::await_ready() {
+  std::lock_guard<std::mutex> hold(ref_queue->lock);
+  if (!ref_queue->values.empty())
+    value.emplace(ref_queue->values.dequeue());
+  return value.has_value() || ref_queue->is_closed;
+}
+
+
+//Re-checks under the lock (a value may have arrived since await_ready):
+//  returning false resumes the coroutine at once
+template<class T>
+bool BlockingQueue<T>::PopAwaiter::await_suspend(std::coroutine_handle<> waiting) {
+  std::lock_guard<std::mutex> hold(ref_queue->lock);
+  if (!ref_queue->values.empty()) {
+    value.emplace(ref_queue->values.dequeue());
+    return false;
+  }
+  if (ref_queue->is_closed)
+    return false;
+  handle = waiting;
+  ref_queue->suspended.enqueue(this);
+  return true;
+}
+
+
+template<class T>
+std::optional<T> BlockingQueue<T>::PopAwaiter::await_resume() {
+  return std::move(value);
+}
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T>
+std::ostream& operator << (std::ostream& outs, const BlockingQueue<T>& q) {
+  std::lock_guard<std::mutex> hold(q.lock);
+  outs << q.values;
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+//A suspended coroutine exists only while values is empty, so giving it element
+//  keeps FIFO order; it is resumed after unlocking, as it may use the queue
+template<class T>
+int BlockingQueue<T>::hand_off(const T& element, std::unique_lock<std::mutex>& held) {
+#ifdef ICS_BLOCKING_QUEUE_COROUTINES
+  if (!suspended.empty()) {
+    PopAwaiter* waiting = suspended.dequeue();
+    waiting->value.emplace(element);
+    held.unlock();
+    waiting->handle.resume();
+    return 1;
+  }
+#endif
+  values.enqueue(element);
+  held.unlock();
+  not_empty.notify_one();
+  return 1;
+}
+
+
+}
+
+#endif /* BLOCKING_QUEUE_HPP_ */
@@ -0,0 +1,232 @@
+#ifndef BLOOM_FILTER_HPP_
+#define BLOOM_FILTER_HPP_
+
+#include <string>
+#include <sstream>
+#include <algorithm>            //For std::max/std::min
+#include <cmath>                //For std::log2/std::ceil
+#include <cstdint>              //For std::uint32_t/std::uint64_t/std::uintptr_t
+#include <cstring>              //For std::memset/std::memcpy
+#include "ics_exceptions.hpp"
+
+
+namespace ics {
+
+
+//An approximate membership filter over hash values: might_contain(h) is false
+//  only if add(h) was never called (since the last clear); it is true for
+//  about false_positive_rate of the other values (when at most expected values
+//  were added).
+//It is a "blocked" Bloom filter: each hash value selects one 32-byte block
+//  (half a cache line) and sets/tests 8 bits in it, one in each 32-bit word,
+//  so each add or test touches one cache line. The hash values (typically from
+//  a container's weak hash function) are mixed first, so similar values
+//  select unrelated blocks and bits.
+//max_bytes (if > 0) caps the filter's size; a capped filter has a higher
+//  false positive rate than requested.
+//Values cannot be removed: a container using this filter rebuilds it instead.
+class BloomFilter {
+  public:
+    //Destructor/Constructors
+    ~BloomFilter();
+    explicit BloomFilter (int expected = 0, double false_positive_rate = 0.01, long max_bytes = 0);
+    BloomFilter          (const BloomFilter& to_copy);
+    BloomFilter& operator = (const BloomFilter& rhs);
+
+
+    //Queries
+    bool   might_contain       (int hash) const;
+    int    added               () const;     //# of add calls since the last clear/resize
+    long   bytes               () const;
+    double false_positive_rate () const;     //The rate requested (not the rate achieved)
+    long   max_bytes           () const;
+    std::string str            () const;
+
+
+    //Commands
+    void add    (int hash);
+    void clear  ();
+    void resize (int expected);              //Size for expected values (with the same rate/cap) and clear
+
+
+  private:
+    static const int words_per_block = 8;    //8 32-bit words: 32 bytes
+    static const int cache_line      = 64;
+
+    char*          storage = nullptr;        //Allocated memory: blocks is aligned within it
+    std::uint32_t* blocks  = nullptr;        //block_count blocks of words_per_block words
+    long           block_count;
+    int            used    = 0;
+    double         rate;
+    long           cap;
+
+    //Helper methods
+    static std::uint64_t mix (int hash);     //A well-distributed 64-bit value from hash
+    static std::uint32_t bit (std::uint32_t key, int w);  //The bit (mask) key sets/tests in word w of its block
+    std::uint32_t* block_of  (std::uint64_t h) const;     //h's block: the high 32 bits of h scaled to [0,block_count)
+    void allocate (int expected);            //Set storage/blocks/block_count for expected values (all bits clear)
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//BloomFilter class and related definitions
+
+//Destructor/Constructors
+
+inline BloomFilter::~BloomFilter() {
+  ::operator delete(storage);
+}
+
+
+inline BloomFilter::BloomFilter(int expected, double false_positive_rate, long max_bytes)
+: rate(false_positive_rate), cap(max_bytes) {
+  if (false_positive_rate <= 0 || false_positive_rate >= 1)
+    throw IcsError("BloomFilter::constructor: false_positive_rate(" + std::to_string(false_positive_rate) + ") must be in (0,1)");
+  allocate(expected);
+}
+
+
+inline BloomFilter::BloomFilter(const BloomFilter& to_copy)
+: used(to_copy.used), rate(to_copy.rate), cap(to_copy.cap) {
+  allocate(0);
+  *this = to_copy;
+}
+
+
+inline BloomFilter& BloomFilter::operator = (const BloomFilter& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  if (block_count != rhs.block_count) {
+    ::operator delete(storage);
+    storage = static_cast<char*>(::operator new(rhs.block_count*words_per_block*sizeof(std::uint32_t) + cache_line));
+    std::uintptr_t first = (reinterpret_cast<std::uintptr_t>(storage) + cache_line-1) / cache_line * cache_line;
+    blocks      = reinterpret_cast<std::uint32_t*>(first);
+    block_count = rhs.block_count;
+  }
+  std::memcpy(blocks, rhs.blocks, block_count*words_per_block*sizeof(std::uint32_t));
+  used = rhs.used;
+  rate = rhs.rate;
+  cap  = rhs.cap;
+  return *this;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+inline bool BloomFilter::might_contain(int hash) const {
+  std::uint64_t        h     = mix(hash);
+  const std::uint32_t* block = block_of(h);
+  std::uint32_t        missing = 0;
+  for (int w=0; w<words_per_block; ++w)
+    missing |= bit(h,w) & ~block[w];
+  return missing == 0;
+}
+
+
+inline int BloomFilter::added() const {
+  return used;
+}
+
+
+inline long BloomFilter::bytes() const {
+  return block_count*words_per_block*sizeof(std::uint32_t);
+}
+
+
+inline double BloomFilter::false_positive_rate() const {
+  return rate;
+}
+
+
+inline long BloomFilter::max_bytes() const {
+  return cap;
+}
+
+
+inline std::string BloomFilter::str() const {
+  std::ostringstream answer;
+  answer << "BloomFilter(blocks=" << block_count << ",bytes=" << bytes() << ",added=" << used
+         << ",false_positive_rate=" << rate << ",max_bytes=" << cap << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+inline void BloomFilter::add(int hash) {
+  std::uint64_t  h     = mix(hash);
+  std::uint32_t* block = block_of(h);
+  for (int w=0; w<words_per_block; ++w)
+    block[w] |= bit(h,w);
+  ++used;
+}
+
+
+inline void BloomFilter::clear() {
+  std::memset(blocks, 0, bytes());
+  used = 0;
+}
+
+
+inline void BloomFilter::resize(int expected) {
+  ::operator delete(storage);
+  storage = nullptr;
+  allocate(expected);
+  used = 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+//The finalizer of splitmix64
+inline std::uint64_t BloomFilter::mix(int hash) {
+  std::uint64_t h = static_cast<std::uint32_t>(hash);
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  return h ^ (h >> 31);
+}
+
+
+//Multiplying by an odd salt (different for each word) and keeping the top 5
+//  bits picks one of the 32 bits in each word
+inline std::uint32_t BloomFilter::bit(std::uint32_t key, int w) {
+  static const std::uint32_t salt[words_per_block] =
+    {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+  return std::uint32_t(1) << ((key * salt[w]) >> 27);
+}
+
+
+inline std::uint32_t* BloomFilter::block_of(std::uint64_t h) const {
+  return blocks + ((h >> 32) * std::uint64_t(block_count) >> 32) * words_per_block;
+}
+
+
+//A classic Bloom filter needs -log2(rate)/ln(2) bits per value; blocking (and
+//  the fixed 8 bits per value) costs about 25% more for the same rate
+inline void BloomFilter::allocate(int expected) {
+  const long block_bits = words_per_block*32;
+  double bits_per_value = 1.25 * -std::log2(rate) / std::log(2.0);
+  block_count = std::max(1L, long(std::ceil(std::max(expected,1) * bits_per_value / block_bits)));
+  if (cap > 0)
+    block_count = std::max(1L, std::min(block_count, cap / (block_bits/8)));
+
+  storage = static_cast<char*>(::operator new(block_count*(block_bits/8) + cache_line));
+  std::uintptr_t first = (reinterpret_cast<std::uintptr_t>(storage) + cache_line-1) / cache_line * cache_line;
+  blocks = reinterpret_cast<std::uint32_t*>(first);
+  std::memset(blocks, 0, block_count*(block_bits/8));
+}
+
+
+}
+
+#endif /* BLOOM_FILTER_HPP_ */
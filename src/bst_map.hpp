@@ -11,8 +11,10 @@
 #include <sstream>
 #include <initializer_list>
 #include "ics_exceptions.hpp"
+#include "functor.hpp"
 #include "pair.hpp"
 #include "array_queue.hpp"   //For traversal
+#include "array_stack.hpp"   //For in-order walks (see equals)
 
 
 namespace ics {
@@ -21,7 +23,8 @@ namespace ics {
 //Instantiate such that tlt(a,b) is true, iff a is in the left subtree rooted by b
 //With a tlt specified in the template, the constructor cannot specify a clt.
 //If a tlt is defaulted, then the constructor must supply a clt (they cannot both be nullptr)
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr> class BSTMap {
+//Instead, LT can be a functor type whose LT()(a,b) is the ordering (then neither tlt nor clt is supplied)
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr, class LT = void> class BSTMap {
   public:
     typedef pair<KEY,T> Entry;
 
@@ -29,13 +32,18 @@ template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr> c
     ~BSTMap();
 
     BSTMap          (bool (*clt)(const KEY& a, const KEY& b) = nullptr);
-    BSTMap          (const BSTMap<KEY,T,tlt>& to_copy, bool (*clt)(const KEY& a, const KEY& b) = nullptr);
+    BSTMap          (const BSTMap<KEY,T,tlt,LT>& to_copy, bool (*clt)(const KEY& a, const KEY& b) = nullptr);
     explicit BSTMap (const std::initializer_list<Entry>& il, bool (*clt)(const KEY& a, const KEY& b) = nullptr);
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
     template <class Iterable>
     explicit BSTMap (const Iterable& i, bool (*clt)(const KEY& a, const KEY& b) = nullptr);
 
+    //Iterable must support "for-each" loop and produce its entries in strictly increasing key order (by lt);
+    //  builds a perfectly balanced tree in O(N), throwing KeyError if the entries are not in order
+    template <class Iterable>
+    static BSTMap<KEY,T,tlt,LT> from_sorted (const Iterable& i, bool (*clt)(const KEY& a, const KEY& b) = nullptr);
+
 
     //Queries
     bool empty      () const;
@@ -49,22 +57,33 @@ template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr> c
     T    put   (const KEY& key, const T& value);
     T    erase (const KEY& key);
     void clear ();
+    void rebalance ();  //Rebuild the tree in place (reusing its nodes) so it is perfectly balanced: O(N)
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
     template <class Iterable>
     int put_all(const Iterable& i);
 
+    //Set algebra on keys: O(N+M) merges of the two in-order sequences, leaving this tree balanced
+    int  merge      (const BSTMap<KEY,T,tlt,LT>& other);  //put all of other's entries; returns # keys added
+    int  intersect  (const BSTMap<KEY,T,tlt,LT>& other);  //erase keys not in other; returns # keys erased
+    int  difference (const BSTMap<KEY,T,tlt,LT>& other);  //erase keys in other; returns # keys erased
+
+    //Move entries with keys >= key into greater (replacing its entries); O(height + # moved)
+    void split (const KEY& key, BSTMap<KEY,T,tlt,LT>& greater);
+    //Move all of greater's entries (all keys must be > this map's keys) into this map; O(height)
+    void join  (BSTMap<KEY,T,tlt,LT>& greater);
+
 
     //Operators
 
     T&       operator [] (const KEY&);
     const T& operator [] (const KEY&) const;
-    BSTMap<KEY,T,tlt>& operator = (const BSTMap<KEY,T,tlt>& rhs);
-    bool operator == (const BSTMap<KEY,T,tlt>& rhs) const;
-    bool operator != (const BSTMap<KEY,T,tlt>& rhs) const;
+    BSTMap<KEY,T,tlt,LT>& operator = (const BSTMap<KEY,T,tlt,LT>& rhs);
+    bool operator == (const BSTMap<KEY,T,tlt,LT>& rhs) const;
+    bool operator != (const BSTMap<KEY,T,tlt,LT>& rhs) const;
 
-    template<class KEY2,class T2, bool (*lt2)(const KEY2& a, const KEY2& b)>
-    friend std::ostream& operator << (std::ostream& outs, const BSTMap<KEY2,T2,lt2>& m);
+    template<class KEY2,class T2, bool (*lt2)(const KEY2& a, const KEY2& b), class LT2>
+    friend std::ostream& operator << (std::ostream& outs, const BSTMap<KEY2,T2,lt2,LT2>& m);
 
 
 
@@ -74,28 +93,28 @@ template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr> c
         ~Iterator();
         Entry       erase();
         std::string str  () const;
-        BSTMap<KEY,T,tlt>::Iterator& operator ++ ();
-        BSTMap<KEY,T,tlt>::Iterator  operator ++ (int);
-        bool operator == (const BSTMap<KEY,T,tlt>::Iterator& rhs) const;
-        bool operator != (const BSTMap<KEY,T,tlt>::Iterator& rhs) const;
+        BSTMap<KEY,T,tlt,LT>::Iterator& operator ++ ();
+        BSTMap<KEY,T,tlt,LT>::Iterator  operator ++ (int);
+        bool operator == (const BSTMap<KEY,T,tlt,LT>::Iterator& rhs) const;
+        bool operator != (const BSTMap<KEY,T,tlt,LT>::Iterator& rhs) const;
         Entry& operator *  () const;
         Entry* operator -> () const;
-        friend std::ostream& operator << (std::ostream& outs, const BSTMap<KEY,T,tlt>::Iterator& i) {
+        friend std::ostream& operator << (std::ostream& outs, const BSTMap<KEY,T,tlt,LT>::Iterator& i) {
           outs << i.str(); //Use the same meaning as the debugging .str() method
           return outs;
         }
-        friend Iterator BSTMap<KEY,T,tlt>::begin () const;
-        friend Iterator BSTMap<KEY,T,tlt>::end   () const;
+        friend Iterator BSTMap<KEY,T,tlt,LT>::begin () const;
+        friend Iterator BSTMap<KEY,T,tlt,LT>::end   () const;
 
       private:
         //If can_erase is false, the value has been removed from "it" (++ does nothing)
-        ArrayQueue<Entry> it;                 //Queue for all associations (from begin), to use as iterator via dequeue
-        BSTMap<KEY,T,tlt>* ref_map;
-        int               expected_mod_count;
-        bool              can_erase = true;
+        ArrayQueue<Entry>     it;                 //Queue for all associations (from begin), to use as iterator via dequeue
+        BSTMap<KEY,T,tlt,LT>* ref_map;
+        int                   expected_mod_count;
+        bool                  can_erase = true;
 
         //Called in friends begin/end
-        Iterator(BSTMap<KEY,T,tlt>* iterate_over, bool from_begin);
+        Iterator(BSTMap<KEY,T,tlt,LT>* iterate_over, bool from_begin);
     };
 
 
@@ -116,24 +135,33 @@ template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr> c
         TN*   right;
     };
 
+  static_assert(std::is_void<LT>::value || tlt == nullptr, "BSTMap: specify tlt or LT, not both");
   bool (*lt) (const KEY& a, const KEY& b); // The lt used for searching BST (from template or constructor)
   TN* map       = nullptr;
   int used      = 0;                       //Cache for number of key->value pairs in the BST
   int mod_count = 0;                       //For sensing concurrent modification
 
   //Helper methods (find_key written iteratively, the rest recursively)
+  bool is_lt (const KEY& a, const KEY& b) const; //True iff a < b: via the functor type, tlt or lt (see functor.hpp)
   TN*   find_key            (TN*  root, const KEY& key)                 const; //Returns reference to key's node or nullptr
   bool  has_value           (TN*  root, const T& value)                 const; //Returns whether value is is root's tree
   TN*   copy                (TN*  root)                                 const; //Copy the keys/values in root's tree (identical structure)
+  void  push_left_spine     (TN*  root, ArrayStack<TN*>& pending)       const; //Push root and its chain of left children (in-order walk)
   void  copy_to_queue       (TN* root, ArrayQueue<Entry>& q)            const; //Fill queue with root's tree value
-  bool  equals              (TN*  root, const BSTMap<KEY,T,tlt>& other) const; //Returns whether root's keys/value are all in other
+  bool  equals              (TN*  root, const BSTMap<KEY,T,tlt,LT>& other) const; //Returns whether root's keys/value are all in other
   std::string string_rotated(TN* root, std::string indent)              const; //Returns string representing root's tree
 
   T     insert              (TN*& root, const KEY& key, const T& value);       //Put key->value, returning key's old value (or new one's, if key absent)
   T&    find_addempty       (TN*& root, const KEY& key);                       //Return reference to key's value (adding key->T() first, if key absent)
+  void  copy_into           (TN*& root, TN* from);                             //Make root's tree a copy of from's, reusing root's TN where shapes overlap
   Entry remove_closest      (TN*& root);                                       //Helper for remove
   T     remove              (TN*& root, const KEY& key);                       //Remove key->value from root's tree
   void  delete_BST          (TN*& root);                                       //Deallocate all TN in tree; root == nullptr
+  TN*   tree_to_vine        (TN*  root);                                       //Rotate root's tree into a list linked by right (in key order)
+  TN*   vine_to_tree        (TN*& vine, int n);                                //Build balanced tree from the first n TN in vine; advance vine past them
+  int   combine             (const BSTMap<KEY,T,tlt,LT>& other, bool keep_this_only,
+                             bool keep_common, bool add_other_only);           //Merge with other's keys (see merge); returns new size
+  void  split               (TN* root, const KEY& key, TN*& less, TN*& not_less); //Split root's tree by key
 };
 
 
@@ -145,45 +173,48 @@ template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr> c
 
 //Destructor/Constructors
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-BSTMap<KEY,T,tlt>::~BSTMap() {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BSTMap<KEY,T,tlt,LT>::~BSTMap() {
 	delete_BST(map);
 	map = nullptr;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-BSTMap<KEY,T,tlt>::BSTMap(bool (*clt)(const KEY& a, const KEY& b))
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BSTMap<KEY,T,tlt,LT>::BSTMap(bool (*clt)(const KEY& a, const KEY& b))
 	:lt(tlt != nullptr ? tlt : clt)
 {
-	if (lt == nullptr)
+	if (lt == nullptr && std::is_void<LT>::value)
 		throw TemplateFunctionError("BSTMap::default constructor: neither specified");
-	if (tlt != nullptr && clt != nullptr && tlt != clt)
+	if ((tlt != nullptr || !std::is_void<LT>::value) && clt != nullptr && tlt != clt)
 		throw TemplateFunctionError("HeapPriorityQueue::default constructor: both specified and different");
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-BSTMap<KEY,T,tlt>::BSTMap(const BSTMap<KEY,T,tlt>& to_copy, bool (*clt)(const KEY& a, const KEY& b))
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BSTMap<KEY,T,tlt,LT>::BSTMap(const BSTMap<KEY,T,tlt,LT>& to_copy, bool (*clt)(const KEY& a, const KEY& b))
 	:lt(tlt != nullptr ? tlt : clt)
 {
 	if (lt == nullptr)
 		lt = to_copy.lt;
-	if (tlt != nullptr && clt != nullptr && tlt != clt)
+	if ((tlt != nullptr || !std::is_void<LT>::value) && clt != nullptr && tlt != clt)
 		throw TemplateFunctionError("BSTMap::copy constructor: both specified and different");
-	lt = to_copy.lt;
-	map = copy(to_copy.map);
-	used = to_copy.used;
+	if (lt == to_copy.lt) {
+		map = copy(to_copy.map);
+		used = to_copy.used;
+	}else
+		for (const auto &ele : to_copy)
+			put(ele.first, ele.second);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-BSTMap<KEY,T,tlt>::BSTMap(const std::initializer_list<Entry>& il, bool (*clt)(const KEY& a, const KEY& b))
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BSTMap<KEY,T,tlt,LT>::BSTMap(const std::initializer_list<Entry>& il, bool (*clt)(const KEY& a, const KEY& b))
 	:lt(tlt != nullptr ? tlt : clt)
 {
-	if (lt == nullptr)
+	if (lt == nullptr && std::is_void<LT>::value)
 		throw TemplateFunctionError("BSTMap::initializer_list constructor: neither specified");
-	if (tlt != nullptr && clt != nullptr && tlt != clt)
+	if ((tlt != nullptr || !std::is_void<LT>::value) && clt != nullptr && tlt != clt)
 		throw TemplateFunctionError("BSTMap::initializer_list constructor: both specified and different");
 
 	for (const auto &ele : il)
@@ -191,50 +222,78 @@ BSTMap<KEY,T,tlt>::BSTMap(const std::initializer_list<Entry>& il, bool (*clt)(co
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
 template <class Iterable>
-BSTMap<KEY,T,tlt>::BSTMap(const Iterable& i, bool (*clt)(const KEY& a, const KEY& b))
+BSTMap<KEY,T,tlt,LT>::BSTMap(const Iterable& i, bool (*clt)(const KEY& a, const KEY& b))
 	:lt(tlt != nullptr ? tlt : clt)
 {
-	if (lt == nullptr)
+	if (lt == nullptr && std::is_void<LT>::value)
 		throw TemplateFunctionError("BSTMap::iterable constructor: neither specified");
-	if (tlt != nullptr && clt != nullptr && tlt != clt)
+	if ((tlt != nullptr || !std::is_void<LT>::value) && clt != nullptr && tlt != clt)
 		throw TemplateFunctionError("BSTMap::iterable constructor: both specified and different");
 	for (const auto &ele : i)
 		put(ele.first, ele.second);
 }
 
 
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+template <class Iterable>
+BSTMap<KEY,T,tlt,LT> BSTMap<KEY,T,tlt,LT>::from_sorted(const Iterable& i, bool (*clt)(const KEY& a, const KEY& b)) {
+	BSTMap<KEY,T,tlt,LT> to_return(clt);
+	//Link the entries into a vine first, so nothing leaks if they are out of order
+	TN* vine = nullptr;
+	TN* last = nullptr;
+	for (const auto &ele : i) {
+		TN* next = new TN(Entry(ele.first, ele.second));
+		if (last != nullptr && !to_return.is_lt(last->value.first, next->value.first)) {
+			std::ostringstream answer;
+			answer << "BSTMap::from_sorted: key(" << next->value.first << ") not in increasing order";
+			delete next;
+			for (TN* to_delete = vine; to_delete != nullptr; to_delete = vine) {
+				vine = vine->right;
+				delete to_delete;
+			}
+			throw KeyError(answer.str());
+		}
+		(last == nullptr ? vine : last->right) = next;
+		last = next;
+		to_return.used++;
+	}
+	to_return.map = to_return.vine_to_tree(vine, to_return.used);
+	return to_return;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Queries
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::empty() const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BSTMap<KEY,T,tlt,LT>::empty() const {
 	return used == 0;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-int BSTMap<KEY,T,tlt>::size() const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+int BSTMap<KEY,T,tlt,LT>::size() const {
 	return used;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::has_key (const KEY& key) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BSTMap<KEY,T,tlt,LT>::has_key (const KEY& key) const {
 	return find_key(map, key);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::has_value (const T& value) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BSTMap<KEY,T,tlt,LT>::has_value (const T& value) const {
 	return has_value(map, value);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-std::string BSTMap<KEY,T,tlt>::str() const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+std::string BSTMap<KEY,T,tlt,LT>::str() const {
 	std::ostringstream to_return;
 	to_return << "bst_map[\n" << string_rotated(map, "") << "](used=" << used << ",mod_count=" << mod_count << ")";
 	return to_return.str();
@@ -246,32 +305,40 @@ std::string BSTMap<KEY,T,tlt>::str() const {
 //
 //Commands
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-T BSTMap<KEY,T,tlt>::put(const KEY& key, const T& value) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T BSTMap<KEY,T,tlt,LT>::put(const KEY& key, const T& value) {
 	mod_count++;
 	return insert(map, key, value);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-T BSTMap<KEY,T,tlt>::erase(const KEY& key) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T BSTMap<KEY,T,tlt,LT>::erase(const KEY& key) {
 	T temp = remove(map, key);
 	mod_count++, used--;
 	return temp;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-void BSTMap<KEY,T,tlt>::clear() {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BSTMap<KEY,T,tlt,LT>::clear() {
 	delete_BST(map);
 	map = nullptr;
 	used = 0;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BSTMap<KEY,T,tlt,LT>::rebalance() {
+	TN* vine = tree_to_vine(map);
+	map = vine_to_tree(vine, used);
+	mod_count++;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
 template<class Iterable>
-int BSTMap<KEY,T,tlt>::put_all(const Iterable& i) {
+int BSTMap<KEY,T,tlt,LT>::put_all(const Iterable& i) {
 	int count = 0;
 	for (const auto &ele : i)
 		put(ele.first, ele.second), count++;
@@ -279,49 +346,147 @@ int BSTMap<KEY,T,tlt>::put_all(const Iterable& i) {
 }
 
 
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+int BSTMap<KEY,T,tlt,LT>::merge(const BSTMap<KEY,T,tlt,LT>& other) {
+	if (this == &other)
+		return 0;
+	int old_used = used;
+	if (lt != other.lt)
+		put_all(other);
+	else
+		combine(other, true, true, true);
+	return used - old_used;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+int BSTMap<KEY,T,tlt,LT>::intersect(const BSTMap<KEY,T,tlt,LT>& other) {
+	if (this == &other)
+		return 0;
+	int old_used = used;
+	if (lt != other.lt) {
+		for (auto i = begin(); i != end(); ++i)
+			if (!other.has_key((*i).first))
+				i.erase();
+	}else
+		combine(other, false, true, false);
+	return old_used - used;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+int BSTMap<KEY,T,tlt,LT>::difference(const BSTMap<KEY,T,tlt,LT>& other) {
+	int old_used = used;
+	if (this == &other)
+		clear();
+	else if (lt != other.lt) {
+		for (auto i = begin(); i != end(); ++i)
+			if (other.has_key((*i).first))
+				i.erase();
+	}else
+		combine(other, true, false, false);
+	return old_used - used;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BSTMap<KEY,T,tlt,LT>::split(const KEY& key, BSTMap<KEY,T,tlt,LT>& greater) {
+	if (this == &greater)
+		return;
+	greater.clear();
+	greater.lt = lt;
+	split(map, key, map, greater.map);
+
+	//Count the moved entries (iteratively: the moved tree need not be balanced)
+	ArrayStack<TN*> pending;
+	push_left_spine(greater.map, pending);
+	while (!pending.empty()) {
+		TN* next = pending.pop();
+		push_left_spine(next->right, pending);
+		greater.used++;
+	}
+	used -= greater.used;
+	mod_count++, greater.mod_count++;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BSTMap<KEY,T,tlt,LT>::join(BSTMap<KEY,T,tlt,LT>& greater) {
+	if (this == &greater || greater.empty())
+		return;
+	if (lt != greater.lt)
+		throw TemplateFunctionError("BSTMap::join: different lt");
+	if (!empty()) {
+		TN* largest = map;
+		while (largest->right != nullptr)
+			largest = largest->right;
+		TN* smallest = greater.map;
+		while (smallest->left != nullptr)
+			smallest = smallest->left;
+		if (!is_lt(largest->value.first, smallest->value.first)) {
+			std::ostringstream answer;
+			answer << "BSTMap::join: key(" << smallest->value.first << ") not greater than key(" << largest->value.first << ")";
+			throw KeyError(answer.str());
+		}
+		//This tree's largest entry becomes the root joining both trees
+		Entry middle = remove_closest(map);
+		map = new TN(middle, map, greater.map);
+	}else
+		map = greater.map;
+	used += greater.used;
+	greater.map = nullptr;
+	greater.used = 0;
+	mod_count++, greater.mod_count++;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Operators
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-T& BSTMap<KEY,T,tlt>::operator [] (const KEY& key) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T& BSTMap<KEY,T,tlt,LT>::operator [] (const KEY& key) {
 	return find_addempty(map,key);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-const T& BSTMap<KEY,T,tlt>::operator [] (const KEY& key) const {
-	return const_cast<BSTMap<KEY,T,tlt> *> (this)->find_addempty(const_cast<TN *&>(map), key);
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+const T& BSTMap<KEY,T,tlt,LT>::operator [] (const KEY& key) const {
+	TN* found = find_key(map, key);
+	if (found != nullptr)
+		return found->value.second;
+	std::ostringstream answer;
+	answer << "BSTMap::operator []: key(" << key << ") not in Map";
+	throw KeyError(answer.str());
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-BSTMap<KEY,T,tlt>& BSTMap<KEY,T,tlt>::operator = (const BSTMap<KEY,T,tlt>& rhs) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BSTMap<KEY,T,tlt,LT>& BSTMap<KEY,T,tlt,LT>::operator = (const BSTMap<KEY,T,tlt,LT>& rhs) {
 	if (this == &rhs)
 		return *this;
-	clear();
 	lt = rhs.lt;
-	map = copy(rhs.map);
+	copy_into(map, rhs.map);
 	mod_count++;
 	used = rhs.used;
 	return *this;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::operator == (const BSTMap<KEY,T,tlt>& rhs) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BSTMap<KEY,T,tlt,LT>::operator == (const BSTMap<KEY,T,tlt,LT>& rhs) const {
 	return equals(map, rhs);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::operator != (const BSTMap<KEY,T,tlt>& rhs) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BSTMap<KEY,T,tlt,LT>::operator != (const BSTMap<KEY,T,tlt,LT>& rhs) const {
 	return !(*this == rhs);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-std::ostream& operator << (std::ostream& outs, const BSTMap<KEY,T,tlt>& m) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+std::ostream& operator << (std::ostream& outs, const BSTMap<KEY,T,tlt,LT>& m) {
 	outs << "map[";
 	ArrayQueue<ics::pair<KEY,T>> it;
 	for (m.copy_to_queue(m.map, it); it.size(); it.dequeue()){
@@ -338,31 +503,37 @@ std::ostream& operator << (std::ostream& outs, const BSTMap<KEY,T,tlt>& m) {
 //
 //Iterator constructors
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-auto BSTMap<KEY,T,tlt>::begin () const -> BSTMap<KEY,T,tlt>::Iterator {
-	 return Iterator(const_cast<BSTMap<KEY,T,tlt>*>(this),true);
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BSTMap<KEY,T,tlt,LT>::begin () const -> BSTMap<KEY,T,tlt,LT>::Iterator {
+	 return Iterator(const_cast<BSTMap<KEY,T,tlt,LT>*>(this),true);
 }
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-auto BSTMap<KEY,T,tlt>::end () const -> BSTMap<KEY,T,tlt>::Iterator {
-	return Iterator(const_cast<BSTMap<KEY,T,tlt>*>(this),false);
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BSTMap<KEY,T,tlt,LT>::end () const -> BSTMap<KEY,T,tlt,LT>::Iterator {
+	return Iterator(const_cast<BSTMap<KEY,T,tlt,LT>*>(this),false);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Private helper methods
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-typename BSTMap<KEY,T,tlt>::TN* BSTMap<KEY,T,tlt>::find_key (TN* root, const KEY& key) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BSTMap<KEY,T,tlt,LT>::is_lt (const KEY& a, const KEY& b) const {
+	return Functor<LT>::call(tlt != nullptr ? tlt : lt, a, b);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+typename BSTMap<KEY,T,tlt,LT>::TN* BSTMap<KEY,T,tlt,LT>::find_key (TN* root, const KEY& key) const {
 	TN *traverse = root;
 	while (traverse != nullptr && traverse->value.first != key)
-		traverse = lt(key, traverse->value.first) ? traverse->left : traverse->right;
+		traverse = is_lt(key, traverse->value.first) ? traverse->left : traverse->right;
 	return traverse;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::has_value (TN* root, const T& value) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BSTMap<KEY,T,tlt,LT>::has_value (TN* root, const T& value) const {
 	ArrayQueue<Entry> q;
 	copy_to_queue(root, q);
 	for (auto &i : q)
@@ -372,16 +543,16 @@ bool BSTMap<KEY,T,tlt>::has_value (TN* root, const T& value) const {
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-typename BSTMap<KEY,T,tlt>::TN* BSTMap<KEY,T,tlt>::copy (TN* root) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+typename BSTMap<KEY,T,tlt,LT>::TN* BSTMap<KEY,T,tlt,LT>::copy (TN* root) const {
 	if (root == nullptr)
 		return nullptr;
-	return new BSTMap<KEY,T,tlt>::TN(root->value, copy(root->left), copy(root->right));
+	return new BSTMap<KEY,T,tlt,LT>::TN(root->value, copy(root->left), copy(root->right));
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-void BSTMap<KEY,T,tlt>::copy_to_queue (TN* root, ArrayQueue<Entry>& q) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BSTMap<KEY,T,tlt,LT>::copy_to_queue (TN* root, ArrayQueue<Entry>& q) const {
 	if (root == nullptr)
 		return;
 	copy_to_queue(root->left, q);
@@ -390,24 +561,39 @@ void BSTMap<KEY,T,tlt>::copy_to_queue (TN* root, ArrayQueue<Entry>& q) const {
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::equals (TN* root, const BSTMap<KEY,T,tlt>& other) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BSTMap<KEY,T,tlt,LT>::push_left_spine (TN* root, ArrayStack<TN*>& pending) const {
+	for (; root != nullptr; root = root->left)
+		pending.push(root);
+}
+
+
+//With the same lt, equal maps list the same entries in the same in-order
+//  sequence (whatever their shapes): walk both trees together, stopping at
+//  the first difference
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BSTMap<KEY,T,tlt,LT>::equals (TN* root, const BSTMap<KEY,T,tlt,LT>& other) const {
 	if (this == &other)
 		return true;
 	if (used != other.size() || lt != other.lt)
 		return false;
-	ArrayQueue<Entry> qthis;
-	for (copy_to_queue(root, qthis); qthis.size(); qthis.dequeue()){
-		Entry ele = qthis.peek();
-		if (!other.has_key(ele.first) || other[ele.first] != ele.second)
+	ArrayStack<TN*> this_pending, other_pending;
+	push_left_spine(root, this_pending);
+	push_left_spine(other.map, other_pending);
+	while (!this_pending.empty() && !other_pending.empty()) {
+		TN* this_next  = this_pending.pop();
+		TN* other_next = other_pending.pop();
+		if (this_next->value.first != other_next->value.first || this_next->value.second != other_next->value.second)
 			return false;
+		push_left_spine(this_next->right, this_pending);
+		push_left_spine(other_next->right, other_pending);
 	}
-	return true;
+	return this_pending.empty() && other_pending.empty();
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-std::string BSTMap<KEY,T,tlt>::string_rotated(TN* root, std::string indent) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+std::string BSTMap<KEY,T,tlt,LT>::string_rotated(TN* root, std::string indent) const {
 	if (root == nullptr)
 		return "";
 	std::ostringstream to_return;
@@ -418,8 +604,8 @@ std::string BSTMap<KEY,T,tlt>::string_rotated(TN* root, std::string indent) cons
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-T BSTMap<KEY,T,tlt>::insert (TN*& root, const KEY& key, const T& value) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T BSTMap<KEY,T,tlt,LT>::insert (TN*& root, const KEY& key, const T& value) {
 	if (root == nullptr){
 		root = new TN(Entry(key, value));
 		used++;
@@ -430,7 +616,7 @@ T BSTMap<KEY,T,tlt>::insert (TN*& root, const KEY& key, const T& value) {
 		root->value.second = value;
 		return old;
 	}
-	if (lt(key, root->value.first)){
+	if (is_lt(key, root->value.first)){
 		if (root->left == nullptr){
 			root->left = new TN(Entry(key, value));
 			used++;
@@ -444,12 +630,12 @@ T BSTMap<KEY,T,tlt>::insert (TN*& root, const KEY& key, const T& value) {
 			return value;
 		}
 	}
-	return insert(lt(key, root->value.first) ? root->left : root->right, key, value);
+	return insert(is_lt(key, root->value.first) ? root->left : root->right, key, value);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-T& BSTMap<KEY,T,tlt>::find_addempty (TN*& root, const KEY& key) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T& BSTMap<KEY,T,tlt,LT>::find_addempty (TN*& root, const KEY& key) {
 	if (root == nullptr){
 		root = new TN(Entry(key, T()));
 		used++;
@@ -459,7 +645,7 @@ T& BSTMap<KEY,T,tlt>::find_addempty (TN*& root, const KEY& key) {
 	if (root->value.first == key)
 		return root->value.second;
 
-	if (lt(key, root->value.first)){
+	if (is_lt(key, root->value.first)){
 		if (root->left == nullptr){
 			root->left = new TN(Entry(key, T()));
 			used++;
@@ -475,12 +661,104 @@ T& BSTMap<KEY,T,tlt>::find_addempty (TN*& root, const KEY& key) {
 			return root->right->value.second;
 		}
 	}
-	return find_addempty(lt(key, root->value.first) ? root->left : root->right, key);
+	return find_addempty(is_lt(key, root->value.first) ? root->left : root->right, key);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BSTMap<KEY,T,tlt,LT>::copy_into (TN*& root, TN* from) {
+	if (from == nullptr) {
+		delete_BST(root);
+		return;
+	}
+	if (root == nullptr) {
+		root = copy(from);
+		return;
+	}
+	root->value = from->value;
+	copy_into(root->left, from->left);
+	copy_into(root->right, from->right);
+}
+
+
+//Flatten this tree into a vine and walk it alongside an in-order walk of other
+//  (both ordered by the same lt), relinking this map's TN into a new vine:
+//  keys only in this map are kept if keep_this_only; keys in both are kept
+//  (with other's value, if add_other_only) if keep_common; keys only in other
+//  are copied in if add_other_only. The new vine is rebuilt balanced.
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+int BSTMap<KEY,T,tlt,LT>::combine (const BSTMap<KEY,T,tlt,LT>& other, bool keep_this_only, bool keep_common, bool add_other_only) {
+	TN*  mine  = tree_to_vine(map);
+	TN*  vine  = nullptr;
+	TN** tail  = &vine;
+	int  count = 0;
+
+	ArrayStack<TN*> pending;
+	push_left_spine(other.map, pending);
+	TN* theirs = nullptr;
+	if (!pending.empty()) {
+		theirs = pending.pop();
+		push_left_spine(theirs->right, pending);
+	}
+
+	while (mine != nullptr || theirs != nullptr) {
+		bool from_mine   = theirs == nullptr || (mine != nullptr && is_lt(mine->value.first, theirs->value.first));
+		bool from_theirs = !from_mine && (mine == nullptr || is_lt(theirs->value.first, mine->value.first));
+		if (!from_theirs) {
+			TN* next = mine;
+			mine = mine->right;
+			if (from_mine ? keep_this_only : keep_common) {
+				if (!from_mine && add_other_only)
+					next->value.second = theirs->value.second;
+				*tail = next;
+				tail = &next->right;
+				count++;
+			}else
+				delete next;
+		}else if (add_other_only) {
+			*tail = new TN(theirs->value);
+			tail = &(*tail)->right;
+			count++;
+		}
+
+		if (!from_mine) {
+			if (pending.empty())
+				theirs = nullptr;
+			else {
+				theirs = pending.pop();
+				push_left_spine(theirs->right, pending);
+			}
+		}
+	}
+	*tail = nullptr;
+
+	map = vine_to_tree(vine, count);
+	used = count;
+	mod_count++;
+	return count;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-pair<KEY,T> BSTMap<KEY,T,tlt>::remove_closest(TN*& root) {
+//Split root's tree into the TN with keys < key (less) and those >= key (not_less),
+//  reusing all TN: O(height)
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BSTMap<KEY,T,tlt,LT>::split (TN* root, const KEY& key, TN*& less, TN*& not_less) {
+	if (root == nullptr) {
+		less = not_less = nullptr;
+		return;
+	}
+	if (is_lt(root->value.first, key)) {
+		less = root;
+		split(root->right, key, root->right, not_less);
+	}else{
+		not_less = root;
+		split(root->left, key, less, root->left);
+	}
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+pair<KEY,T> BSTMap<KEY,T,tlt,LT>::remove_closest(TN*& root) {
   if (root->right != nullptr)
     return remove_closest(root->right);
   else{
@@ -493,8 +771,8 @@ pair<KEY,T> BSTMap<KEY,T,tlt>::remove_closest(TN*& root) {
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-T BSTMap<KEY,T,tlt>::remove (TN*& root, const KEY& key) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T BSTMap<KEY,T,tlt,LT>::remove (TN*& root, const KEY& key) {
   if (root == nullptr) {
     std::ostringstream answer;
     answer << "BSTMap::erase: key(" << key << ") not in Map";
@@ -514,12 +792,12 @@ T BSTMap<KEY,T,tlt>::remove (TN*& root, const KEY& key) {
         root->value = remove_closest(root->left);
       return to_return;
     }else
-      return remove( (lt(key,root->value.first) ? root->left : root->right), key);
+      return remove( (is_lt(key,root->value.first) ? root->left : root->right), key);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-void BSTMap<KEY,T,tlt>::delete_BST (TN*& root) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void BSTMap<KEY,T,tlt,LT>::delete_BST (TN*& root) {
 	if (root == nullptr)
 		return;
 	delete_BST(root->left), delete_BST(root->right);
@@ -528,6 +806,39 @@ void BSTMap<KEY,T,tlt>::delete_BST (TN*& root) {
 }
 
 
+//Day-Stout-Warren: rotate right at each node with a left child; iterative, so
+//  even a degenerate tree is flattened without deep recursion
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+typename BSTMap<KEY,T,tlt,LT>::TN* BSTMap<KEY,T,tlt,LT>::tree_to_vine (TN* root) {
+	TN*  vine = root;
+	TN** link = &vine;
+	for (TN* rest = root; rest != nullptr; /*See body*/)
+		if (rest->left == nullptr) {
+			link = &rest->right;
+			rest = rest->right;
+		}else{
+			TN* temp = rest->left;
+			rest->left = temp->right;
+			temp->right = rest;
+			*link = rest = temp;
+		}
+	return vine;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+typename BSTMap<KEY,T,tlt,LT>::TN* BSTMap<KEY,T,tlt,LT>::vine_to_tree (TN*& vine, int n) {
+	if (n == 0)
+		return nullptr;
+	TN* left = vine_to_tree(vine, n/2);
+	TN* root = vine;
+	vine = vine->right;
+	root->left = left;
+	root->right = vine_to_tree(vine, n-n/2-1);
+	return root;
+}
+
+
 
 
 
@@ -536,8 +847,8 @@ void BSTMap<KEY,T,tlt>::delete_BST (TN*& root) {
 //
 //Iterator class definitions
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-BSTMap<KEY,T,tlt>::Iterator::Iterator(BSTMap<KEY,T,tlt>* iterate_over, bool from_begin)
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BSTMap<KEY,T,tlt,LT>::Iterator::Iterator(BSTMap<KEY,T,tlt,LT>* iterate_over, bool from_begin)
 	:ref_map(iterate_over), expected_mod_count(ref_map->mod_count)
 {
 	if (from_begin)
@@ -545,13 +856,13 @@ BSTMap<KEY,T,tlt>::Iterator::Iterator(BSTMap<KEY,T,tlt>* iterate_over, bool from
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-BSTMap<KEY,T,tlt>::Iterator::~Iterator()
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+BSTMap<KEY,T,tlt,LT>::Iterator::~Iterator()
 {}
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-auto BSTMap<KEY,T,tlt>::Iterator::erase() -> Entry {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BSTMap<KEY,T,tlt,LT>::Iterator::erase() -> Entry {
 	if (expected_mod_count != ref_map->mod_count)
 		throw ConcurrentModificationError("BSTMap::Iterator::erase");
 	if (!can_erase)
@@ -567,16 +878,16 @@ auto BSTMap<KEY,T,tlt>::Iterator::erase() -> Entry {
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-std::string BSTMap<KEY,T,tlt>::Iterator::str() const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+std::string BSTMap<KEY,T,tlt,LT>::Iterator::str() const {
 	std::ostringstream to_return;
 	to_return << ref_map->str() << "(cursor=" << it.peek() << ",expected_mod_count=" << expected_mod_count << ")";
 	return to_return.str();
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-auto  BSTMap<KEY,T,tlt>::Iterator::operator ++ () -> BSTMap<KEY,T,tlt>::Iterator& {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto  BSTMap<KEY,T,tlt,LT>::Iterator::operator ++ () -> BSTMap<KEY,T,tlt,LT>::Iterator& {
 	if (expected_mod_count != ref_map->mod_count)
 		throw ConcurrentModificationError("BSTMap::Iterator::operator ++");
 	if (it.empty())
@@ -589,8 +900,8 @@ auto  BSTMap<KEY,T,tlt>::Iterator::operator ++ () -> BSTMap<KEY,T,tlt>::Iterator
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-auto BSTMap<KEY,T,tlt>::Iterator::operator ++ (int) -> BSTMap<KEY,T,tlt>::Iterator {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto BSTMap<KEY,T,tlt,LT>::Iterator::operator ++ (int) -> BSTMap<KEY,T,tlt,LT>::Iterator {
 	if (expected_mod_count != ref_map->mod_count)
 		throw ConcurrentModificationError("BSTMap::Iterator::operator ++(int)");
 	if (it.empty())
@@ -604,8 +915,8 @@ auto BSTMap<KEY,T,tlt>::Iterator::operator ++ (int) -> BSTMap<KEY,T,tlt>::Iterat
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::Iterator::operator == (const BSTMap<KEY,T,tlt>::Iterator& rhs) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BSTMap<KEY,T,tlt,LT>::Iterator::operator == (const BSTMap<KEY,T,tlt,LT>::Iterator& rhs) const {
 	const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
 	if (rhsASI == 0)
 		throw IteratorTypeError("BSTMap::Iterator::operator ==");
@@ -617,8 +928,8 @@ bool BSTMap<KEY,T,tlt>::Iterator::operator == (const BSTMap<KEY,T,tlt>::Iterator
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::Iterator::operator != (const BSTMap<KEY,T,tlt>::Iterator& rhs) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool BSTMap<KEY,T,tlt,LT>::Iterator::operator != (const BSTMap<KEY,T,tlt,LT>::Iterator& rhs) const {
 	const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
 	if (rhsASI == 0)
 		throw IteratorTypeError("BSTMap::Iterator::operator !=");
@@ -631,8 +942,8 @@ bool BSTMap<KEY,T,tlt>::Iterator::operator != (const BSTMap<KEY,T,tlt>::Iterator
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-pair<KEY,T>& BSTMap<KEY,T,tlt>::Iterator::operator *() const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+pair<KEY,T>& BSTMap<KEY,T,tlt,LT>::Iterator::operator *() const {
 	if (expected_mod_count != ref_map->mod_count)
 		throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator *");
 	if (!can_erase || it.empty())
@@ -641,8 +952,8 @@ pair<KEY,T>& BSTMap<KEY,T,tlt>::Iterator::operator *() const {
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-pair<KEY,T>* BSTMap<KEY,T,tlt>::Iterator::operator ->() const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+pair<KEY,T>* BSTMap<KEY,T,tlt,LT>::Iterator::operator ->() const {
 	if (expected_mod_count != ref_map->mod_count)
 		throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator ->");
 	if (!can_erase || it.empty())
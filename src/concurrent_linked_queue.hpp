@@ -0,0 +1,479 @@
+#ifndef CONCURRENT_LINKED_QUEUE_HPP_
+#define CONCURRENT_LINKED_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <atomic>
+#include "ics_exceptions.hpp"
+#include "array_queue.hpp"     //For iteration
+#include "epoch_reclaimer.hpp" //For deleting dequeued nodes that other threads may still see
+
+
+namespace ics {
+
+
+//An unbounded FIFO queue that many threads can use at once, without locks:
+//  the Michael-Scott queue. The list always starts with a dummy LN (front);
+//  enqueue links a new LN after the last one with compare_exchange, and
+//  dequeue swings front to its successor (which becomes the new dummy) with
+//  compare_exchange. A thread that finds rear lagging behind the last LN
+//  advances it before retrying, so no thread waits for another.
+//Dequeued LNs are retired to an EpochReclaimer, so a thread that read front
+//  (or rear) just before it changed never follows a deleted LN (and an LN's
+//  address is never reused while any thread could compare against it).
+//Whole-queue operations (==, str, <<, iteration, operator =, the copy
+//  constructor) are NOT atomic: they see the values in the queue from front to
+//  rear at some time during the operation. peek returns a copy; the Iterator
+//  iterates over values copied by begin and cannot erase.
+template<class T> class ConcurrentLinkedQueue {
+  public:
+    //Destructor/Constructors
+    ~ConcurrentLinkedQueue();
+
+    ConcurrentLinkedQueue          ();
+    ConcurrentLinkedQueue          (const ConcurrentLinkedQueue<T>& to_copy);
+    explicit ConcurrentLinkedQueue (const std::initializer_list<T>& il);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit ConcurrentLinkedQueue (const Iterable& i);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    T    peek       () const; //Returns a copy: another thread may dequeue it at any time
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    int  enqueue     (const T& element);
+    T    dequeue     ();
+    bool try_dequeue (T& into);
+    void clear       ();       //Dequeues until (at some moment) the queue is empty
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+
+    //Operators
+    ConcurrentLinkedQueue<T>& operator = (const ConcurrentLinkedQueue<T>& rhs);
+    bool operator == (const ConcurrentLinkedQueue<T>& rhs) const;
+    bool operator != (const ConcurrentLinkedQueue<T>& rhs) const;
+
+    template<class T2>
+    friend std::ostream& operator << (std::ostream& outs, const ConcurrentLinkedQueue<T2>& q);
+
+
+
+    //Iterates over the values copied (front to rear) by begin
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of ConcurrentLinkedQueue<T>
+        ~Iterator();
+        std::string str  () const;
+        ConcurrentLinkedQueue<T>::Iterator& operator ++ ();
+        ConcurrentLinkedQueue<T>::Iterator  operator ++ (int);
+        bool operator == (const ConcurrentLinkedQueue<T>::Iterator& rhs) const;
+        bool operator != (const ConcurrentLinkedQueue<T>::Iterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const ConcurrentLinkedQueue<T>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+        friend Iterator ConcurrentLinkedQueue<T>::begin () const;
+        friend Iterator ConcurrentLinkedQueue<T>::end   () const;
+
+      private:
+        ArrayQueue<T>             it;                 //Values copied by begin
+        ConcurrentLinkedQueue<T>* ref_queue;
+
+        //Called in friends begin/end
+        Iterator(ConcurrentLinkedQueue<T>* iterate_over, bool from_begin);
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+    class LN {
+      public:
+        LN ()                      {}
+        LN (const T& v)            : value(v) {}
+
+        T                value;                  //Never changed once the LN is linked
+        std::atomic<LN*> next{nullptr};
+    };
+
+
+    std::atomic<LN*>       front;              //The dummy LN: the first value is in front->next
+    std::atomic<LN*>       rear;               //The last LN, or (briefly) the one before it
+    std::atomic<int>       used{0};            //Cache for number of values (may briefly lag enqueue/dequeue)
+    mutable EpochReclaimer reclaimer;          //Dequeued LN are retired here, and deleted when no thread can see them
+
+    //Helper methods
+    int copy_to_queue (ArrayQueue<T>& q) const; //Enqueue all values, front to rear; return # enqueued
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//ConcurrentLinkedQueue class and related definitions
+
+//Destructor/Constructors
+
+//No other thread may use the queue while it is destroyed
+template<class T>
+ConcurrentLinkedQueue<T>::~ConcurrentLinkedQueue() {
+  for (LN* p = front.load(); p != nullptr; ) {
+    LN* to_delete = p;
+    p = p->next.load();
+    delete to_delete;
+  }
+}
+
+
+template<class T>
+ConcurrentLinkedQueue<T>::ConcurrentLinkedQueue() {
+  LN* dummy = new LN();
+  front.store(dummy);
+  rear.store(dummy);
+}
+
+
+template<class T>
+ConcurrentLinkedQueue<T>::ConcurrentLinkedQueue(const ConcurrentLinkedQueue<T>& to_copy)
+: ConcurrentLinkedQueue() {
+  ArrayQueue<T> values;
+  to_copy.copy_to_queue(values);
+  enqueue_all(values);
+}
+
+
+template<class T>
+ConcurrentLinkedQueue<T>::ConcurrentLinkedQueue(const std::initializer_list<T>& il)
+: ConcurrentLinkedQueue() {
+  enqueue_all(il);
+}
+
+
+template<class T>
+template<class Iterable>
+ConcurrentLinkedQueue<T>::ConcurrentLinkedQueue(const Iterable& i)
+: ConcurrentLinkedQueue() {
+  enqueue_all(i);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T>
+bool ConcurrentLinkedQueue<T>::empty() const {
+  EpochReclaimer::Guard pinned = reclaimer.pin();
+  return front.load()->next.load() == nullptr;
+}
+
+
+template<class T>
+int ConcurrentLinkedQueue<T>::size() const {
+  int answer = used.load();
+  return answer < 0 ? 0 : answer;
+}
+
+
+template<class T>
+T ConcurrentLinkedQueue<T>::peek () const {
+  {
+    EpochReclaimer::Guard pinned = reclaimer.pin();
+    LN* first = front.load()->next.load();
+    if (first != nullptr)
+      return first->value;
+  }
+
+  throw EmptyError("ConcurrentLinkedQueue::peek");
+}
+
+
+template<class T>
+std::string ConcurrentLinkedQueue<T>::str() const {
+  ArrayQueue<T> values;
+  copy_to_queue(values);
+
+  std::ostringstream answer;
+  answer << "concurrent_linked_queue[";
+  int printed = 0;
+  for (const T& v : values)
+    answer << (printed++ == 0 ? "" : "->") << v;
+  answer << "](used=" << size() << ",retired=" << reclaimer.retired() << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T>
+int ConcurrentLinkedQueue<T>::enqueue(const T& element) {
+  LN* to_add = new LN(element);
+  EpochReclaimer::Guard pinned = reclaimer.pin();
+  for (;;) {
+    LN* last = rear.load();
+    LN* next = last->next.load();
+    if (last != rear.load())
+      continue;
+    if (next != nullptr) {                  //rear is lagging: help advance it
+      rear.compare_exchange_weak(last, next);
+      continue;
+    }
+    if (last->next.compare_exchange_weak(next, to_add)) {
+      rear.compare_exchange_strong(last, to_add);   //Fails only if another thread already helped
+      ++used;
+      return 1;
+    }
+  }
+}
+
+
+template<class T>
+T ConcurrentLinkedQueue<T>::dequeue() {
+  T to_return;
+  if (!try_dequeue(to_return))
+    throw EmptyError("ConcurrentLinkedQueue::dequeue");
+  return to_return;
+}
+
+
+//Copy the value before swinging front: once another thread dequeues past it,
+//  the LN can be retired (but, while this thread is pinned, not deleted)
+template<class T>
+bool ConcurrentLinkedQueue<T>::try_dequeue(T& into) {
+  EpochReclaimer::Guard pinned = reclaimer.pin();
+  for (;;) {
+    LN* first = front.load();
+    LN* last  = rear.load();
+    LN* next  = first->next.load();
+    if (first != front.load())
+      continue;
+    if (next == nullptr)
+      return false;
+    if (first == last) {                    //rear is lagging: help advance it
+      rear.compare_exchange_weak(last, next);
+      continue;
+    }
+    into = next->value;
+    if (front.compare_exchange_weak(first, next)) {
+      --used;
+      reclaimer.retire(pinned, first);
+      return true;
+    }
+  }
+}
+
+
+template<class T>
+void ConcurrentLinkedQueue<T>::clear() {
+  T ignored;
+  while (try_dequeue(ignored))
+    ;
+}
+
+
+template<class T>
+template<class Iterable>
+int ConcurrentLinkedQueue<T>::enqueue_all(const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+    count += enqueue(v);
+
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T>
+ConcurrentLinkedQueue<T>& ConcurrentLinkedQueue<T>::operator = (const ConcurrentLinkedQueue<T>& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  ArrayQueue<T> values;
+  rhs.copy_to_queue(values);
+  clear();
+  enqueue_all(values);
+  return *this;
+}
+
+
+template<class T>
+bool ConcurrentLinkedQueue<T>::operator == (const ConcurrentLinkedQueue<T>& rhs) const {
+  if (this == &rhs)
+    return true;
+
+  ArrayQueue<T> this_values, rhs_values;
+  copy_to_queue(this_values);
+  rhs.copy_to_queue(rhs_values);
+  if (this_values.size() != rhs_values.size())
+    return false;
+  while (!this_values.empty())
+    if (this_values.dequeue() != rhs_values.dequeue())
+      return false;
+
+  return true;
+}
+
+
+template<class T>
+bool ConcurrentLinkedQueue<T>::operator != (const ConcurrentLinkedQueue<T>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T>
+std::ostream& operator << (std::ostream& outs, const ConcurrentLinkedQueue<T>& q) {
+  outs << "queue[";
+
+  int printed = 0;
+  for (const T& v : q)
+    outs << (printed++ == 0 ? "" : ",") << v;
+
+  outs << "]:rear";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class T>
+auto ConcurrentLinkedQueue<T>::begin () const -> ConcurrentLinkedQueue<T>::Iterator {
+  return Iterator(const_cast<ConcurrentLinkedQueue<T>*>(this),true);
+}
+
+
+template<class T>
+auto ConcurrentLinkedQueue<T>::end () const -> ConcurrentLinkedQueue<T>::Iterator {
+  return Iterator(const_cast<ConcurrentLinkedQueue<T>*>(this),false);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T>
+int ConcurrentLinkedQueue<T>::copy_to_queue (ArrayQueue<T>& q) const {
+  EpochReclaimer::Guard pinned = reclaimer.pin();
+  int count = 0;
+  for (LN* p = front.load()->next.load(); p != nullptr; p = p->next.load()) {
+    q.enqueue(p->value);
+    ++count;
+  }
+  return count;
+}
+
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class T>
+ConcurrentLinkedQueue<T>::Iterator::Iterator(ConcurrentLinkedQueue<T>* iterate_over, bool from_begin)
+: ref_queue(iterate_over) {
+  if (from_begin)
+    ref_queue->copy_to_queue(it);
+}
+
+
+template<class T>
+ConcurrentLinkedQueue<T>::Iterator::~Iterator()
+{}
+
+
+template<class T>
+std::string ConcurrentLinkedQueue<T>::Iterator::str() const {
+  std::ostringstream answer;
+  answer << ref_queue->str() << "(current=";
+  if (it.empty())
+    answer << "end";
+  else
+    answer << it.peek();
+  answer << ")";
+  return answer.str();
+}
+
+
+template<class T>
+auto ConcurrentLinkedQueue<T>::Iterator::operator ++ () -> ConcurrentLinkedQueue<T>::Iterator& {
+  if (!it.empty())
+    it.dequeue();
+  return *this;
+}
+
+
+template<class T>
+auto ConcurrentLinkedQueue<T>::Iterator::operator ++ (int) -> ConcurrentLinkedQueue<T>::Iterator {
+  Iterator to_return(*this);
+  ++(*this);
+  return to_return;
+}
+
+
+template<class T>
+bool ConcurrentLinkedQueue<T>::Iterator::operator == (const ConcurrentLinkedQueue<T>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("ConcurrentLinkedQueue::Iterator::operator ==");
+  if (ref_queue != rhsASI->ref_queue)
+    throw ComparingDifferentIteratorsError("ConcurrentLinkedQueue::Iterator::operator ==");
+
+  //Iterators from the same begin are equal when they have the same # of values left
+  return it.size() == rhsASI->it.size();
+}
+
+
+template<class T>
+bool ConcurrentLinkedQueue<T>::Iterator::operator != (const ConcurrentLinkedQueue<T>::Iterator& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T>
+T& ConcurrentLinkedQueue<T>::Iterator::operator *() const {
+  if (it.empty())
+    throw IteratorPositionIllegal("ConcurrentLinkedQueue::Iterator::operator * Iterator illegal: exhausted");
+
+  return it.peek();
+}
+
+
+template<class T>
+T* ConcurrentLinkedQueue<T>::Iterator::operator ->() const {
+  if (it.empty())
+    throw IteratorPositionIllegal("ConcurrentLinkedQueue::Iterator::operator -> Iterator illegal: exhausted");
+
+  return &it.peek();
+}
+
+
+}
+
+#endif /* CONCURRENT_LINKED_QUEUE_HPP_ */
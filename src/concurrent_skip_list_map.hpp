@@ -0,0 +1,725 @@
+#ifndef CONCURRENT_SKIP_LIST_MAP_HPP_
+#define CONCURRENT_SKIP_LIST_MAP_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include "ics_exceptions.hpp"
+#include "functor.hpp"
+#include "pair.hpp"
+#include "array_queue.hpp"     //For range scans and iteration
+#include "epoch_reclaimer.hpp" //For deleting erased nodes that readers may still see
+
+
+namespace ics {
+
+
+//An ordered map that many threads can use at once: a lazy skip list.
+//has_key/operator[]/scan never lock a node while searching; put/erase lock only
+//  the predecessors of the node they link/unlink (and that node), then check
+//  the predecessors are unchanged, retrying if not. So it is not lock-free:
+//  writers to neighbouring keys wait for each other's node locks, but erased
+//  nodes are retired without any lock shared by the whole map.
+//Each key's value is read/written under its node's lock, so put of an existing
+//  key and operator [] are atomic for that key. Whole-map operations (==, str,
+//  <<, iteration, clear, operator =) are NOT atomic: they see each entry as
+//  it was at some time during the operation.
+//Instantiate such that tlt(a,b) is true, iff a comes before b in the map's order
+//With a tlt specified in the template, the constructor cannot specify a clt.
+//If a tlt is defaulted, then the constructor must supply a clt (they cannot both be nullptr)
+//Instead, LT can be a functor type whose LT()(a,b) is the ordering (then neither tlt nor clt is supplied)
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr, class LT = void> class ConcurrentSkipListMap {
+  public:
+    typedef pair<KEY,T> Entry;
+
+    //Destructor/Constructors
+    ~ConcurrentSkipListMap();
+
+    ConcurrentSkipListMap          (bool (*clt)(const KEY& a, const KEY& b) = nullptr);
+    ConcurrentSkipListMap          (const ConcurrentSkipListMap<KEY,T,tlt,LT>& to_copy, bool (*clt)(const KEY& a, const KEY& b) = nullptr);
+    explicit ConcurrentSkipListMap (const std::initializer_list<Entry>& il, bool (*clt)(const KEY& a, const KEY& b) = nullptr);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit ConcurrentSkipListMap (const Iterable& i, bool (*clt)(const KEY& a, const KEY& b) = nullptr);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    bool has_key    (const KEY& key) const;
+    bool has_value  (const T& value) const;
+    int  scan       (const KEY& low, const KEY& high, ArrayQueue<Entry>& into) const; //Enqueue (in order) all low <= key < high; return # enqueued
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    T    put   (const KEY& key, const T& value);
+    T    erase (const KEY& key);
+    void clear ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int put_all(const Iterable& i);
+
+
+    //Operators
+
+    T    operator [] (const KEY&) const;      //Returns a copy: another thread may change the value at any time
+    ConcurrentSkipListMap<KEY,T,tlt,LT>& operator = (const ConcurrentSkipListMap<KEY,T,tlt,LT>& rhs);
+    bool operator == (const ConcurrentSkipListMap<KEY,T,tlt,LT>& rhs) const;
+    bool operator != (const ConcurrentSkipListMap<KEY,T,tlt,LT>& rhs) const;
+
+    template<class KEY2,class T2, bool (*lt2)(const KEY2& a, const KEY2& b), class LT2>
+    friend std::ostream& operator << (std::ostream& outs, const ConcurrentSkipListMap<KEY2,T2,lt2,LT2>& m);
+
+
+
+    //Iterates over the entries copied (in order) by begin; erase erases the
+    //  current key from the map, if it is still there
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of ConcurrentSkipListMap<T>
+        ~Iterator();
+        Entry       erase();
+        std::string str  () const;
+        ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator& operator ++ ();
+        ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator  operator ++ (int);
+        bool operator == (const ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator& rhs) const;
+        bool operator != (const ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator& rhs) const;
+        Entry& operator *  () const;
+        Entry* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+        friend Iterator ConcurrentSkipListMap<KEY,T,tlt,LT>::begin () const;
+        friend Iterator ConcurrentSkipListMap<KEY,T,tlt,LT>::end   () const;
+
+      private:
+        //If can_erase is false, the front of it is the "next" value (must ++ to reach it)
+        ArrayQueue<Entry>                    it;                 //Entries copied by begin
+        ConcurrentSkipListMap<KEY,T,tlt,LT>* ref_map;
+        bool                                 can_erase = true;
+
+        //Called in friends begin/end
+        Iterator(ConcurrentSkipListMap<KEY,T,tlt,LT>* iterate_over, bool from_begin);
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+    static const int max_level = 16;          //Levels 0..max_level-1; level l+1 links 1/4 of level l's nodes
+
+    class SN {
+      public:
+        SN (const Entry& v, int top_level) : value(v), top_level(top_level), next(new std::atomic<SN*>[top_level+1]) {
+          for (int l=0; l<=top_level; ++l)
+            next[l].store(nullptr);
+        }
+        ~SN () {delete[] next;}
+
+        Entry              value;
+        int                top_level;
+        std::atomic<SN*>*  next;                 //next[0..top_level]; nullptr ends each level
+        std::mutex         lock;
+        std::atomic<bool>  marked{false};        //Logically erased (being/been unlinked)
+        std::atomic<bool>  fully_linked{false};  //Linked at all its levels (so logically in the map)
+    };
+
+  static_assert(std::is_void<LT>::value || tlt == nullptr, "ConcurrentSkipListMap: specify tlt or LT, not both");
+  bool (*lt) (const KEY& a, const KEY& b); // The lt used for ordering the skip list (from template or constructor)
+  SN*                    head;              //Sentinel before all keys, linked at every level
+  std::atomic<int>       used{0};           //Cache for number of key->value pairs in the map
+  mutable EpochReclaimer reclaimer;         //Erased SN are retired here, and deleted when no reader can see them
+
+  //Helper methods
+  bool is_lt (const KEY& a, const KEY& b) const; //True iff a < b: via the functor type, tlt or lt (see functor.hpp)
+  int   random_level   ()                                                 const;
+  int   find           (const KEY& key, SN* preds[], SN* succs[])         const; //Fill preds/succs at every level; return highest level key found at (or -1)
+  SN*   find_node      (const KEY& key)                                   const; //Return key's SN if in the map (or nullptr); call while pinned
+  void  unlock_preds   (SN* preds[], int highest_locked)                  const;
+  int   copy_to_queue  (SN* start, const KEY* high, ArrayQueue<Entry>& q) const; //Enqueue unerased entries from start up to (excluding) high
+  bool  remove         (const KEY& key, T& old_value);                           //Return whether key was in map (erased by this call)
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//ConcurrentSkipListMap class and related definitions
+
+//Destructor/Constructors
+
+//No other thread may use the map while it is destroyed
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+ConcurrentSkipListMap<KEY,T,tlt,LT>::~ConcurrentSkipListMap() {
+  for (SN* p = head; p != nullptr; ) {
+    SN* to_delete = p;
+    p = p->next[0].load();
+    delete to_delete;
+  }
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+ConcurrentSkipListMap<KEY,T,tlt,LT>::ConcurrentSkipListMap(bool (*clt)(const KEY& a, const KEY& b))
+: lt(tlt != nullptr ? tlt : clt) {
+  if (lt == nullptr && std::is_void<LT>::value)
+    throw TemplateFunctionError("ConcurrentSkipListMap::default constructor: neither specified");
+  if ((tlt != nullptr || !std::is_void<LT>::value) && clt != nullptr && tlt != clt)
+    throw TemplateFunctionError("ConcurrentSkipListMap::default constructor: both specified and different");
+
+  head = new SN(Entry(), max_level-1);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+ConcurrentSkipListMap<KEY,T,tlt,LT>::ConcurrentSkipListMap(const ConcurrentSkipListMap<KEY,T,tlt,LT>& to_copy, bool (*clt)(const KEY& a, const KEY& b))
+: lt(tlt != nullptr ? tlt : clt) {
+  if (lt == nullptr)
+    lt = to_copy.lt;
+  if ((tlt != nullptr || !std::is_void<LT>::value) && clt != nullptr && tlt != clt)
+    throw TemplateFunctionError("ConcurrentSkipListMap::copy constructor: both specified and different");
+
+  head = new SN(Entry(), max_level-1);
+  for (const Entry& m_entry : to_copy)
+    put(m_entry.first,m_entry.second);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+ConcurrentSkipListMap<KEY,T,tlt,LT>::ConcurrentSkipListMap(const std::initializer_list<Entry>& il, bool (*clt)(const KEY& a, const KEY& b))
+: lt(tlt != nullptr ? tlt : clt) {
+  if (lt == nullptr && std::is_void<LT>::value)
+    throw TemplateFunctionError("ConcurrentSkipListMap::initializer_list constructor: neither specified");
+  if ((tlt != nullptr || !std::is_void<LT>::value) && clt != nullptr && tlt != clt)
+    throw TemplateFunctionError("ConcurrentSkipListMap::initializer_list constructor: both specified and different");
+
+  head = new SN(Entry(), max_level-1);
+  for (const Entry& m_entry : il)
+    put(m_entry.first,m_entry.second);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+template <class Iterable>
+ConcurrentSkipListMap<KEY,T,tlt,LT>::ConcurrentSkipListMap(const Iterable& i, bool (*clt)(const KEY& a, const KEY& b))
+: lt(tlt != nullptr ? tlt : clt) {
+  if (lt == nullptr && std::is_void<LT>::value)
+    throw TemplateFunctionError("ConcurrentSkipListMap::Iterable constructor: neither specified");
+  if ((tlt != nullptr || !std::is_void<LT>::value) && clt != nullptr && tlt != clt)
+    throw TemplateFunctionError("ConcurrentSkipListMap::Iterable constructor: both specified and different");
+
+  head = new SN(Entry(), max_level-1);
+  for (const auto& m_entry : i)
+    put(m_entry.first,m_entry.second);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool ConcurrentSkipListMap<KEY,T,tlt,LT>::empty() const {
+  return used.load() == 0;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+int ConcurrentSkipListMap<KEY,T,tlt,LT>::size() const {
+  return used.load();
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool ConcurrentSkipListMap<KEY,T,tlt,LT>::has_key (const KEY& key) const {
+  EpochReclaimer::Guard pinned = reclaimer.pin();
+  return find_node(key) != nullptr;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool ConcurrentSkipListMap<KEY,T,tlt,LT>::has_value (const T& value) const {
+  EpochReclaimer::Guard pinned = reclaimer.pin();
+  for (SN* p = head->next[0].load(); p != nullptr; p = p->next[0].load()) {
+    std::lock_guard<std::mutex> hold(p->lock);
+    if (!p->marked.load() && p->fully_linked.load() && p->value.second == value)
+      return true;
+  }
+  return false;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+int ConcurrentSkipListMap<KEY,T,tlt,LT>::scan (const KEY& low, const KEY& high, ArrayQueue<Entry>& into) const {
+  EpochReclaimer::Guard pinned = reclaimer.pin();
+  SN* preds[max_level];
+  SN* succs[max_level];
+  find(low, preds, succs);
+  return copy_to_queue(succs[0], &high, into);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+std::string ConcurrentSkipListMap<KEY,T,tlt,LT>::str() const {
+  EpochReclaimer::Guard pinned = reclaimer.pin();
+  std::ostringstream answer;
+  answer << "concurrent_skip_list_map[";
+  for (SN* p = head->next[0].load(); p != nullptr; p = p->next[0].load()) {
+    std::lock_guard<std::mutex> hold(p->lock);
+    answer << (p == head->next[0].load() ? "" : ",") << p->value.first << "->" << p->value.second << "(top_level=" << p->top_level;
+    if (p->marked.load())
+      answer << ",marked";
+    answer << ")";
+  }
+  answer << "](used=" << used.load() << ",retired=" << reclaimer.retired() << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T ConcurrentSkipListMap<KEY,T,tlt,LT>::put(const KEY& key, const T& value) {
+  EpochReclaimer::Guard pinned = reclaimer.pin();
+  int top_level = random_level();
+  SN* preds[max_level];
+  SN* succs[max_level];
+  for (;;) {
+    int found = find(key, preds, succs);
+    if (found != -1) {
+      SN* node = succs[found];
+      if (node->marked.load())          //Being erased: retry after it is unlinked
+        continue;
+      while (!node->fully_linked.load())
+        std::this_thread::yield();
+      std::lock_guard<std::mutex> hold(node->lock);
+      if (node->marked.load())
+        continue;
+      T old = node->value.second;
+      node->value.second = value;
+      return old;
+    }
+
+    //Lock preds bottom up; each must still be unerased and link to its succ
+    int  highest_locked = -1;
+    bool valid          = true;
+    for (int l=0; valid && l<=top_level; ++l) {
+      if (l == 0 || preds[l] != preds[l-1])
+        preds[l]->lock.lock();
+      highest_locked = l;
+      valid = !preds[l]->marked.load() && (succs[l] == nullptr || !succs[l]->marked.load()) && preds[l]->next[l].load() == succs[l];
+    }
+    if (!valid) {
+      unlock_preds(preds, highest_locked);
+      continue;
+    }
+
+    SN* to_link = new SN(Entry(key,value), top_level);
+    for (int l=0; l<=top_level; ++l)
+      to_link->next[l].store(succs[l]);
+    for (int l=0; l<=top_level; ++l)
+      preds[l]->next[l].store(to_link);
+    to_link->fully_linked.store(true);
+    unlock_preds(preds, highest_locked);
+    ++used;
+    return value;
+  }
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T ConcurrentSkipListMap<KEY,T,tlt,LT>::erase(const KEY& key) {
+  T to_return;
+  if (remove(key, to_return))
+    return to_return;
+
+  std::ostringstream answer;
+  answer << "ConcurrentSkipListMap::erase: key(" << key << ") not in Map";
+  throw KeyError(answer.str());
+}
+
+
+//Erases (only) the keys present when each is reached
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void ConcurrentSkipListMap<KEY,T,tlt,LT>::clear() {
+  ArrayQueue<Entry> to_erase;
+  {
+    EpochReclaimer::Guard pinned = reclaimer.pin();
+    copy_to_queue(head->next[0].load(), nullptr, to_erase);
+  }
+  T ignored;
+  for (const Entry& m_entry : to_erase)
+    remove(m_entry.first, ignored);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+template<class Iterable>
+int ConcurrentSkipListMap<KEY,T,tlt,LT>::put_all(const Iterable& i) {
+  int count = 0;
+  for (const auto& m_entry : i) {
+    ++count;
+    put(m_entry.first, m_entry.second);
+  }
+
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T ConcurrentSkipListMap<KEY,T,tlt,LT>::operator [] (const KEY& key) const {
+  {
+    EpochReclaimer::Guard pinned = reclaimer.pin();
+    SN* found = find_node(key);
+    if (found != nullptr) {
+      std::lock_guard<std::mutex> hold(found->lock);
+      if (!found->marked.load())
+        return found->value.second;
+    }
+  }
+
+  std::ostringstream answer;
+  answer << "ConcurrentSkipListMap::operator []: key(" << key << ") not in Map";
+  throw KeyError(answer.str());
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+ConcurrentSkipListMap<KEY,T,tlt,LT>& ConcurrentSkipListMap<KEY,T,tlt,LT>::operator = (const ConcurrentSkipListMap<KEY,T,tlt,LT>& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  clear();
+  lt = rhs.lt;   // if tlt != nullptr, lts are already equal (or compiler error)
+  put_all(rhs);
+  return *this;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool ConcurrentSkipListMap<KEY,T,tlt,LT>::operator == (const ConcurrentSkipListMap<KEY,T,tlt,LT>& rhs) const {
+  if (this == &rhs)
+    return true;
+
+  ArrayQueue<Entry> this_entries;
+  {
+    EpochReclaimer::Guard pinned = reclaimer.pin();
+    copy_to_queue(head->next[0].load(), nullptr, this_entries);
+  }
+  if (this_entries.size() != rhs.size())
+    return false;
+
+  //rhs may use a different order, so look up each key in it
+  for (const Entry& m_entry : this_entries) {
+    EpochReclaimer::Guard pinned = rhs.reclaimer.pin();
+    SN* found = rhs.find_node(m_entry.first);
+    if (found == nullptr)
+      return false;
+    std::lock_guard<std::mutex> hold(found->lock);
+    if (found->marked.load() || found->value.second != m_entry.second)
+      return false;
+  }
+  return true;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool ConcurrentSkipListMap<KEY,T,tlt,LT>::operator != (const ConcurrentSkipListMap<KEY,T,tlt,LT>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+std::ostream& operator << (std::ostream& outs, const ConcurrentSkipListMap<KEY,T,tlt,LT>& m) {
+  outs << "map[";
+
+  int printed = 0;
+  for (const auto& m_entry : m)
+    outs << (printed++ == 0? "" : ",") << m_entry.first << "->" << m_entry.second;
+
+  outs << "]";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto ConcurrentSkipListMap<KEY,T,tlt,LT>::begin () const -> ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator {
+  return Iterator(const_cast<ConcurrentSkipListMap<KEY,T,tlt,LT>*>(this),true);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto ConcurrentSkipListMap<KEY,T,tlt,LT>::end () const -> ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator {
+  return Iterator(const_cast<ConcurrentSkipListMap<KEY,T,tlt,LT>*>(this),false);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool ConcurrentSkipListMap<KEY,T,tlt,LT>::is_lt (const KEY& a, const KEY& b) const {
+  return Functor<LT>::call(tlt != nullptr ? tlt : lt, a, b);
+}
+
+
+//Geometric with p = 1/4, from a per-thread xorshift generator (no shared state)
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+int ConcurrentSkipListMap<KEY,T,tlt,LT>::random_level () const {
+  static thread_local unsigned int seed = std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  int level = 0;
+  for (unsigned int bits = seed; level < max_level-1 && (bits & 3) == 0; bits >>= 2)
+    ++level;
+  return level;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+int ConcurrentSkipListMap<KEY,T,tlt,LT>::find (const KEY& key, SN* preds[], SN* succs[]) const {
+  int found = -1;
+  SN* pred  = head;
+  for (int l=max_level-1; l>=0; --l) {
+    SN* curr = pred->next[l].load();
+    while (curr != nullptr && is_lt(curr->value.first, key)) {
+      pred = curr;
+      curr = pred->next[l].load();
+    }
+    if (found == -1 && curr != nullptr && !is_lt(key, curr->value.first))
+      found = l;
+    preds[l] = pred;
+    succs[l] = curr;
+  }
+  return found;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+typename ConcurrentSkipListMap<KEY,T,tlt,LT>::SN* ConcurrentSkipListMap<KEY,T,tlt,LT>::find_node (const KEY& key) const {
+  SN* pred = head;
+  SN* curr = nullptr;
+  for (int l=max_level-1; l>=0; --l) {
+    curr = pred->next[l].load();
+    while (curr != nullptr && is_lt(curr->value.first, key)) {
+      pred = curr;
+      curr = pred->next[l].load();
+    }
+    if (curr != nullptr && !is_lt(key, curr->value.first))
+      break;
+  }
+  if (curr != nullptr && !is_lt(key, curr->value.first) && curr->fully_linked.load() && !curr->marked.load())
+    return curr;
+  return nullptr;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void ConcurrentSkipListMap<KEY,T,tlt,LT>::unlock_preds (SN* preds[], int highest_locked) const {
+  for (int l=0; l<=highest_locked; ++l)
+    if (l == 0 || preds[l] != preds[l-1])
+      preds[l]->lock.unlock();
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+int ConcurrentSkipListMap<KEY,T,tlt,LT>::copy_to_queue (SN* start, const KEY* high, ArrayQueue<Entry>& q) const {
+  int count = 0;
+  for (SN* p = start; p != nullptr && (high == nullptr || is_lt(p->value.first, *high)); p = p->next[0].load()) {
+    std::lock_guard<std::mutex> hold(p->lock);
+    if (!p->marked.load() && p->fully_linked.load()) {
+      q.enqueue(p->value);
+      ++count;
+    }
+  }
+  return count;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool ConcurrentSkipListMap<KEY,T,tlt,LT>::remove (const KEY& key, T& old_value) {
+  EpochReclaimer::Guard pinned = reclaimer.pin();
+  SN*  victim    = nullptr;
+  bool is_marked = false;
+  SN* preds[max_level];
+  SN* succs[max_level];
+  for (;;) {
+    int found = find(key, preds, succs);
+    if (!is_marked) {
+      //Only a fully linked SN found at its own top level can be erased now
+      if (found == -1)
+        return false;
+      victim = succs[found];
+      if (!victim->fully_linked.load() || victim->top_level != found || victim->marked.load())
+        return false;
+      victim->lock.lock();
+      if (victim->marked.load()) {
+        victim->lock.unlock();
+        return false;
+      }
+      victim->marked.store(true);
+      is_marked = true;
+      old_value = victim->value.second;
+    }
+
+    //Lock preds bottom up; each must still be unerased and link to victim
+    int  highest_locked = -1;
+    bool valid          = true;
+    for (int l=0; valid && l<=victim->top_level; ++l) {
+      if (l == 0 || preds[l] != preds[l-1])
+        preds[l]->lock.lock();
+      highest_locked = l;
+      valid = !preds[l]->marked.load() && preds[l]->next[l].load() == victim;
+    }
+    if (!valid) {
+      unlock_preds(preds, highest_locked);
+      continue;
+    }
+
+    for (int l=victim->top_level; l>=0; --l)
+      preds[l]->next[l].store(victim->next[l].load());
+    victim->lock.unlock();
+    unlock_preds(preds, highest_locked);
+    --used;
+    reclaimer.retire(pinned, victim);
+    return true;
+  }
+}
+
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator::Iterator(ConcurrentSkipListMap<KEY,T,tlt,LT>* iterate_over, bool from_begin)
+: ref_map(iterate_over) {
+  if (from_begin) {
+    EpochReclaimer::Guard pinned = ref_map->reclaimer.pin();
+    ref_map->copy_to_queue(ref_map->head->next[0].load(), nullptr, it);
+  }
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator::~Iterator()
+{}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator::erase() -> Entry {
+  if (!can_erase)
+    throw CannotEraseError("ConcurrentSkipListMap::Iterator::erase Iterator cursor already erased");
+  if (it.empty())
+    throw CannotEraseError("ConcurrentSkipListMap::Iterator::erase Iterator cursor beyond data structure");
+
+  can_erase = false;
+  Entry to_return = it.dequeue();
+  T ignored;
+  ref_map->remove(to_return.first, ignored);   //Another thread may have erased it already
+  return to_return;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+std::string ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator::str() const {
+  std::ostringstream answer;
+  answer << ref_map->str() << "(current=";
+  if (it.empty())
+    answer << "end";
+  else
+    answer << it.peek();
+  answer << ",can_erase=" << can_erase << ")";
+  return answer.str();
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator::operator ++ () -> ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator& {
+  if (it.empty())
+    return *this;
+
+  if (can_erase)
+    it.dequeue();
+  else
+    can_erase = true;
+  return *this;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator::operator ++ (int) -> ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator {
+  Iterator to_return(*this);
+  ++(*this);
+  return to_return;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator::operator == (const ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("ConcurrentSkipListMap::Iterator::operator ==");
+  if (ref_map != rhsASI->ref_map)
+    throw ComparingDifferentIteratorsError("ConcurrentSkipListMap::Iterator::operator ==");
+
+  //Iterators from the same begin are equal when they have the same # of entries left
+  return it.size() == rhsASI->it.size();
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator::operator != (const ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator::operator *() const -> Entry& {
+  if (!can_erase || it.empty())
+    throw IteratorPositionIllegal("ConcurrentSkipListMap::Iterator::operator * Iterator illegal: exhausted");
+
+  return it.peek();
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto ConcurrentSkipListMap<KEY,T,tlt,LT>::Iterator::operator ->() const -> Entry* {
+  if (!can_erase || it.empty())
+    throw IteratorPositionIllegal("ConcurrentSkipListMap::Iterator::operator -> Iterator illegal: exhausted");
+
+  return &it.peek();
+}
+
+
+}
+
+#endif /* CONCURRENT_SKIP_LIST_MAP_HPP_ */
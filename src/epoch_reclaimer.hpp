@@ -0,0 +1,221 @@
+#ifndef EPOCH_RECLAIMER_HPP_
+#define EPOCH_RECLAIMER_HPP_
+
+#include <string>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <functional>
+#include "ics_exceptions.hpp"
+
+
+namespace ics {
+
+
+//Epoch-based reclamation for concurrent containers whose readers traverse nodes
+//  without locks. A thread pin()s before reading shared nodes and keeps the
+//  returned Guard until it no longer uses any of them. A node unlinked by a
+//  writer is retire()d instead of deleted: it is deleted only after every
+//  thread that was pinned when it was retired has unpinned.
+//The global epoch advances only when every pinned thread has seen it, so
+//  something retired in epoch e is unreachable by all threads once the epoch
+//  reaches e+2.
+//Each slot keeps its own list of retired things, used only by the thread that
+//  has it pinned: retiring takes no lock, and the epoch advances by CAS.
+class EpochReclaimer {
+  private:
+    struct Slot;
+
+  public:
+    //Destructor/Constructors
+    ~EpochReclaimer();
+    explicit EpochReclaimer(int slot_count = 64, int retire_threshold = 64);
+    EpochReclaimer(const EpochReclaimer& to_copy) = delete;
+    EpochReclaimer& operator = (const EpochReclaimer& rhs) = delete;
+
+    //Holds a pinned slot until destroyed; cannot be copied (only moved)
+    class Guard {
+      public:
+        ~Guard();
+        Guard(Guard&& to_move);
+        Guard(const Guard& to_copy) = delete;
+        Guard& operator = (const Guard& rhs) = delete;
+        friend class EpochReclaimer;
+      private:
+        Guard(Slot* slot) : slot(slot) {}
+        Slot* slot;
+    };
+
+
+    //Queries
+    int retired () const;   //# of things waiting to be deleted
+
+
+    //Commands
+    Guard pin     ();
+    template<class T>
+    void  retire  (const Guard& pinned, T* to_delete);  //By the thread holding pinned (from this reclaimer)
+    void  collect ();      //Try to advance the epoch and delete what is no longer reachable
+
+
+  private:
+    struct Retired {
+      unsigned long epoch;
+      void*         pointer;
+      void        (*deleter)(void*);
+    };
+
+    struct Slot {
+      std::atomic<unsigned long> pinned{0};       //Epoch seen by the Guard holding this slot; 0 means not pinned
+      std::vector<Retired>       retired;         //Used only while holding this slot
+      int                        collect_at = 0;  //Scan retired once it holds this many
+    };
+
+    std::atomic<unsigned long>  epoch{1};
+    Slot*                       slots;
+    int                         slot_count;
+    int                         retire_threshold;
+    std::atomic<int>            retired_count{0};
+
+    //Helper methods
+    bool try_advance       ();
+    void delete_older_than (std::vector<Retired>& list, unsigned long safe_epoch);
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//EpochReclaimer class and related definitions
+
+//Destructor/Constructors
+
+//No thread may be pinned when the reclaimer (and so its container) is destroyed
+inline EpochReclaimer::~EpochReclaimer() {
+  for (int i=0; i<slot_count; ++i)
+    for (Retired& r : slots[i].retired)
+      r.deleter(r.pointer);
+  delete[] slots;
+}
+
+
+inline EpochReclaimer::EpochReclaimer(int slot_count, int retire_threshold)
+: slot_count(slot_count), retire_threshold(retire_threshold) {
+  if (slot_count <= 0)
+    throw IcsError("EpochReclaimer::constructor: slots(" + std::to_string(slot_count) + ") must be > 0");
+  slots = new Slot[slot_count];
+}
+
+
+inline EpochReclaimer::Guard::~Guard() {
+  if (slot != nullptr)
+    slot->pinned.store(0, std::memory_order_release);
+}
+
+
+inline EpochReclaimer::Guard::Guard(Guard&& to_move) : slot(to_move.slot) {
+  to_move.slot = nullptr;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+inline int EpochReclaimer::retired () const {
+  return retired_count.load(std::memory_order_relaxed);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+//Claim a free slot (starting at one hashed from the thread's id, so threads
+//  rarely contend) and publish the epoch seen; re-publish if the epoch moved
+//  before the slot became visible to try_advance.
+inline EpochReclaimer::Guard EpochReclaimer::pin () {
+  int start = std::hash<std::thread::id>()(std::this_thread::get_id()) % slot_count;
+  for (;;) {
+    for (int i=0; i<slot_count; ++i) {
+      Slot& slot = slots[(start+i) % slot_count];
+      unsigned long seen = epoch.load();
+      unsigned long free = 0;
+      if (slot.pinned.load(std::memory_order_relaxed) == 0 && slot.pinned.compare_exchange_strong(free, seen)) {
+        for (unsigned long now = epoch.load(); now != seen; now = epoch.load()) {
+          slot.pinned.store(now);
+          seen = now;
+        }
+        return Guard(&slot);
+      }
+    }
+    std::this_thread::yield();   //More pinned threads than slots: wait for one to unpin
+  }
+}
+
+
+//The slot's list is scanned each time it grows by retire_threshold; what
+//  cannot be deleted yet stays for a later scan (while this thread is pinned,
+//  the epoch advances at most once, so recent retirements wait for the next Guard)
+template<class T>
+void EpochReclaimer::retire (const Guard& pinned, T* to_retire) {
+  Slot& slot = *pinned.slot;
+  slot.retired.push_back(Retired{epoch.load(), to_retire, [](void* p){delete static_cast<T*>(p);}});
+  retired_count.fetch_add(1, std::memory_order_relaxed);
+  if (int(slot.retired.size()) >= slot.collect_at + retire_threshold) {
+    try_advance();
+    delete_older_than(slot.retired, epoch.load()-1);
+    slot.collect_at = slot.retired.size();
+  }
+}
+
+
+//Scans the lists of slots no thread has pinned (claiming each while scanning
+//  it); a pinned slot's list is scanned by its own thread as it retires more
+inline void EpochReclaimer::collect () {
+  try_advance();
+  try_advance();
+  unsigned long safe_epoch = epoch.load()-1;
+  for (int i=0; i<slot_count; ++i) {
+    unsigned long free = 0;
+    if (slots[i].pinned.load(std::memory_order_relaxed) == 0 && slots[i].pinned.compare_exchange_strong(free, epoch.load())) {
+      delete_older_than(slots[i].retired, safe_epoch);
+      slots[i].collect_at = slots[i].retired.size();
+      slots[i].pinned.store(0, std::memory_order_release);
+    }
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+inline bool EpochReclaimer::try_advance () {
+  unsigned long current = epoch.load();
+  for (int i=0; i<slot_count; ++i) {
+    unsigned long pinned = slots[i].pinned.load();
+    if (pinned != 0 && pinned != current)
+      return false;
+  }
+  return epoch.compare_exchange_strong(current, current+1);
+}
+
+
+//Deletes (and keeps the vector order of) everything in list retired before safe_epoch
+inline void EpochReclaimer::delete_older_than (std::vector<Retired>& list, unsigned long safe_epoch) {
+  int kept = 0;
+  for (Retired& r : list)
+    if (r.epoch < safe_epoch)
+      r.deleter(r.pointer);
+    else
+      list[kept++] = r;
+  retired_count.fetch_sub(list.size()-kept, std::memory_order_relaxed);
+  list.resize(kept);
+}
+
+
+}
+
+#endif /* EPOCH_RECLAIMER_HPP_ */
@@ -0,0 +1,40 @@
+#ifndef FUNCTOR_HPP_
+#define FUNCTOR_HPP_
+
+#include <utility>              //For std::forward
+#include <type_traits>          //For std::is_void (used by containers)
+
+
+namespace ics {
+
+
+//Containers can be instantiated with a functor type F (e.g., std::greater<int>)
+//  instead of a function pointer (tgt/tlt/thash in the template, or cgt/clt/chash
+//  supplied to a constructor). Functor<F>::call calls a default-constructed F,
+//  or (when F is void) the function pointer it is passed.
+//Containers pass their template function pointer when it is not nullptr: like
+//  F::operator(), it is a compile-time constant, so the compiler can inline the
+//  call into loops such as percolate_down and find_key; a pointer supplied to a
+//  constructor is an indirect call.
+//F must be default constructible (a captureless lambda's type is, from C++20).
+template<class F> class Functor {
+  public:
+    template<class P, class... Args>
+    static auto call (P, Args&&... args) -> decltype(F()(std::forward<Args>(args)...)) {
+      return F()(std::forward<Args>(args)...);
+    }
+};
+
+
+template<> class Functor<void> {
+  public:
+    template<class P, class... Args>
+    static auto call (P f, Args&&... args) -> decltype(f(std::forward<Args>(args)...)) {
+      return f(std::forward<Args>(args)...);
+    }
+};
+
+
+}
+
+#endif /* FUNCTOR_HPP_ */
@@ -6,6 +6,12 @@
 #include <fstream>
 #include <sstream>
 #include <initializer_list>
+#include <vector>
+#include <algorithm>            //For std::search
+#include <cstring>              //For std::memchr/std::memmove/std::memcmp
+#include <cstdlib>              //For std::strtoll/std::strtoull/std::strtod
+#include <cctype>               //For std::isspace
+#include <type_traits>          //For std::enable_if/std::integral_constant/std::is_integral/std::is_floating_point/std::is_same
 #include "ics_exceptions.hpp"
 #include "pair.hpp"
 #include "heap_priority_queue.hpp"
@@ -146,6 +152,25 @@ class HashGraph {
 		//HashGraph<T> class instance variables
 		NodeMap node_values;
 		EdgeMap edge_values;
+
+		//Helper methods
+		void connect_edge (const NodeName& origin, const NodeName& destination, const T& value); //add_edge, without copying its arguments
+		template<class Visit>
+		static void for_each_line (std::ifstream& in_file, Visit visit);  //visit(begin,end) each line (null-terminated at end), read in large blocks
+
+		//Parse an edge value from (null-terminated) text as >> would: numbers
+		//  by strto*, strings as their first word, other types by >> (so are
+		//  char types, which >> reads as a character, and bool)
+		template<class U>
+		struct is_number : std::integral_constant<bool, std::is_arithmetic<U>::value && !std::is_same<U,bool>::value &&
+		                                                !std::is_same<U,char>::value && !std::is_same<U,signed char>::value && !std::is_same<U,unsigned char>::value> {};
+		static void parse_value (const char* text, std::string& value);
+		template<class U>
+		static auto parse_value (const char* text, U& value) -> typename std::enable_if<is_number<U>::value && std::is_integral<U>::value>::type;
+		template<class U>
+		static auto parse_value (const char* text, U& value) -> typename std::enable_if<std::is_floating_point<U>::value>::type;
+		template<class U>
+		static auto parse_value (const char* text, U& value) -> typename std::enable_if<!is_number<U>::value>::type;
 };
 
 
@@ -337,18 +362,7 @@ void HashGraph<T>::add_node (NodeName node_name) {
 //Add these node names and update edge_values and the LocalInfos of each node
 template<class T>
 void HashGraph<T>::add_edge (NodeName origin, NodeName destination, T value) {
-	Edge new_edge(origin, destination);
-
-	node_values[origin].connect(this);
-	node_values[destination].connect(this);
-
-	edge_values[new_edge] = value;
-
-	node_values[origin].out_edges.insert(new_edge);
-	node_values[destination].in_edges.insert(new_edge);
-
-	node_values[origin].out_nodes.insert(destination);
-	node_values[destination].in_nodes.insert(origin);
+	connect_edge(origin, destination, value);
 }
 
 
@@ -402,19 +416,56 @@ void HashGraph<T>::clear() {
 // (b) an origin node, destination node, and value (one triple per line,
 //       with the values separated by separator, on any number of lines)
 // Adds these nodes/edges to those currently in the graph
-//Hint: use split and istringstream (the extraction dual of ostreamstring)
+//The file is read in large blocks and each line is split in place; if the file
+//  can be reread (tellg/seekg), a first pass counts its node/edge lines (without
+//  splitting or hashing them), so node_values/edge_values are sized once
+//  instead of doubling as they fill.
+//A (non-empty) edge line without two separators raises GraphError.
 template<class T>
 void HashGraph<T>::load (std::ifstream& in_file, std::string separator) {
-	std::string line;
-	while(std::getline(in_file, line) && line != "NODESABOVEEDGESBELOW")
-		add_node(line);
-	while(std::getline(in_file, line)){
-		std::vector<std::string> splitted = ics::split(line, separator);
-		T t;
-		std::istringstream s(splitted[2]);
-		s >> t;
-		add_edge(splitted[0], splitted[1], t);
+	static const char   marker[] = "NODESABOVEEDGESBELOW";
+	static const size_t marker_length = sizeof(marker)-1;
+
+	std::streampos start = in_file.tellg();
+	if (start != std::streampos(-1)) {
+		int  nodes = 0, edges = 0;
+		bool in_edges = false;
+		for_each_line(in_file, [&](char* begin, char* end) {
+			if (in_edges)
+				edges += begin != end;
+			else if (size_t(end-begin) == marker_length && std::memcmp(begin, marker, marker_length) == 0)
+				in_edges = true;
+			else
+				++nodes;
+		});
+		in_file.clear();
+		in_file.seekg(start);
+		node_values.reserve(node_values.size() + nodes);
+		edge_values.reserve(edge_values.size() + edges);
 	}
+
+	bool     in_edges = false;
+	NodeName origin, destination;              //Reused: assign does not allocate once they are long enough
+	T        value;
+	for_each_line(in_file, [&](char* begin, char* end) {
+		if (!in_edges) {
+			if (size_t(end-begin) == marker_length && std::memcmp(begin, marker, marker_length) == 0)
+				in_edges = true;
+			else
+				node_values[origin.assign(begin, end)].connect(this);
+			return;
+		}
+		if (begin == end)
+			return;
+		char* first  = std::search(begin, end, separator.begin(), separator.end());
+		char* second = first == end ? end : std::search(first+separator.size(), end, separator.begin(), separator.end());
+		if (second == end)
+			throw GraphError("HashGraph<T>::load: edge line (" + std::string(begin, end) + ") needs origin" + separator + "destination" + separator + "value");
+		char* third = std::search(second+separator.size(), end, separator.begin(), separator.end());
+		*third = '\0';                            //Ignore anything after the value (as split did)
+		parse_value(second+separator.size(), value);
+		connect_edge(origin.assign(begin, first), destination.assign(first+separator.size(), second), value);
+	});
 }
 
 
@@ -427,7 +478,7 @@ void HashGraph<T>::store(std::ofstream& out_file, std::string separator) {
 		out_file << ele.first << "\n";
 	out_file << "NODESABOVEEDGESBELOW";
 	for (const auto &ele : edge_values)
-		out_file << "\n" << ele.first.first << "/" << ele.first.second << separator << ele.second;
+		out_file << "\n" << ele.first.first << separator << ele.first.second << separator << ele.second;
 }
 
 
@@ -478,6 +529,105 @@ std::ostream& operator<<(std::ostream& outs, const HashGraph<T>& g) {
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+//Look up each node once: references to LocalInfo stay valid as node_values
+//  grows (its rehashing relinks nodes, it does not copy them)
+template<class T>
+void HashGraph<T>::connect_edge (const NodeName& origin, const NodeName& destination, const T& value) {
+	Edge       new_edge(origin, destination);
+	LocalInfo& origin_info      = node_values[origin];
+	LocalInfo& destination_info = node_values[destination];
+
+	origin_info.connect(this);
+	destination_info.connect(this);
+
+	edge_values[new_edge] = value;
+
+	origin_info.out_edges.insert(new_edge);
+	destination_info.in_edges.insert(new_edge);
+
+	origin_info.out_nodes.insert(destination);
+	destination_info.in_nodes.insert(origin);
+}
+
+
+//Lines end at '\n' (which is replaced by '\0'), as for getline; a partial line
+//  at the end of a block is moved to the front of the buffer, which doubles
+//  if one line does not fit in it
+template<class T>
+template<class Visit>
+void HashGraph<T>::for_each_line (std::ifstream& in_file, Visit visit) {
+	std::vector<char> buffer(1 << 20);
+	size_t            kept = 0;                //Bytes of a partial line at the front of buffer
+	for (;;) {
+		if (kept == buffer.size()-1)
+			buffer.resize(2*buffer.size());
+		size_t wanted = buffer.size()-1 - kept;  //Leave room to null-terminate a last line
+		in_file.read(&buffer[kept], wanted);
+		size_t got  = in_file.gcount();
+		char*  line = &buffer[0];
+		char*  stop = line + kept + got;
+
+		for (char* newline; (newline = static_cast<char*>(std::memchr(line, '\n', stop-line))) != nullptr; line = newline+1) {
+			*newline = '\0';
+			visit(line, newline);
+		}
+
+		kept = stop - line;
+		if (got < wanted) {                      //End of file: the last line may lack its '\n'
+			if (kept > 0) {
+				*stop = '\0';
+				visit(line, stop);
+			}
+			return;
+		}
+		std::memmove(&buffer[0], line, kept);
+	}
+}
+
+
+template<class T>
+void HashGraph<T>::parse_value (const char* text, std::string& value) {
+	while (std::isspace(static_cast<unsigned char>(*text)))
+		++text;
+	const char* end = text;
+	while (*end != '\0' && !std::isspace(static_cast<unsigned char>(*end)))
+		++end;
+	value.assign(text, end);
+}
+
+
+template<class T>
+template<class U>
+auto HashGraph<T>::parse_value (const char* text, U& value) -> typename std::enable_if<is_number<U>::value && std::is_integral<U>::value>::type {
+	char* end;
+	value = std::is_signed<U>::value ? U(std::strtoll(text, &end, 10)) : U(std::strtoull(text, &end, 10));
+	if (end == text)
+		throw GraphError("HashGraph<T>::load: edge value (" + std::string(text) + ") is not an integer");
+}
+
+
+template<class T>
+template<class U>
+auto HashGraph<T>::parse_value (const char* text, U& value) -> typename std::enable_if<std::is_floating_point<U>::value>::type {
+	char* end;
+	value = U(std::strtod(text, &end));
+	if (end == text)
+		throw GraphError("HashGraph<T>::load: edge value (" + std::string(text) + ") is not a number");
+}
+
+
+template<class T>
+template<class U>
+auto HashGraph<T>::parse_value (const char* text, U& value) -> typename std::enable_if<!is_number<U>::value>::type {
+	std::istringstream s(text);
+	s >> value;
+}
+
+
 }
 
 #endif /* HASH_GRAPH_HPP_ */
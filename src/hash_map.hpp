@@ -5,7 +5,11 @@
 #include <iostream>
 #include <sstream>
 #include <initializer_list>
+#include <algorithm>            //For std::max
+#include <limits>               //For std::numeric_limits (the most bins an int counts)
 #include "ics_exceptions.hpp"
+#include "functor.hpp"
+#include "bloom_filter.hpp"     //For the optional filter of missing keys
 #include "pair.hpp"
 
 
@@ -16,8 +20,9 @@ namespace ics {
 //If thash is defaulted to nullptr in the template, then a constructor must supply chash.
 //If both thash and chash are supplied, then they must be the same (by ==) function.
 //If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
+//Instead, HASH can be a functor type whose HASH()(a) is the hash value (then neither thash nor chash is supplied).
 //The (unique) non-nullptr value supplied by thash/chash is stored in the instance variable hash.
-template<class KEY,class T, int (*thash)(const KEY& a) = nullptr> class HashMap {
+template<class KEY,class T, int (*thash)(const KEY& a) = nullptr, class HASH = void> class HashMap {
   public:
     typedef ics::pair<KEY,T>   Entry;
 
@@ -26,7 +31,7 @@ template<class KEY,class T, int (*thash)(const KEY& a) = nullptr> class HashMap
 
     HashMap          (double the_load_threshold = 1.0, int (*chash)(const KEY& a) = nullptr);
     explicit HashMap (int initial_bins, double the_load_threshold = 1.0, int (*chash)(const KEY& k) = nullptr);
-    HashMap          (const HashMap<KEY,T,thash>& to_copy, double the_load_threshold = 1.0, int (*chash)(const KEY& a) = nullptr);
+    HashMap          (const HashMap<KEY,T,thash,HASH>& to_copy, double the_load_threshold = 1.0, int (*chash)(const KEY& a) = nullptr);
     explicit HashMap (const std::initializer_list<Entry>& il, double the_load_threshold = 1.0, int (*chash)(const KEY& a) = nullptr);
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
@@ -46,6 +51,14 @@ template<class KEY,class T, int (*thash)(const KEY& a) = nullptr> class HashMap
     T    put   (const KEY& key, const T& value);
     T    erase (const KEY& key);
     void clear ();
+    void reserve (int n);   //Grow now (rehashing at most once) so n key->values fit within load_threshold
+
+    //Keep a BloomFilter of the keys' hashes, so most has_key/erase/[] const
+    //  misses skip the bin scan; it is rebuilt whenever the table grows
+    //  (erasing leaves stale bits: more false positives, never a wrong answer)
+    void enable_filter  (double false_positive_rate = 0.01, long max_bytes = 0);
+    void disable_filter ();
+    bool filtered       () const;
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
     template <class Iterable>
@@ -56,12 +69,12 @@ template<class KEY,class T, int (*thash)(const KEY& a) = nullptr> class HashMap
 
     T&       operator [] (const KEY&);
     const T& operator [] (const KEY&) const;
-    HashMap<KEY,T,thash>& operator = (const HashMap<KEY,T,thash>& rhs);
-    bool operator == (const HashMap<KEY,T,thash>& rhs) const;
-    bool operator != (const HashMap<KEY,T,thash>& rhs) const;
+    HashMap<KEY,T,thash,HASH>& operator = (const HashMap<KEY,T,thash,HASH>& rhs);
+    bool operator == (const HashMap<KEY,T,thash,HASH>& rhs) const;
+    bool operator != (const HashMap<KEY,T,thash,HASH>& rhs) const;
 
-    template<class KEY2,class T2, int (*hash2)(const KEY2& a)>
-    friend std::ostream& operator << (std::ostream& outs, const HashMap<KEY2,T2,hash2>& m);
+    template<class KEY2,class T2, int (*hash2)(const KEY2& a), class HASH2>
+    friend std::ostream& operator << (std::ostream& outs, const HashMap<KEY2,T2,hash2,HASH2>& m);
 
 
 
@@ -77,31 +90,31 @@ template<class KEY,class T, int (*thash)(const KEY& a) = nullptr> class HashMap
         ~Iterator();
         Entry       erase();
         std::string str  () const;
-        HashMap<KEY,T,thash>::Iterator& operator ++ ();
-        HashMap<KEY,T,thash>::Iterator  operator ++ (int);
-        bool operator == (const HashMap<KEY,T,thash>::Iterator& rhs) const;
-        bool operator != (const HashMap<KEY,T,thash>::Iterator& rhs) const;
+        HashMap<KEY,T,thash,HASH>::Iterator& operator ++ ();
+        HashMap<KEY,T,thash,HASH>::Iterator  operator ++ (int);
+        bool operator == (const HashMap<KEY,T,thash,HASH>::Iterator& rhs) const;
+        bool operator != (const HashMap<KEY,T,thash,HASH>::Iterator& rhs) const;
         Entry& operator *  () const;
         Entry* operator -> () const;
-        friend std::ostream& operator << (std::ostream& outs, const HashMap<KEY,T,thash>::Iterator& i) {
+        friend std::ostream& operator << (std::ostream& outs, const HashMap<KEY,T,thash,HASH>::Iterator& i) {
           outs << i.str(); //Use the same meaning as the debugging .str() method
           return outs;
         }
-        friend Iterator HashMap<KEY,T,thash>::begin () const;
-        friend Iterator HashMap<KEY,T,thash>::end   () const;
+        friend Iterator HashMap<KEY,T,thash,HASH>::begin () const;
+        friend Iterator HashMap<KEY,T,thash,HASH>::end   () const;
 
       private:
         //If can_erase is false, current indexes the "next" value (must ++ to reach it)
-        Cursor                current; //Bin Index and Cursor; stop: LN* == nullptr
-        HashMap<KEY,T,thash>* ref_map;
-        int                   expected_mod_count;
-        bool                  can_erase = true;
+        Cursor                     current; //Bin Index and Cursor; stop: LN* == nullptr
+        HashMap<KEY,T,thash,HASH>* ref_map;
+        int                        expected_mod_count;
+        bool                       can_erase = true;
 
         //Helper methods
         void advance_cursors();
 
         //Called in friends begin/end
-        Iterator(HashMap<KEY,T,thash>* iterate_over, bool from_begin);
+        Iterator(HashMap<KEY,T,thash,HASH>* iterate_over, bool from_begin);
     };
 
 
@@ -120,21 +133,26 @@ template<class KEY,class T, int (*thash)(const KEY& a) = nullptr> class HashMap
       LN*   next;
   };
 
+  static_assert(std::is_void<HASH>::value || thash == nullptr, "HashMap: specify thash or HASH, not both");
   int (*hash)(const KEY& k);  //Hashing function used (from template or constructor)
   LN** map      = nullptr;    //Pointer to array of pointers: each bin stores a list with a trailer node
   double load_threshold;      //used/bins <= load_threshold
   int bins      = 1;          //# bins in array (should start at 1 so hash_compress doesn't % 0)
   int used      = 0;          //Cache for number of key->value pairs in the hash table
   int mod_count = 0;          //For sensing concurrent modification
+  BloomFilter* filter = nullptr; //Optional: see enable_filter
 
 
   //Helper methods
+  int   hash_value           (const KEY& key)          const;  //hash function (unranged)
   int   hash_compress        (const KEY& key)          const;  //hash function ranged to [0,bins-1]
   LN*   find_key             (int bin, const KEY& key) const;  //Returns reference to key's node or nullptr
+  LN*   find                 (const KEY& key)          const;  //Consult filter (if any), then key's bin
   LN*   copy_list            (LN*   l)                 const;  //Copy the keys/values in a bin (order irrelevant)
   LN**  copy_hash_table      (LN** ht, int bins)       const;  //Copy the bins/keys/values in ht tree (order in bins irrelevant)
 
-  void  ensure_load_threshold(int new_used);                   //Reallocate if load_factor > load_threshold
+  void  ensure_load_threshold(int new_used);                   //Reallocate (doubling bins until new_used fits) if load_factor > load_threshold
+  void  rebuild_filter       ();                               //Size filter for bins*load_threshold values and add them
   void  delete_hash_table    (LN**& ht, int bins);             //Deallocate all LN in ht (and the ht itself; ht == nullptr)
 };
 
@@ -147,18 +165,19 @@ template<class KEY,class T, int (*thash)(const KEY& a) = nullptr> class HashMap
 
 //Destructor/Constructors
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::~HashMap() {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+HashMap<KEY,T,thash,HASH>::~HashMap() {
   delete_hash_table(map,bins);
+  delete filter;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::HashMap(double the_load_threshold, int (*chash)(const KEY& k))
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+HashMap<KEY,T,thash,HASH>::HashMap(double the_load_threshold, int (*chash)(const KEY& k))
 : hash(thash != nullptr ? thash : chash), load_threshold(the_load_threshold) {
-  if (hash == nullptr)
+  if (hash == nullptr && std::is_void<HASH>::value)
     throw TemplateFunctionError("HashMap::default constructor: neither specified");
-  if (thash != nullptr && chash != nullptr && thash != chash)
+  if ((thash != nullptr || !std::is_void<HASH>::value) && chash != nullptr && thash != chash)
     throw TemplateFunctionError("HashMap::default constructor: both specified and different");
 
   map = new LN*[bins];
@@ -167,12 +186,12 @@ HashMap<KEY,T,thash>::HashMap(double the_load_threshold, int (*chash)(const KEY&
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::HashMap(int initial_bins, double the_load_threshold, int (*chash)(const KEY& k))
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+HashMap<KEY,T,thash,HASH>::HashMap(int initial_bins, double the_load_threshold, int (*chash)(const KEY& k))
 : hash(thash != nullptr ? thash : chash), bins(initial_bins), load_threshold(the_load_threshold) {
-  if (hash == nullptr)
+  if (hash == nullptr && std::is_void<HASH>::value)
     throw TemplateFunctionError("HashMap::length constructor: neither specified");
-  if (thash != nullptr && chash != nullptr && thash != chash)
+  if ((thash != nullptr || !std::is_void<HASH>::value) && chash != nullptr && thash != chash)
     throw TemplateFunctionError("HashMap::length constructor: both specified and different");
 
   if (bins < 1)
@@ -183,12 +202,12 @@ HashMap<KEY,T,thash>::HashMap(int initial_bins, double the_load_threshold, int (
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::HashMap(const HashMap<KEY,T,thash>& to_copy, double the_load_threshold, int (*chash)(const KEY& a))
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+HashMap<KEY,T,thash,HASH>::HashMap(const HashMap<KEY,T,thash,HASH>& to_copy, double the_load_threshold, int (*chash)(const KEY& a))
 : hash(thash != nullptr ? thash : chash), load_threshold(the_load_threshold), bins(to_copy.bins) {
   if (hash == nullptr)
     hash = to_copy.hash;//throw TemplateFunctionError("HashMap::copy constructor: neither specified");
-  if (thash != nullptr && chash != nullptr && thash != chash)
+  if ((thash != nullptr || !std::is_void<HASH>::value) && chash != nullptr && thash != chash)
     throw TemplateFunctionError("HashMap::copy constructor: both specified and different");
 
   if (hash == to_copy.hash && (double)to_copy.size()/to_copy.bins <= the_load_threshold) {
@@ -204,15 +223,18 @@ HashMap<KEY,T,thash>::HashMap(const HashMap<KEY,T,thash>& to_copy, double the_lo
       for (LN* c = to_copy.map[b]; c->next!=nullptr; c=c->next)
         put(c->value.first,c->value.second);
   }
+
+  if (to_copy.filter != nullptr)
+    enable_filter(to_copy.filter->false_positive_rate(), to_copy.filter->max_bytes());
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::HashMap(const std::initializer_list<Entry>& il, double the_load_threshold, int (*chash)(const KEY& k))
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+HashMap<KEY,T,thash,HASH>::HashMap(const std::initializer_list<Entry>& il, double the_load_threshold, int (*chash)(const KEY& k))
 : hash(thash != nullptr ? thash : chash), load_threshold(the_load_threshold), bins(std::max(1,int(il.size()/the_load_threshold))) {
-  if (hash == nullptr)
+  if (hash == nullptr && std::is_void<HASH>::value)
     throw TemplateFunctionError("HashMap::initializer_list constructor: neither specified");
-  if (thash != nullptr && chash != nullptr && thash != chash)
+  if ((thash != nullptr || !std::is_void<HASH>::value) && chash != nullptr && thash != chash)
     throw TemplateFunctionError("HashMap::initializer_list constructor: both specified and different");
 
   map = new LN*[bins];
@@ -224,13 +246,13 @@ HashMap<KEY,T,thash>::HashMap(const std::initializer_list<Entry>& il, double the
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
 template <class Iterable>
-HashMap<KEY,T,thash>::HashMap(const Iterable& i, double the_load_threshold, int (*chash)(const KEY& k))
+HashMap<KEY,T,thash,HASH>::HashMap(const Iterable& i, double the_load_threshold, int (*chash)(const KEY& k))
 : hash(thash != nullptr ? thash : chash), load_threshold(the_load_threshold), bins(std::max(1,int(i.size()/the_load_threshold))) {
-  if (hash == nullptr)
+  if (hash == nullptr && std::is_void<HASH>::value)
     throw TemplateFunctionError("HashMap::Iterable constructor: neither specified");
-  if (thash != nullptr && chash != nullptr && thash != chash)
+  if ((thash != nullptr || !std::is_void<HASH>::value) && chash != nullptr && thash != chash)
     throw TemplateFunctionError("HashMap::Iterable constructor: both specified and different");
 
   map = new LN*[bins];
@@ -246,26 +268,26 @@ HashMap<KEY,T,thash>::HashMap(const Iterable& i, double the_load_threshold, int
 //
 //Queries
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::empty() const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool HashMap<KEY,T,thash,HASH>::empty() const {
   return used == 0;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-int HashMap<KEY,T,thash>::size() const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int HashMap<KEY,T,thash,HASH>::size() const {
   return used;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::has_key (const KEY& key) const {
-  return find_key(hash_compress(key),key) != nullptr;
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool HashMap<KEY,T,thash,HASH>::has_key (const KEY& key) const {
+  return find(key) != nullptr;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::has_value (const T& value) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool HashMap<KEY,T,thash,HASH>::has_value (const T& value) const {
   for (int b=0; b<bins; ++b)
     for (LN* c = map[b]; c->next!=nullptr; c=c->next)
       if (value == c->value.second)
@@ -275,8 +297,8 @@ bool HashMap<KEY,T,thash>::has_value (const T& value) const {
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-std::string HashMap<KEY,T,thash>::str() const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+std::string HashMap<KEY,T,thash,HASH>::str() const {
   std::ostringstream answer;
   answer << "HashMap[";
   if (bins != 0) {
@@ -297,8 +319,8 @@ std::string HashMap<KEY,T,thash>::str() const {
 //
 //Commands
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-T HashMap<KEY,T,thash>::put(const KEY& key, const T& value) {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+T HashMap<KEY,T,thash,HASH>::put(const KEY& key, const T& value) {
   int bin = hash_compress(key);
   T to_return;
   LN* c = find_key(bin,key);
@@ -311,6 +333,8 @@ T HashMap<KEY,T,thash>::put(const KEY& key, const T& value) {
     ++used;
     bin = hash_compress(key);                      //bins may have changed in ensure_load_threshold!
     map[bin] = new LN(Entry(key,value),map[bin]);  //easy to put at front: bin LNs unordered
+    if (filter != nullptr)
+      filter->add(hash_value(key));
   }
 
   ++mod_count;
@@ -318,9 +342,9 @@ T HashMap<KEY,T,thash>::put(const KEY& key, const T& value) {
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-T HashMap<KEY,T,thash>::erase(const KEY& key) {
-  LN* c = find_key(hash_compress(key),key);
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+T HashMap<KEY,T,thash,HASH>::erase(const KEY& key) {
+  LN* c = find(key);
   if (c == nullptr) {
     std::ostringstream answer;
     answer << "HashMap::erase: key(" << key << ") not in Map";
@@ -337,8 +361,8 @@ T HashMap<KEY,T,thash>::erase(const KEY& key) {
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-void HashMap<KEY,T,thash>::clear() {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void HashMap<KEY,T,thash,HASH>::clear() {
   //Leave Trailers in bins
   for (int b=0; b<bins; ++b) {
     LN* c=map[b];
@@ -349,15 +373,48 @@ void HashMap<KEY,T,thash>::clear() {
     }
     map[b] = c;
   }
+  if (filter != nullptr)
+    filter->clear();
 
   used = 0;
   ++mod_count;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void HashMap<KEY,T,thash,HASH>::reserve(int n) {
+  int old_bins = bins;
+  ensure_load_threshold(n);
+  if (bins != old_bins)
+    ++mod_count;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void HashMap<KEY,T,thash,HASH>::enable_filter(double false_positive_rate, long max_bytes) {
+  BloomFilter* made = new BloomFilter(0, false_positive_rate, max_bytes);
+  delete filter;
+  filter = made;
+  rebuild_filter();
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void HashMap<KEY,T,thash,HASH>::disable_filter() {
+  delete filter;
+  filter = nullptr;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool HashMap<KEY,T,thash,HASH>::filtered() const {
+  return filter != nullptr;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
 template<class Iterable>
-int HashMap<KEY,T,thash>::put_all(const Iterable& i) {
+int HashMap<KEY,T,thash,HASH>::put_all(const Iterable& i) {
   int count = 0;
   for (const Entry& m_entry : i) {
     ++count;
@@ -372,8 +429,8 @@ int HashMap<KEY,T,thash>::put_all(const Iterable& i) {
 //
 //Operators
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-T& HashMap<KEY,T,thash>::operator [] (const KEY& key) {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+T& HashMap<KEY,T,thash,HASH>::operator [] (const KEY& key) {
   int bin = hash_compress(key);
   LN* c = find_key(bin,key);
   if (c != nullptr)
@@ -385,14 +442,15 @@ T& HashMap<KEY,T,thash>::operator [] (const KEY& key) {
   bin = hash_compress(key);                    //bins may have changed in ensure_load_threshold!
 
   map[bin] = new LN(Entry(key,T()),map[bin]);  //easy to put at front: bin LNs unordered
+  if (filter != nullptr)
+    filter->add(hash_value(key));
   return map[bin]->value.second;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-const T& HashMap<KEY,T,thash>::operator [] (const KEY& key) const {
-  int bin = hash_compress(key);
-  LN* c = find_key(bin,key);
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+const T& HashMap<KEY,T,thash,HASH>::operator [] (const KEY& key) const {
+  LN* c = find(key);
   if (c != nullptr)
     return c->value.second;
 
@@ -402,8 +460,8 @@ const T& HashMap<KEY,T,thash>::operator [] (const KEY& key) const {
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>& HashMap<KEY,T,thash>::operator = (const HashMap<KEY,T,thash>& rhs) {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+HashMap<KEY,T,thash,HASH>& HashMap<KEY,T,thash,HASH>::operator = (const HashMap<KEY,T,thash,HASH>& rhs) {
   if (this == &rhs)
     return *this;
 
@@ -418,13 +476,15 @@ HashMap<KEY,T,thash>& HashMap<KEY,T,thash>::operator = (const HashMap<KEY,T,thas
       for (LN* c = rhs.map[b]; c->next!=nullptr; c=c->next)
         put(c->value.first,c->value.second);
   }
+  if (filter != nullptr)
+    rebuild_filter();
   ++mod_count;
   return *this;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::operator == (const HashMap<KEY,T,thash>& rhs) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool HashMap<KEY,T,thash,HASH>::operator == (const HashMap<KEY,T,thash,HASH>& rhs) const {
   if (this == &rhs)
     return true;
   if (used != rhs.size())
@@ -439,19 +499,19 @@ bool HashMap<KEY,T,thash>::operator == (const HashMap<KEY,T,thash>& rhs) const {
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::operator != (const HashMap<KEY,T,thash>& rhs) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool HashMap<KEY,T,thash,HASH>::operator != (const HashMap<KEY,T,thash,HASH>& rhs) const {
   return !(*this == rhs);
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-std::ostream& operator << (std::ostream& outs, const HashMap<KEY,T,thash>& m) {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+std::ostream& operator << (std::ostream& outs, const HashMap<KEY,T,thash,HASH>& m) {
   outs << "map[";
 
   int printed = 0;
   for (int b=0; b<m.bins; ++b)
-    for (typename HashMap<KEY,T,thash>::LN* c = m.map[b]; c->next!=nullptr; c = c->next)
+    for (typename HashMap<KEY,T,thash,HASH>::LN* c = m.map[b]; c->next!=nullptr; c = c->next)
       outs << (printed++ == 0? "" : ",") << c->value.first << "->" << c->value.second;
 
   outs << "]";
@@ -463,15 +523,15 @@ std::ostream& operator << (std::ostream& outs, const HashMap<KEY,T,thash>& m) {
 //
 //Iterator constructors
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-auto HashMap<KEY,T,thash>::begin () const -> HashMap<KEY,T,thash>::Iterator {
-  return Iterator(const_cast<HashMap<KEY,T,thash>*>(this),true);
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto HashMap<KEY,T,thash,HASH>::begin () const -> HashMap<KEY,T,thash,HASH>::Iterator {
+  return Iterator(const_cast<HashMap<KEY,T,thash,HASH>*>(this),true);
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-auto HashMap<KEY,T,thash>::end () const -> HashMap<KEY,T,thash>::Iterator {
-  return Iterator(const_cast<HashMap<KEY,T,thash>*>(this),false);
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto HashMap<KEY,T,thash,HASH>::end () const -> HashMap<KEY,T,thash,HASH>::Iterator {
+  return Iterator(const_cast<HashMap<KEY,T,thash,HASH>*>(this),false);
 }
 
 
@@ -479,14 +539,20 @@ auto HashMap<KEY,T,thash>::end () const -> HashMap<KEY,T,thash>::Iterator {
 //
 //Private helper methods
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-int HashMap<KEY,T,thash>::hash_compress (const KEY& key) const {
-  return abs(hash(key)) % bins;
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int HashMap<KEY,T,thash,HASH>::hash_value (const KEY& key) const {
+  return Functor<HASH>::call(thash != nullptr ? thash : hash, key);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int HashMap<KEY,T,thash,HASH>::hash_compress (const KEY& key) const {
+  return abs(hash_value(key)) % bins;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-typename HashMap<KEY,T,thash>::LN* HashMap<KEY,T,thash>::find_key (int bin, const KEY& key) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+typename HashMap<KEY,T,thash,HASH>::LN* HashMap<KEY,T,thash,HASH>::find_key (int bin, const KEY& key) const {
   for (LN* c = map[bin]; c->next!=nullptr; c=c->next)
     if (key == c->value.first)
       return c;
@@ -495,8 +561,18 @@ typename HashMap<KEY,T,thash>::LN* HashMap<KEY,T,thash>::find_key (int bin, cons
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-typename HashMap<KEY,T,thash>::LN* HashMap<KEY,T,thash>::copy_list (LN* l) const {
+//A filter miss answers without touching the bins
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+typename HashMap<KEY,T,thash,HASH>::LN* HashMap<KEY,T,thash,HASH>::find (const KEY& key) const {
+  int h = hash_value(key);
+  if (filter != nullptr && !filter->might_contain(h))
+    return nullptr;
+  return find_key(abs(h) % bins, key);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+typename HashMap<KEY,T,thash,HASH>::LN* HashMap<KEY,T,thash,HASH>::copy_list (LN* l) const {
   //  //Recursive
   //  if (l == nullptr)
   //    return nullptr;
@@ -515,8 +591,8 @@ typename HashMap<KEY,T,thash>::LN* HashMap<KEY,T,thash>::copy_list (LN* l) const
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-typename HashMap<KEY,T,thash>::LN** HashMap<KEY,T,thash>::copy_hash_table (LN** ht, int bins) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+typename HashMap<KEY,T,thash,HASH>::LN** HashMap<KEY,T,thash,HASH>::copy_hash_table (LN** ht, int bins) const {
   LN** answer = new LN*[bins];
   for (int b=0; b<bins; ++b)
      answer[b] = copy_list(ht[b]);
@@ -524,15 +600,17 @@ typename HashMap<KEY,T,thash>::LN** HashMap<KEY,T,thash>::copy_hash_table (LN**
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-void HashMap<KEY,T,thash>::ensure_load_threshold(int new_used) {
-  if (double(new_used)/double(bins) <= load_threshold)
-    return;
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void HashMap<KEY,T,thash,HASH>::ensure_load_threshold(int new_used) {
+  if (double(new_used)/double(bins) <= load_threshold || bins > std::numeric_limits<int>::max()/2)
+    return;                              //Fits (or bins cannot double without overflowing)
 
   LN** old_map  = map;
   int  old_bins = bins;
 
   bins = 2*old_bins;
+  while (double(new_used)/double(bins) > load_threshold && bins <= std::numeric_limits<int>::max()/2)
+    bins *= 2;
   map = new LN*[bins];
 
   for (int b=0; b<bins; ++b)
@@ -551,11 +629,24 @@ void HashMap<KEY,T,thash>::ensure_load_threshold(int new_used) {
   }
 
   delete [] old_map;
+
+  if (filter != nullptr)
+    rebuild_filter();
+}
+
+
+//Sized for the most keys the table holds before it next grows
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void HashMap<KEY,T,thash,HASH>::rebuild_filter() {
+  filter->resize(std::max(used, int(bins*load_threshold)));
+  for (int b=0; b<bins; ++b)
+    for (LN* c=map[b]; c->next!=nullptr; c=c->next)
+      filter->add(hash_value(c->value.first));
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-void HashMap<KEY,T,thash>::delete_hash_table (LN**& ht, int bins) {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void HashMap<KEY,T,thash,HASH>::delete_hash_table (LN**& ht, int bins) {
   for (int b=0; b<bins; ++b)
     for (LN* c=ht[b]; c!=nullptr; /*See body*/) {
       LN* to_delete = c;
@@ -575,8 +666,8 @@ void HashMap<KEY,T,thash>::delete_hash_table (LN**& ht, int bins) {
 //
 //Iterator class definitions
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-void HashMap<KEY,T,thash>::Iterator::advance_cursors(){
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void HashMap<KEY,T,thash,HASH>::Iterator::advance_cursors(){
   if (current.second != nullptr && current.second->next != nullptr && current.second->next->next != nullptr) {
     current.second = current.second->next;
     return;
@@ -594,8 +685,8 @@ void HashMap<KEY,T,thash>::Iterator::advance_cursors(){
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::Iterator::Iterator(HashMap<KEY,T,thash>* iterate_over, bool from_begin)
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+HashMap<KEY,T,thash,HASH>::Iterator::Iterator(HashMap<KEY,T,thash,HASH>* iterate_over, bool from_begin)
 : ref_map(iterate_over), expected_mod_count(ref_map->mod_count) {
   current = Cursor(-1,nullptr);
   if (from_begin)
@@ -603,13 +694,13 @@ HashMap<KEY,T,thash>::Iterator::Iterator(HashMap<KEY,T,thash>* iterate_over, boo
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::Iterator::~Iterator()
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+HashMap<KEY,T,thash,HASH>::Iterator::~Iterator()
 {}
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-auto HashMap<KEY,T,thash>::Iterator::erase() -> Entry {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto HashMap<KEY,T,thash,HASH>::Iterator::erase() -> Entry {
   if (expected_mod_count != ref_map->mod_count)
     throw ConcurrentModificationError("HashMap::Iterator::erase");
   if (!can_erase)
@@ -631,15 +722,15 @@ auto HashMap<KEY,T,thash>::Iterator::erase() -> Entry {
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-std::string HashMap<KEY,T,thash>::Iterator::str() const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+std::string HashMap<KEY,T,thash,HASH>::Iterator::str() const {
   std::ostringstream answer;
   answer << ref_map->str() << "(current=" << current.first << "/" << current.second << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
   return answer.str();
 }
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-auto  HashMap<KEY,T,thash>::Iterator::operator ++ () -> HashMap<KEY,T,thash>::Iterator& {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto  HashMap<KEY,T,thash,HASH>::Iterator::operator ++ () -> HashMap<KEY,T,thash,HASH>::Iterator& {
   if (expected_mod_count != ref_map->mod_count)
     throw ConcurrentModificationError("HashMap::Iterator::operator ++");
 
@@ -654,8 +745,8 @@ auto  HashMap<KEY,T,thash>::Iterator::operator ++ () -> HashMap<KEY,T,thash>::It
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-auto  HashMap<KEY,T,thash>::Iterator::operator ++ (int) -> HashMap<KEY,T,thash>::Iterator {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto  HashMap<KEY,T,thash,HASH>::Iterator::operator ++ (int) -> HashMap<KEY,T,thash,HASH>::Iterator {
   if (expected_mod_count != ref_map->mod_count)
     throw ConcurrentModificationError("HashMap::Iterator::operator ++(int)");
 
@@ -672,8 +763,8 @@ auto  HashMap<KEY,T,thash>::Iterator::operator ++ (int) -> HashMap<KEY,T,thash>:
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::Iterator::operator == (const HashMap<KEY,T,thash>::Iterator& rhs) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool HashMap<KEY,T,thash,HASH>::Iterator::operator == (const HashMap<KEY,T,thash,HASH>::Iterator& rhs) const {
   const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
   if (rhsASI == 0)
     throw IteratorTypeError("HashMap::Iterator::operator ==");
@@ -686,8 +777,8 @@ bool HashMap<KEY,T,thash>::Iterator::operator == (const HashMap<KEY,T,thash>::It
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::Iterator::operator != (const HashMap<KEY,T,thash>::Iterator& rhs) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool HashMap<KEY,T,thash,HASH>::Iterator::operator != (const HashMap<KEY,T,thash,HASH>::Iterator& rhs) const {
   const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
   if (rhsASI == 0)
     throw IteratorTypeError("HashMap::Iterator::operator !=");
@@ -700,8 +791,8 @@ bool HashMap<KEY,T,thash>::Iterator::operator != (const HashMap<KEY,T,thash>::It
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-pair<KEY,T>& HashMap<KEY,T,thash>::Iterator::operator *() const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+pair<KEY,T>& HashMap<KEY,T,thash,HASH>::Iterator::operator *() const {
   if (expected_mod_count !=
       ref_map->mod_count)
     throw ConcurrentModificationError("HashMap::Iterator::operator *");
@@ -712,8 +803,8 @@ pair<KEY,T>& HashMap<KEY,T,thash>::Iterator::operator *() const {
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-pair<KEY,T>* HashMap<KEY,T,thash>::Iterator::operator ->() const {
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+pair<KEY,T>* HashMap<KEY,T,thash,HASH>::Iterator::operator ->() const {
   if (expected_mod_count !=
       ref_map->mod_count)
     throw ConcurrentModificationError("HashMap::Iterator::operator *");
@@ -5,7 +5,11 @@
 #include <iostream>
 #include <sstream>
 #include <initializer_list>
+#include <algorithm>            //For std::max
+#include <limits>               //For std::numeric_limits (the most bins an int counts)
 #include "ics_exceptions.hpp"
+#include "functor.hpp"
+#include "bloom_filter.hpp"     //For the optional filter of missing keys
 #include "pair.hpp"
 
 
@@ -16,15 +20,16 @@ namespace ics {
 //If thash is defaulted to nullptr in the template, then a constructor must supply chash.
 //If both thash and chash are supplied, then they must be the same (by ==) function.
 //If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
+//Instead, HASH can be a functor type whose HASH()(a) is the hash value (then neither thash nor chash is supplied).
 //The (unique) non-nullptr value supplied by thash/chash is stored in the instance variable hash.
-template<class T, int (*thash)(const T& a) = nullptr> class HashSet {
+template<class T, int (*thash)(const T& a) = nullptr, class HASH = void> class HashSet {
   public:
     //Destructor/Constructors
     ~HashSet ();
 
     HashSet (double the_load_threshold = 1.0, int (*chash)(const T& a) = nullptr);
     explicit HashSet (int initial_bins, double the_load_threshold = 1.0, int (*chash)(const T& k) = nullptr);
-    HashSet (const HashSet<T,thash>& to_copy, double the_load_threshold = 1.0, int (*chash)(const T& a) = nullptr);
+    HashSet (const HashSet<T,thash,HASH>& to_copy, double the_load_threshold = 1.0, int (*chash)(const T& a) = nullptr);
     explicit HashSet (const std::initializer_list<T>& il, double the_load_threshold = 1.0, int (*chash)(const T& a) = nullptr);
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
@@ -47,6 +52,14 @@ template<class T, int (*thash)(const T& a) = nullptr> class HashSet {
     int  insert (const T& element);
     int  erase  (const T& element);
     void clear  ();
+    void reserve(int n);   //Grow now (rehashing at most once) so n values fit within load_threshold
+
+    //Keep a BloomFilter of the values' hashes, so most contains/erase misses
+    //  skip the bin scan; it is rebuilt whenever the table grows (erasing
+    //  leaves stale bits: more false positives, never a wrong answer)
+    void enable_filter  (double false_positive_rate = 0.01, long max_bytes = 0);
+    void disable_filter ();
+    bool filtered       () const;
 
     //Iterable class must support "for" loop: .begin()/.end() and prefix ++ on returned result
 
@@ -61,16 +74,19 @@ template<class T, int (*thash)(const T& a) = nullptr> class HashSet {
 
 
     //Operators
-    HashSet<T,thash>& operator = (const HashSet<T,thash>& rhs);
-    bool operator == (const HashSet<T,thash>& rhs) const;
-    bool operator != (const HashSet<T,thash>& rhs) const;
-    bool operator <= (const HashSet<T,thash>& rhs) const;
-    bool operator <  (const HashSet<T,thash>& rhs) const;
-    bool operator >= (const HashSet<T,thash>& rhs) const;
-    bool operator >  (const HashSet<T,thash>& rhs) const;
+    HashSet<T,thash,HASH>& operator = (const HashSet<T,thash,HASH>& rhs);
+    HashSet<T,thash,HASH>  operator | (const HashSet<T,thash,HASH>& rhs) const;  //union
+    HashSet<T,thash,HASH>  operator & (const HashSet<T,thash,HASH>& rhs) const;  //intersection
+    HashSet<T,thash,HASH>  operator - (const HashSet<T,thash,HASH>& rhs) const;  //difference
+    bool operator == (const HashSet<T,thash,HASH>& rhs) const;
+    bool operator != (const HashSet<T,thash,HASH>& rhs) const;
+    bool operator <= (const HashSet<T,thash,HASH>& rhs) const;
+    bool operator <  (const HashSet<T,thash,HASH>& rhs) const;
+    bool operator >= (const HashSet<T,thash,HASH>& rhs) const;
+    bool operator >  (const HashSet<T,thash,HASH>& rhs) const;
 
-    template<class T2, int (hash2) (const T2& a)>
-    friend std::ostream& operator << (std::ostream& outs, const HashSet<T2,hash2>& s);
+    template<class T2, int (hash2) (const T2& a), class HASH2>
+    friend std::ostream& operator << (std::ostream& outs, const HashSet<T2,hash2,HASH2>& s);
 
 
 
@@ -82,35 +98,35 @@ template<class T, int (*thash)(const T& a) = nullptr> class HashSet {
       public:
         typedef pair<int,LN*> Cursor;
 
-        //Private constructor called in begin/end, which are friends of HashSet<T,thash>
+        //Private constructor called in begin/end, which are friends of HashSet<T,thash,HASH>
         ~Iterator();
         T           erase();
         std::string str  () const;
-        HashSet<T,thash>::Iterator& operator ++ ();
-        HashSet<T,thash>::Iterator  operator ++ (int);
-        bool operator == (const HashSet<T,thash>::Iterator& rhs) const;
-        bool operator != (const HashSet<T,thash>::Iterator& rhs) const;
+        HashSet<T,thash,HASH>::Iterator& operator ++ ();
+        HashSet<T,thash,HASH>::Iterator  operator ++ (int);
+        bool operator == (const HashSet<T,thash,HASH>::Iterator& rhs) const;
+        bool operator != (const HashSet<T,thash,HASH>::Iterator& rhs) const;
         T& operator *  () const;
         T* operator -> () const;
-        friend std::ostream& operator << (std::ostream& outs, const HashSet<T,thash>::Iterator& i) {
+        friend std::ostream& operator << (std::ostream& outs, const HashSet<T,thash,HASH>::Iterator& i) {
           outs << i.str(); //Use the same meaning as the debugging .str() method
           return outs;
         }
-        friend Iterator HashSet<T,thash>::begin () const;
-        friend Iterator HashSet<T,thash>::end   () const;
+        friend Iterator HashSet<T,thash,HASH>::begin () const;
+        friend Iterator HashSet<T,thash,HASH>::end   () const;
 
       private:
         //If can_erase is false, current indexes the "next" value (must ++ to reach it)
-        Cursor              current; //Bin Index and Cursor; stop: LN* == nullptr
-        HashSet<T,thash>*   ref_set;
-        int                 expected_mod_count;
-        bool                can_erase = true;
+        Cursor                 current; //Bin Index and Cursor; stop: LN* == nullptr
+        HashSet<T,thash,HASH>* ref_set;
+        int                    expected_mod_count;
+        bool                   can_erase = true;
 
         //Helper methods
         void advance_cursors();
 
         //Called in friends begin/end
-        Iterator(HashSet<T,thash>* iterate_over, bool from_begin);
+        Iterator(HashSet<T,thash,HASH>* iterate_over, bool from_begin);
     };
 
 
@@ -130,6 +146,7 @@ template<class T, int (*thash)(const T& a) = nullptr> class HashSet {
     };
 
 public:
+  static_assert(std::is_void<HASH>::value || thash == nullptr, "HashSet: specify thash or HASH, not both");
   int (*hash)(const T& k);   //Hashing function used (from template or constructor)
 private:
   LN** set      = nullptr;   //Pointer to array of pointers: each bin stores a list with a trailer node
@@ -137,15 +154,20 @@ private:
   int bins      = 1;         //# bins in array (should start at 1 so hash_compress doesn't % 0)
   int used      = 0;         //Cache for number of key->value pairs in the hash table
   int mod_count = 0;         //For sensing concurrent modification
+  BloomFilter* filter = nullptr; //Optional: see enable_filter
 
 
   //Helper methods
+  int   hash_value           (const T& element)          const;  //hash function (unranged)
   int   hash_compress        (const T& key)              const;  //hash function ranged to [0,bins-1]
   LN*   find_element         (int bin, const T& element) const;  //Returns reference to element's node or nullptr
+  LN*   find                 (const T& element)          const;  //Consult filter (if any), then element's bin
+  bool  subset_of            (const HashSet<T,thash,HASH>& rhs) const; //Every value here is in rhs
   LN*   copy_list            (LN*   l)                   const;  //Copy the elements in a bin (order irrelevant)
   LN**  copy_hash_table      (LN** ht, int bins)         const;  //Copy the bins/keys/values in ht tree (order in bins irrelevant)
 
-  void  ensure_load_threshold(int new_used);                     //Reallocate if load_threshold > load_threshold
+  void  ensure_load_threshold(int new_used);                     //Reallocate (doubling bins until new_used fits) if load_factor > load_threshold
+  void  rebuild_filter       ();                                 //Size filter for bins*load_threshold values and add them
   void  delete_hash_table    (LN**& ht, int bins);               //Deallocate all LN in ht (and the ht itself; ht == nullptr)
 };
 
@@ -159,18 +181,19 @@ private:
 //
 //Destructor/Constructors
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::~HashSet() {
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH>::~HashSet() {
   delete_hash_table(set,bins);
+  delete filter;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::HashSet(double the_load_threshold, int (*chash)(const T& element))
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH>::HashSet(double the_load_threshold, int (*chash)(const T& element))
 : hash(thash != nullptr ? thash : chash), load_threshold(the_load_threshold) {
-  if (hash == nullptr)
+  if (hash == nullptr && std::is_void<HASH>::value)
     throw TemplateFunctionError("HashSet::default constructor: neither specified");
-  if (thash != nullptr && chash != nullptr && thash != chash)
+  if ((thash != nullptr || !std::is_void<HASH>::value) && chash != nullptr && thash != chash)
     throw TemplateFunctionError("HashSet::default constructor: both specified and different");
 
   set = new LN*[bins];
@@ -179,12 +202,12 @@ HashSet<T,thash>::HashSet(double the_load_threshold, int (*chash)(const T& eleme
 }
 
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::HashSet(int initial_bins, double the_load_threshold, int (*chash)(const T& element))
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH>::HashSet(int initial_bins, double the_load_threshold, int (*chash)(const T& element))
 : hash(thash != nullptr ? thash : chash), bins(initial_bins), load_threshold(the_load_threshold) {
-  if (hash == nullptr)
+  if (hash == nullptr && std::is_void<HASH>::value)
     throw TemplateFunctionError("HashSet::length constructor: neither specified");
-  if (thash != nullptr && chash != nullptr && thash != chash)
+  if ((thash != nullptr || !std::is_void<HASH>::value) && chash != nullptr && thash != chash)
     throw TemplateFunctionError("HashSet::length constructor: both specified and different");
 
   if (bins < 1)
@@ -195,12 +218,12 @@ HashSet<T,thash>::HashSet(int initial_bins, double the_load_threshold, int (*cha
 }
 
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::HashSet(const HashSet<T,thash>& to_copy, double the_load_threshold, int (*chash)(const T& element))
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH>::HashSet(const HashSet<T,thash,HASH>& to_copy, double the_load_threshold, int (*chash)(const T& element))
 : hash(thash != nullptr ? thash : chash), load_threshold(the_load_threshold), bins(to_copy.bins) {
   if (hash == nullptr)
     hash = to_copy.hash;//throw TemplateFunctionError("HashSet::copy constructor: neither specified");
-  if (thash != nullptr && chash != nullptr && thash != chash)
+  if ((thash != nullptr || !std::is_void<HASH>::value) && chash != nullptr && thash != chash)
     throw TemplateFunctionError("HashSet::copy constructor: both specified and different");
 
   if (hash == to_copy.hash && (double)to_copy.size()/to_copy.bins <= the_load_threshold) {
@@ -216,15 +239,18 @@ HashSet<T,thash>::HashSet(const HashSet<T,thash>& to_copy, double the_load_thres
       for (LN* c = to_copy.set[b]; c->next!=nullptr; c=c->next)
         insert(c->value);
   }
+
+  if (to_copy.filter != nullptr)
+    enable_filter(to_copy.filter->false_positive_rate(), to_copy.filter->max_bytes());
 }
 
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::HashSet(const std::initializer_list<T>& il, double the_load_threshold, int (*chash)(const T& element))
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH>::HashSet(const std::initializer_list<T>& il, double the_load_threshold, int (*chash)(const T& element))
 : hash(thash != nullptr ? thash : chash), load_threshold(the_load_threshold), bins(std::max(1,int(il.size()/the_load_threshold))) {
-  if (hash == nullptr)
+  if (hash == nullptr && std::is_void<HASH>::value)
     throw TemplateFunctionError("HashSet::initializer_list constructor: neither specified");
-  if (thash != nullptr && chash != nullptr && thash != chash)
+  if ((thash != nullptr || !std::is_void<HASH>::value) && chash != nullptr && thash != chash)
     throw TemplateFunctionError("HashSet::initializer_list constructor: both specified and different");
 
   set = new LN*[bins];
@@ -236,13 +262,13 @@ HashSet<T,thash>::HashSet(const std::initializer_list<T>& il, double the_load_th
 }
 
 
-template<class T, int (*thash)(const T& a)>
+template<class T, int (*thash)(const T& a), class HASH>
 template<class Iterable>
-HashSet<T,thash>::HashSet(const Iterable& i, double the_load_threshold, int (*chash)(const T& a))
+HashSet<T,thash,HASH>::HashSet(const Iterable& i, double the_load_threshold, int (*chash)(const T& a))
 : hash(thash != nullptr ? thash : chash), load_threshold(the_load_threshold), bins(std::max(1,int(i.size()/the_load_threshold))) {
-  if (hash == nullptr)
+  if (hash == nullptr && std::is_void<HASH>::value)
     throw TemplateFunctionError("HashSet::Iterable constructor: neither specified");
-  if (thash != nullptr && chash != nullptr && thash != chash)
+  if ((thash != nullptr || !std::is_void<HASH>::value) && chash != nullptr && thash != chash)
     throw TemplateFunctionError("HashSet::Iterable constructor: both specified and different");
 
   set = new LN*[bins];
@@ -258,26 +284,26 @@ HashSet<T,thash>::HashSet(const Iterable& i, double the_load_threshold, int (*ch
 //
 //Queries
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::empty() const {
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::empty() const {
   return used == 0;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-int HashSet<T,thash>::size() const {
+template<class T, int (*thash)(const T& a), class HASH>
+int HashSet<T,thash,HASH>::size() const {
   return used;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::contains (const T& element) const {
-  return find_element(hash_compress(element),element) != nullptr;
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::contains (const T& element) const {
+  return find(element) != nullptr;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-std::string HashSet<T,thash>::str() const {
+template<class T, int (*thash)(const T& a), class HASH>
+std::string HashSet<T,thash,HASH>::str() const {
   std::ostringstream answer;
   answer << "HashSet[";
   if (bins != 0) {
@@ -295,9 +321,9 @@ std::string HashSet<T,thash>::str() const {
 }
 
 
-template<class T, int (*thash)(const T& a)>
+template<class T, int (*thash)(const T& a), class HASH>
 template <class Iterable>
-bool HashSet<T,thash>::contains_all(const Iterable& i) const {
+bool HashSet<T,thash,HASH>::contains_all(const Iterable& i) const {
   for (const T& v : i)
     if (!contains(v))
       return false;
@@ -310,8 +336,8 @@ bool HashSet<T,thash>::contains_all(const Iterable& i) const {
 //
 //Commands
 
-template<class T, int (*thash)(const T& a)>
-int HashSet<T,thash>::insert(const T& element) {
+template<class T, int (*thash)(const T& a), class HASH>
+int HashSet<T,thash,HASH>::insert(const T& element) {
   int bin = hash_compress(element);
   LN* c = find_element(bin,element);
   if (c != nullptr)
@@ -323,13 +349,15 @@ int HashSet<T,thash>::insert(const T& element) {
   ++mod_count;
   bin = hash_compress(element);         //bins may have changed in ensure_load_threshold!
   set[bin] = new LN(element,set[bin]);  //easy to put at front: bin LNs unordered
+  if (filter != nullptr)
+    filter->add(hash_value(element));
   return 1;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-int HashSet<T,thash>::erase(const T& element) {
-  LN* c = find_element(hash_compress(element),element);
+template<class T, int (*thash)(const T& a), class HASH>
+int HashSet<T,thash,HASH>::erase(const T& element) {
+  LN* c = find(element);
   if (c == nullptr)
     return 0;
 
@@ -342,8 +370,8 @@ int HashSet<T,thash>::erase(const T& element) {
 }
 
 
-template<class T, int (*thash)(const T& a)>
-void HashSet<T,thash>::clear() {
+template<class T, int (*thash)(const T& a), class HASH>
+void HashSet<T,thash,HASH>::clear() {
   for (int b=0; b<bins; ++b) {
     LN* l=set[b];
     for (; l->next!=nullptr; /*See body*/) {
@@ -353,15 +381,48 @@ void HashSet<T,thash>::clear() {
     }
     set[b] = l;
   }
+  if (filter != nullptr)
+    filter->clear();
 
   used = 0;
   ++mod_count;
 }
 
 
-template<class T, int (*thash)(const T& a)>
+template<class T, int (*thash)(const T& a), class HASH>
+void HashSet<T,thash,HASH>::reserve(int n) {
+  int old_bins = bins;
+  ensure_load_threshold(n);
+  if (bins != old_bins)
+    ++mod_count;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+void HashSet<T,thash,HASH>::enable_filter(double false_positive_rate, long max_bytes) {
+  BloomFilter* made = new BloomFilter(0, false_positive_rate, max_bytes);
+  delete filter;
+  filter = made;
+  rebuild_filter();
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+void HashSet<T,thash,HASH>::disable_filter() {
+  delete filter;
+  filter = nullptr;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::filtered() const {
+  return filter != nullptr;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
 template<class Iterable>
-int HashSet<T,thash>::insert_all(const Iterable& i) {
+int HashSet<T,thash,HASH>::insert_all(const Iterable& i) {
   int count = 0;
   for (const T& v : i)
     count += insert(v);
@@ -370,9 +431,9 @@ int HashSet<T,thash>::insert_all(const Iterable& i) {
 }
 
 
-template<class T, int (*thash)(const T& a)>
+template<class T, int (*thash)(const T& a), class HASH>
 template<class Iterable>
-int HashSet<T,thash>::erase_all(const Iterable& i) {
+int HashSet<T,thash,HASH>::erase_all(const Iterable& i) {
   int count = 0;
   for (const T& v : i)
     count += erase(v);
@@ -380,25 +441,38 @@ int HashSet<T,thash>::erase_all(const Iterable& i) {
 }
 
 
-template<class T, int (*thash)(const T& a)>
+//Relinks each value of i found here into a new table (same bins, so the same
+//  bin), then deletes what is left: no copy of i, and no values are copied
+template<class T, int (*thash)(const T& a), class HASH>
 template<class Iterable>
-int HashSet<T,thash>::retain_all(const Iterable& i) {
-  HashSet<T,thash> s(i);
+int HashSet<T,thash,HASH>::retain_all(const Iterable& i) {
+  //Nodes are moved out of set while iterating over i: i must not be this set
+  if (static_cast<const void*>(&i) == this)
+    return 0;
 
-  int count = 0;
+  LN** kept = new LN*[bins];
   for (int b=0; b<bins; ++b)
-    for (LN* c=set[b]; c->next!=nullptr; /*See body*/) {
-      if (s.contains(c->value))
-        c = c-> next;
-      else{
-        LN* to_delete = c->next;
-        *c = *(c->next);
-        delete to_delete;
-        ++count;
+    kept[b] = new LN();
+
+  int kept_used = 0;
+  for (const T& v : i) {
+    int bin = hash_compress(v);
+    for (LN** c = &set[bin]; (*c)->next != nullptr; c = &(*c)->next)
+      if (v == (*c)->value) {
+        LN* to_keep = *c;
+        *c = to_keep->next;
+        to_keep->next = kept[bin];
+        kept[bin] = to_keep;
+        ++kept_used;
+        break;
       }
-    }
+  }
 
-  used -= count;
+  int count = used - kept_used;
+  delete_hash_table(set,bins);
+  set  = kept;
+  used = kept_used;
+  ++mod_count;
   return count;
 }
 
@@ -407,8 +481,8 @@ int HashSet<T,thash>::retain_all(const Iterable& i) {
 //
 //Operators
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>& HashSet<T,thash>::operator = (const HashSet<T,thash>& rhs) {
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH>& HashSet<T,thash,HASH>::operator = (const HashSet<T,thash,HASH>& rhs) {
   if (this == &rhs)
     return *this;
 
@@ -423,84 +497,124 @@ HashSet<T,thash>& HashSet<T,thash>::operator = (const HashSet<T,thash>& rhs) {
       for (LN* c = rhs.set[b]; c->next!=nullptr; c=c->next)
         insert(c->value);
   }
+  if (filter != nullptr)
+    rebuild_filter();
 
   ++mod_count;
   return *this;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::operator == (const HashSet<T,thash>& rhs) const {
+//Copy the larger set's table (no rehashing), then insert the smaller's values
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH> HashSet<T,thash,HASH>::operator | (const HashSet<T,thash,HASH>& rhs) const {
+  const HashSet<T,thash,HASH>& larger  = (used >= rhs.used ? *this : rhs);
+  const HashSet<T,thash,HASH>& smaller = (used >= rhs.used ? rhs : *this);
+
+  HashSet<T,thash,HASH> answer(larger, larger.load_threshold);
+  for (int b=0; b<smaller.bins; ++b)
+    for (LN* c=smaller.set[b]; c->next!=nullptr; c=c->next)
+      answer.insert(c->value);
+
+  return answer;
+}
+
+
+//Probe each value of the smaller set in the larger one
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH> HashSet<T,thash,HASH>::operator & (const HashSet<T,thash,HASH>& rhs) const {
+  const HashSet<T,thash,HASH>& larger  = (used >= rhs.used ? *this : rhs);
+  const HashSet<T,thash,HASH>& smaller = (used >= rhs.used ? rhs : *this);
+
+  HashSet<T,thash,HASH> answer(std::max(1,int(smaller.used/load_threshold)), load_threshold, hash);
+  for (int b=0; b<smaller.bins; ++b)
+    for (LN* c=smaller.set[b]; c->next!=nullptr; c=c->next)
+      if (larger.contains(c->value))
+        answer.insert(c->value);
+
+  return answer;
+}
+
+
+//If rhs is smaller, copy this table (no rehashing) and erase rhs's values;
+//  otherwise probe each value here in rhs
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH> HashSet<T,thash,HASH>::operator - (const HashSet<T,thash,HASH>& rhs) const {
+  if (rhs.used < used) {
+    HashSet<T,thash,HASH> answer(*this, load_threshold);
+    for (int b=0; b<rhs.bins; ++b)
+      for (LN* c=rhs.set[b]; c->next!=nullptr; c=c->next)
+        answer.erase(c->value);
+    return answer;
+  }
+
+  HashSet<T,thash,HASH> answer(std::max(1,int(used/load_threshold)), load_threshold, hash);
+  for (int b=0; b<bins; ++b)
+    for (LN* c=set[b]; c->next!=nullptr; c=c->next)
+      if (!rhs.contains(c->value))
+        answer.insert(c->value);
+
+  return answer;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::operator == (const HashSet<T,thash,HASH>& rhs) const {
   if (this == &rhs)
     return true;
   if (used != rhs.size())
     return false;
 
-  for (int b=0; b<bins; ++b)
-    for (LN* c=set[b]; c->next!=nullptr; c=c->next)
-       if (!rhs.contains(c->value))
-         return false;
-
-  return true;
+  return subset_of(rhs);
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::operator != (const HashSet<T,thash>& rhs) const {
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::operator != (const HashSet<T,thash,HASH>& rhs) const {
   return !(*this == rhs);
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::operator <= (const HashSet<T,thash>& rhs) const {
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::operator <= (const HashSet<T,thash,HASH>& rhs) const {
   if (this == &rhs)
     return true;
   if (used > rhs.size())
     return false;
 
-  for (int b=0; b<bins; ++b)
-    for (LN* c=set[b]; c->next!=nullptr; c=c->next)
-      if (!rhs.contains(c->value))
-        return false;
-
-  return true;
+  return subset_of(rhs);
 }
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::operator < (const HashSet<T,thash>& rhs) const {
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::operator < (const HashSet<T,thash,HASH>& rhs) const {
   if (this == &rhs)
     return false;
   if (used >= rhs.size())
     return false;
 
-  for (int b=0; b<bins; ++b)
-    for (LN* c=set[b]; c->next!=nullptr; c=c->next)
-      if (!rhs.contains(c->value))
-        return false;
-
-  return true;
+  return subset_of(rhs);
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::operator >= (const HashSet<T,thash>& rhs) const {
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::operator >= (const HashSet<T,thash,HASH>& rhs) const {
   return rhs <= *this;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::operator > (const HashSet<T,thash>& rhs) const {
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::operator > (const HashSet<T,thash,HASH>& rhs) const {
   return rhs < *this;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-std::ostream& operator << (std::ostream& outs, const HashSet<T,thash>& s) {
+template<class T, int (*thash)(const T& a), class HASH>
+std::ostream& operator << (std::ostream& outs, const HashSet<T,thash,HASH>& s) {
   outs  << "set[";
 
   int printed = 0;
   for (int b=0; b<s.bins; ++b)
-    for (typename HashSet<T,thash>::LN* c = s.set[b]; c->next != nullptr; c = c->next)
+    for (typename HashSet<T,thash,HASH>::LN* c = s.set[b]; c->next != nullptr; c = c->next)
       outs << (printed++ == 0? "" : ",") << c->value;
 
   outs << "]";
@@ -512,15 +626,15 @@ std::ostream& operator << (std::ostream& outs, const HashSet<T,thash>& s) {
 //
 //Iterator constructors
 
-template<class T, int (*thash)(const T& a)>
-auto HashSet<T,thash>::begin () const -> HashSet<T,thash>::Iterator {
-  return Iterator(const_cast<HashSet<T,thash>*>(this),true);
+template<class T, int (*thash)(const T& a), class HASH>
+auto HashSet<T,thash,HASH>::begin () const -> HashSet<T,thash,HASH>::Iterator {
+  return Iterator(const_cast<HashSet<T,thash,HASH>*>(this),true);
 }
 
 
-template<class T, int (*thash)(const T& a)>
-auto HashSet<T,thash>::end () const -> HashSet<T,thash>::Iterator {
-  return Iterator(const_cast<HashSet<T,thash>*>(this),false);
+template<class T, int (*thash)(const T& a), class HASH>
+auto HashSet<T,thash,HASH>::end () const -> HashSet<T,thash,HASH>::Iterator {
+  return Iterator(const_cast<HashSet<T,thash,HASH>*>(this),false);
 }
 
 
@@ -528,14 +642,20 @@ auto HashSet<T,thash>::end () const -> HashSet<T,thash>::Iterator {
 //
 //Private helper methods
 
-template<class T, int (*thash)(const T& a)>
-int HashSet<T,thash>::hash_compress (const T& element) const {
-  return abs(hash(element)) % bins;
+template<class T, int (*thash)(const T& a), class HASH>
+int HashSet<T,thash,HASH>::hash_value (const T& element) const {
+  return Functor<HASH>::call(thash != nullptr ? thash : hash, element);
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+int HashSet<T,thash,HASH>::hash_compress (const T& element) const {
+  return abs(hash_value(element)) % bins;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-typename HashSet<T,thash>::LN* HashSet<T,thash>::find_element (int bin, const T& element) const {
+template<class T, int (*thash)(const T& a), class HASH>
+typename HashSet<T,thash,HASH>::LN* HashSet<T,thash,HASH>::find_element (int bin, const T& element) const {
   for (LN* c = set[bin]; c->next!=nullptr; c=c->next)
     if (element == c->value)
       return c;
@@ -543,8 +663,29 @@ typename HashSet<T,thash>::LN* HashSet<T,thash>::find_element (int bin, const T&
   return nullptr;
 }
 
-template<class T, int (*thash)(const T& a)>
-typename HashSet<T,thash>::LN* HashSet<T,thash>::copy_list (LN* l) const {
+
+//A filter miss answers without touching the bins
+template<class T, int (*thash)(const T& a), class HASH>
+typename HashSet<T,thash,HASH>::LN* HashSet<T,thash,HASH>::find (const T& element) const {
+  int h = hash_value(element);
+  if (filter != nullptr && !filter->might_contain(h))
+    return nullptr;
+  return find_element(abs(h) % bins, element);
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::subset_of (const HashSet<T,thash,HASH>& rhs) const {
+  for (int b=0; b<bins; ++b)
+    for (LN* c=set[b]; c->next!=nullptr; c=c->next)
+      if (!rhs.contains(c->value))
+        return false;
+
+  return true;
+}
+
+template<class T, int (*thash)(const T& a), class HASH>
+typename HashSet<T,thash,HASH>::LN* HashSet<T,thash,HASH>::copy_list (LN* l) const {
 //    //Recursive
 //    if (l == nullptr)
 //      return nullptr;
@@ -563,8 +704,8 @@ typename HashSet<T,thash>::LN* HashSet<T,thash>::copy_list (LN* l) const {
 }
 
 
-template<class T, int (*thash)(const T& a)>
-typename HashSet<T,thash>::LN** HashSet<T,thash>::copy_hash_table (LN** ht, int bins) const {
+template<class T, int (*thash)(const T& a), class HASH>
+typename HashSet<T,thash,HASH>::LN** HashSet<T,thash,HASH>::copy_hash_table (LN** ht, int bins) const {
   LN** answer = new LN*[bins];
   for (int b=0; b<bins; ++b)
      answer[b] = copy_list(ht[b]);
@@ -572,15 +713,17 @@ typename HashSet<T,thash>::LN** HashSet<T,thash>::copy_hash_table (LN** ht, int
 }
 
 
-template<class T, int (*thash)(const T& a)>
-void HashSet<T,thash>::ensure_load_threshold(int new_used) {
-  if (double(new_used)/double(bins) <= load_threshold)
-    return;
+template<class T, int (*thash)(const T& a), class HASH>
+void HashSet<T,thash,HASH>::ensure_load_threshold(int new_used) {
+  if (double(new_used)/double(bins) <= load_threshold || bins > std::numeric_limits<int>::max()/2)
+    return;                              //Fits (or bins cannot double without overflowing)
 
   LN** old_set  = set;
   int  old_bins = bins;
 
   bins = 2*old_bins;
+  while (double(new_used)/double(bins) > load_threshold && bins <= std::numeric_limits<int>::max()/2)
+    bins *= 2;
   set = new LN*[bins];
 
   for (int b=0; b<bins; ++b)
@@ -598,11 +741,24 @@ void HashSet<T,thash>::ensure_load_threshold(int new_used) {
     delete c;           //deallocate trailers in old_map
   }
   delete [] old_set;
+
+  if (filter != nullptr)
+    rebuild_filter();
+}
+
+
+//Sized for the most values the table holds before it next grows
+template<class T, int (*thash)(const T& a), class HASH>
+void HashSet<T,thash,HASH>::rebuild_filter() {
+  filter->resize(std::max(used, int(bins*load_threshold)));
+  for (int b=0; b<bins; ++b)
+    for (LN* c=set[b]; c->next!=nullptr; c=c->next)
+      filter->add(hash_value(c->value));
 }
 
 
-template<class T, int (*thash)(const T& a)>
-void HashSet<T,thash>::delete_hash_table (LN**& ht, int bins) {
+template<class T, int (*thash)(const T& a), class HASH>
+void HashSet<T,thash,HASH>::delete_hash_table (LN**& ht, int bins) {
   for (int b=0; b<bins; ++b)
     for (LN* c=ht[b]; c!=nullptr; /*See body*/) {
       LN* to_delete = c;
@@ -622,8 +778,8 @@ void HashSet<T,thash>::delete_hash_table (LN**& ht, int bins) {
 //
 //Iterator class definitions
 
-template<class T, int (*thash)(const T& a)>
-void HashSet<T,thash>::Iterator::advance_cursors() {
+template<class T, int (*thash)(const T& a), class HASH>
+void HashSet<T,thash,HASH>::Iterator::advance_cursors() {
   if (current.second != nullptr && current.second->next != nullptr && current.second->next->next != nullptr) {
     current.second = current.second->next;
     return;
@@ -641,8 +797,8 @@ void HashSet<T,thash>::Iterator::advance_cursors() {
 }
 
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::Iterator::Iterator(HashSet<T,thash>* iterate_over, bool begin)
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH>::Iterator::Iterator(HashSet<T,thash,HASH>* iterate_over, bool begin)
 : ref_set(iterate_over) {
   current = Cursor(-1,nullptr);
   if (begin)
@@ -651,13 +807,13 @@ HashSet<T,thash>::Iterator::Iterator(HashSet<T,thash>* iterate_over, bool begin)
 }
 
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::Iterator::~Iterator()
+template<class T, int (*thash)(const T& a), class HASH>
+HashSet<T,thash,HASH>::Iterator::~Iterator()
 {}
 
 
-template<class T, int (*thash)(const T& a)>
-T HashSet<T,thash>::Iterator::erase() {
+template<class T, int (*thash)(const T& a), class HASH>
+T HashSet<T,thash,HASH>::Iterator::erase() {
   if (expected_mod_count != ref_set->mod_count)
     throw ConcurrentModificationError("HashSet::Iterator::erase");
   if (!can_erase)
@@ -679,16 +835,16 @@ T HashSet<T,thash>::Iterator::erase() {
 }
 
 
-template<class T, int (*thash)(const T& a)>
-std::string HashSet<T,thash>::Iterator::str() const {
+template<class T, int (*thash)(const T& a), class HASH>
+std::string HashSet<T,thash,HASH>::Iterator::str() const {
   std::ostringstream answer;
   answer << ref_set->str() << "(current=" << current.first << "/" << current.second << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
   return answer.str();
 }
 
 
-template<class T, int (*thash)(const T& a)>
-auto  HashSet<T,thash>::Iterator::operator ++ () -> HashSet<T,thash>::Iterator& {
+template<class T, int (*thash)(const T& a), class HASH>
+auto  HashSet<T,thash,HASH>::Iterator::operator ++ () -> HashSet<T,thash,HASH>::Iterator& {
   if (expected_mod_count != ref_set->mod_count)
     throw ConcurrentModificationError("HashSet::Iterator::operator ++");
 
@@ -703,8 +859,8 @@ auto  HashSet<T,thash>::Iterator::operator ++ () -> HashSet<T,thash>::Iterator&
 }
 
 
-template<class T, int (*thash)(const T& a)>
-auto  HashSet<T,thash>::Iterator::operator ++ (int) -> HashSet<T,thash>::Iterator {
+template<class T, int (*thash)(const T& a), class HASH>
+auto  HashSet<T,thash,HASH>::Iterator::operator ++ (int) -> HashSet<T,thash,HASH>::Iterator {
   if (expected_mod_count != ref_set->mod_count)
     throw ConcurrentModificationError("HashSet::Iterator::operator ++(int)");
 
@@ -720,8 +876,8 @@ auto  HashSet<T,thash>::Iterator::operator ++ (int) -> HashSet<T,thash>::Iterato
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::Iterator::operator == (const HashSet<T,thash>::Iterator& rhs) const {
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::Iterator::operator == (const HashSet<T,thash,HASH>::Iterator& rhs) const {
   const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
   if (rhsASI == 0)
     throw IteratorTypeError("HashSet::Iterator::operator ==");
@@ -734,8 +890,8 @@ bool HashSet<T,thash>::Iterator::operator == (const HashSet<T,thash>::Iterator&
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::Iterator::operator != (const HashSet<T,thash>::Iterator& rhs) const {
+template<class T, int (*thash)(const T& a), class HASH>
+bool HashSet<T,thash,HASH>::Iterator::operator != (const HashSet<T,thash,HASH>::Iterator& rhs) const {
   const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
   if (rhsASI == 0)
     throw IteratorTypeError("HashSet::Iterator::operator !=");
@@ -747,8 +903,8 @@ bool HashSet<T,thash>::Iterator::operator != (const HashSet<T,thash>::Iterator&
   return this->current.second != rhsASI->current.second;
 }
 
-template<class T, int (*thash)(const T& a)>
-T& HashSet<T,thash>::Iterator::operator *() const {
+template<class T, int (*thash)(const T& a), class HASH>
+T& HashSet<T,thash,HASH>::Iterator::operator *() const {
   if (expected_mod_count !=
       ref_set->mod_count)
     throw ConcurrentModificationError("HashSet::Iterator::operator *");
@@ -758,8 +914,8 @@ T& HashSet<T,thash>::Iterator::operator *() const {
   return current.second->value;
 }
 
-template<class T, int (*thash)(const T& a)>
-T* HashSet<T,thash>::Iterator::operator ->() const {
+template<class T, int (*thash)(const T& a), class HASH>
+T* HashSet<T,thash,HASH>::Iterator::operator ->() const {
   if (expected_mod_count !=
       ref_set->mod_count)
     throw ConcurrentModificationError("HashSet::Iterator::operator *");
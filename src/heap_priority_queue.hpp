@@ -5,9 +5,15 @@
 #include <iostream>
 #include <sstream>
 #include <initializer_list>
+#include <algorithm>            //For std::max/std::min
+#include <cstdint>              //For std::uintptr_t (aligning storage)
+#include <new>                  //For placement new
+#include <vector>               //For top_k candidates
 #include "ics_exceptions.hpp"
-#include <utility>              //For std::swap function
+#include "functor.hpp"
+#include <utility>              //For std::move/std::forward
 #include "array_stack.hpp"      //See operator <<
+#include "array_queue.hpp"      //For dequeue_n/top_k results
 
 
 namespace ics {
@@ -18,14 +24,19 @@ namespace ics {
 //If both tgt and cgt are supplied, then they must be the same (by ==) function.
 //If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
 //The (unique) non-nullptr value supplied by tgt/cgt is stored in the instance variable gt.
-template<class T, bool (*tgt)(const T& a, const T& b) = nullptr> class HeapPriorityQueue {
+//Instead, GT can be a functor type whose GT()(a,b) is the priority order (then neither tgt nor cgt is supplied).
+//arity is the # of children of each node (2 is a binary heap); the children of
+//  a node are adjacent and their group starts on a cache line, so with arity 4
+//  or 8 (and small T) percolate_down reads one cache line per level of a
+//  shallower heap.
+template<class T, bool (*tgt)(const T& a, const T& b) = nullptr, int arity = 2, class GT = void> class HeapPriorityQueue {
   public:
     //Destructor/Constructors
     ~HeapPriorityQueue();
 
     HeapPriorityQueue(bool (*cgt)(const T& a, const T& b) = nullptr);
     explicit HeapPriorityQueue(int initial_length, bool (*cgt)(const T& a, const T& b));
-    HeapPriorityQueue(const HeapPriorityQueue<T,tgt>& to_copy, bool (*cgt)(const T& a, const T& b) = nullptr);
+    HeapPriorityQueue(const HeapPriorityQueue<T,tgt,arity,GT>& to_copy, bool (*cgt)(const T& a, const T& b) = nullptr);
     explicit HeapPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b) = nullptr);
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
@@ -37,60 +48,64 @@ template<class T, bool (*tgt)(const T& a, const T& b) = nullptr> class HeapPrior
     bool empty      () const;
     int  size       () const;
     T&   peek       () const;
+    ArrayQueue<T> top_k (int k) const; //The k (or size(), if fewer) highest values, highest first
     std::string str () const; //supplies useful debugging information; contrast to operator <<
 
 
     //Commands
     int  enqueue (const T& element);
+    int  enqueue (T&& element);
     T    dequeue ();
+    int  dequeue_n (int k, ArrayQueue<T>& into); //Dequeue the k (or size(), if fewer) highest into into, highest first; return #
     void clear   ();
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    //A large batch (relative to size()) is appended and heapified in O(N)
     template <class Iterable>
     int enqueue_all (const Iterable& i);
 
 
     //Operators
-    HeapPriorityQueue<T,tgt>& operator = (const HeapPriorityQueue<T,tgt>& rhs);
-    bool operator == (const HeapPriorityQueue<T,tgt>& rhs) const;
-    bool operator != (const HeapPriorityQueue<T,tgt>& rhs) const;
+    HeapPriorityQueue<T,tgt,arity,GT>& operator = (const HeapPriorityQueue<T,tgt,arity,GT>& rhs);
+    bool operator == (const HeapPriorityQueue<T,tgt,arity,GT>& rhs) const;
+    bool operator != (const HeapPriorityQueue<T,tgt,arity,GT>& rhs) const;
 
-    template<class T2, bool (*gt2)(const T2& a, const T2& b)>
-    friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T2,gt2>& pq);
+    template<class T2, bool (*gt2)(const T2& a, const T2& b), int arity2, class GT2>
+    friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T2,gt2,arity2,GT2>& pq);
 
 
 
     class Iterator {
       public:
-        //Private constructor called in begin/end, which are friends of HeapPriorityQueue<T,tgt>
+        //Private constructor called in begin/end, which are friends of HeapPriorityQueue<T,tgt,arity,GT>
         ~Iterator();
         T           erase();
         std::string str  () const;
-        HeapPriorityQueue<T,tgt>::Iterator& operator ++ ();
-        HeapPriorityQueue<T,tgt>::Iterator  operator ++ (int);
-        bool operator == (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const;
-        bool operator != (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const;
+        HeapPriorityQueue<T,tgt,arity,GT>::Iterator& operator ++ ();
+        HeapPriorityQueue<T,tgt,arity,GT>::Iterator  operator ++ (int);
+        bool operator == (const HeapPriorityQueue<T,tgt,arity,GT>::Iterator& rhs) const;
+        bool operator != (const HeapPriorityQueue<T,tgt,arity,GT>::Iterator& rhs) const;
         T& operator *  () const;
         T* operator -> () const;
-        friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt>::Iterator& i) {
+        friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt,arity,GT>::Iterator& i) {
           outs << i.str(); //Use the same meaning as the debugging .str() method
           return outs;
         }
 
-        friend Iterator HeapPriorityQueue<T,tgt>::begin () const;
-        friend Iterator HeapPriorityQueue<T,tgt>::end   () const;
+        friend Iterator HeapPriorityQueue<T,tgt,arity,GT>::begin () const;
+        friend Iterator HeapPriorityQueue<T,tgt,arity,GT>::end   () const;
 
       private:
         //If can_erase is false, the value has been removed from "it" (++ does nothing)
-        HeapPriorityQueue<T,tgt>  it;                 //copy of HPQ (from begin), to use as iterator via dequeue
-        HeapPriorityQueue<T,tgt>* ref_pq;
-        int                       expected_mod_count;
-        bool                      can_erase = true;
+        HeapPriorityQueue<T,tgt,arity,GT>  it;                 //copy of HPQ (from begin), to use as iterator via dequeue
+        HeapPriorityQueue<T,tgt,arity,GT>* ref_pq;
+        int                                expected_mod_count;
+        bool                               can_erase = true;
 
         //Called in friends begin/end
         //These constructors have different initializers (see it(...) in first one)
-        Iterator(HeapPriorityQueue<T,tgt>* iterate_over, bool from_begin);    // Called by begin
-        Iterator(HeapPriorityQueue<T,tgt>* iterate_over);                     // Called by end
+        Iterator(HeapPriorityQueue<T,tgt,arity,GT>* iterate_over, bool from_begin);    // Called by begin
+        Iterator(HeapPriorityQueue<T,tgt,arity,GT>* iterate_over);                     // Called by end
     };
 
 
@@ -99,23 +114,36 @@ template<class T, bool (*tgt)(const T& a, const T& b) = nullptr> class HeapPrior
 
 
   private:
+    static_assert(arity >= 2, "HeapPriorityQueue: arity must be >= 2");
+    static const int cache_line = 64;
+
+    static_assert(std::is_void<GT>::value || tgt == nullptr, "HeapPriorityQueue: specify tgt or GT, not both");
     bool (*gt) (const T& a, const T& b); // The gt used by enqueue (from template or constructor)
-    T*  pq;                              // Smaller values in lower indexes (biggest is at used-1)
+    char* storage = nullptr;             // Raw memory holding pq; only pq[0..used-1] are constructed
+    T*  pq;                              // Heap order; &pq[1] (each child group's start) is cache-line aligned
     int length    = 0;                   //Physical length of array: must be >= .size()
     int used      = 0;                   //Amount of array used:  invariant: 0 <= used <= length
     int mod_count = 0;                   //For sensing concurrent modification
 
 
     //Helper methods
+    bool is_gt (const T& a, const T& b) const; //True iff a has higher priority than b: via the functor type, tgt or gt (see functor.hpp)
+    void allocate       (int new_length);      //Set storage/pq for new_length (unconstructed) values
+    void destroy        ();                    //Destroy pq[0..used-1] and free storage
     void ensure_length  (int new_length);
-    int  left_child     (int i) const;         //Useful abstractions for heaps as arrays
-    int  right_child    (int i) const;
+    int  first_child    (int i) const;         //Useful abstractions for heaps as arrays
     int  parent         (int i) const;
     bool is_root        (int i) const;
     bool in_heap        (int i) const;
+    int  max_child      (int c) const;         //Index of highest of the child group starting at c
+    template <class U>
+    void add            (U&& element);         //Construct element in pq[used] (or higher) and ++used
+    void fill_hole      (int hole, T& element);//Move ancestors lower than element down; element goes where they stop
+    int  hole_to_leaf   (int hole);            //Move the highest child up into hole until it reaches a leaf; return that leaf
     void percolate_up   (int i);
     void percolate_down (int i);
     void heapify        ();                   // Percolate down all value is array (from indexes used-1 to 0): O(N)
+    int  levels         () const;             // # of levels in the heap: percolating costs about this many steps
   };
 
 
@@ -128,88 +156,82 @@ template<class T, bool (*tgt)(const T& a, const T& b) = nullptr> class HeapPrior
 
 //Destructor/Constructors
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::~HeapPriorityQueue() {
-  delete[] pq;
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+HeapPriorityQueue<T,tgt,arity,GT>::~HeapPriorityQueue() {
+  destroy();
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(bool (*cgt)(const T& a, const T& b))
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+HeapPriorityQueue<T,tgt,arity,GT>::HeapPriorityQueue(bool (*cgt)(const T& a, const T& b))
 : gt(tgt != nullptr ? tgt : cgt) {
-  if (gt == nullptr)
+  if (gt == nullptr && std::is_void<GT>::value)
     throw TemplateFunctionError("HeapPriorityQueue::default constructor: neither specified");
-  if (tgt != nullptr && cgt != nullptr && tgt != cgt)
+  if ((tgt != nullptr || !std::is_void<GT>::value) && cgt != nullptr && tgt != cgt)
     throw TemplateFunctionError("HeapPriorityQueue::default constructor: both specified and different");
 
-  pq = new T[length];
+  allocate(length);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(int initial_length, bool (*cgt)(const T& a, const T& b))
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+HeapPriorityQueue<T,tgt,arity,GT>::HeapPriorityQueue(int initial_length, bool (*cgt)(const T& a, const T& b))
 : gt(tgt != nullptr ? tgt : cgt), length(initial_length) {
-  if (gt == nullptr)
+  if (gt == nullptr && std::is_void<GT>::value)
     throw TemplateFunctionError("HeapPriorityQueue::length constructor: neither specified");
-  if (tgt != nullptr && cgt != nullptr && tgt != cgt)
+  if ((tgt != nullptr || !std::is_void<GT>::value) && cgt != nullptr && tgt != cgt)
     throw TemplateFunctionError("HeapPriorityQueue::length constructor: both specified and different");
 
   if (length < 0)
     length = 0;
-  pq = new T[length];
+  allocate(length);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const HeapPriorityQueue<T,tgt>& to_copy, bool (*cgt)(const T& a, const T& b))
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+HeapPriorityQueue<T,tgt,arity,GT>::HeapPriorityQueue(const HeapPriorityQueue<T,tgt,arity,GT>& to_copy, bool (*cgt)(const T& a, const T& b))
 : gt(tgt != nullptr ? tgt : cgt), length(to_copy.length), used(to_copy.used) {
   if (gt == nullptr)
     gt = to_copy.gt;//throw TemplateFunctionError("HeapPriorityQueue::copy constructor: neither specified");
-  if (tgt != nullptr && cgt != nullptr && tgt != cgt)
+  if ((tgt != nullptr || !std::is_void<GT>::value) && cgt != nullptr && tgt != cgt)
     throw TemplateFunctionError("HeapPriorityQueue::copy constructor: both specified and different");
 
-  pq = new T[length];
+  allocate(length);
   for (int i=0; i<to_copy.used; ++i)
-    pq[i] = to_copy.pq[i];
+    new (pq+i) T(to_copy.pq[i]);
 
   if (gt != to_copy.gt)
     heapify();
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b))
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+HeapPriorityQueue<T,tgt,arity,GT>::HeapPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b))
 : gt(tgt != nullptr ? tgt : cgt), length(il.size()) {
-  if (gt == nullptr)
+  if (gt == nullptr && std::is_void<GT>::value)
     throw TemplateFunctionError("HeapPriorityQueue::initializer_list constructor: neither specified");
-  if (tgt != nullptr && cgt != nullptr && tgt != cgt)
+  if ((tgt != nullptr || !std::is_void<GT>::value) && cgt != nullptr && tgt != cgt)
     throw TemplateFunctionError("HeapPriorityQueue::initializer_list constructor: both specified and different");
 
-  pq = new T[length];
-  int i = 0;
-  for (const T& pq_elem : il) {
-    pq[i++] = pq_elem;
-  }
-  used = length;
+  allocate(length);
+  for (const T& pq_elem : il)
+    new (pq+used++) T(pq_elem);
   heapify();
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
 template<class Iterable>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const Iterable& i, bool (*cgt)(const T& a, const T& b))
+HeapPriorityQueue<T,tgt,arity,GT>::HeapPriorityQueue(const Iterable& i, bool (*cgt)(const T& a, const T& b))
 : gt(tgt != nullptr ? tgt : cgt), length(i.size()) {
-  if (gt == nullptr)
+  if (gt == nullptr && std::is_void<GT>::value)
     throw TemplateFunctionError("HeapPriorityQueue::Iterable constructor: neither specified");
-  if (tgt != nullptr && cgt != nullptr && tgt != cgt)
+  if ((tgt != nullptr || !std::is_void<GT>::value) && cgt != nullptr && tgt != cgt)
     throw TemplateFunctionError("HeapPriorityQueue::Iterable constructor: both specified and different");
 
-  pq = new T[length];
-  int j = 0;
-  for (const T& pq_elem : i) {
-    pq[j++] = pq_elem;
-  }
-  used = length;
+  allocate(length);
+  for (const T& pq_elem : i)
+    new (pq+used++) T(pq_elem);
   heapify();
 }
 
@@ -218,20 +240,20 @@ HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const Iterable& i, bool (*cgt)(const
 //
 //Queries
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::empty() const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+bool HeapPriorityQueue<T,tgt,arity,GT>::empty() const {
   return used == 0;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::size() const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+int HeapPriorityQueue<T,tgt,arity,GT>::size() const {
   return used;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T& HeapPriorityQueue<T,tgt>::peek () const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+T& HeapPriorityQueue<T,tgt,arity,GT>::peek () const {
   if (empty())
     throw EmptyError("HeapPriorityQueue::peek");
 
@@ -239,14 +261,39 @@ T& HeapPriorityQueue<T,tgt>::peek () const {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::string HeapPriorityQueue<T,tgt>::str() const {
+//The k highest are in the top of the heap: a value can be among them only if
+//  its parent is, so grow the answer from the root, choosing each next value
+//  from the children of those chosen (O(k log k), without changing the heap)
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+auto HeapPriorityQueue<T,tgt,arity,GT>::top_k (int k) const -> ArrayQueue<T> {
+  ArrayQueue<T> answer;
+  if (k <= 0 || empty())
+    return answer;
+
+  std::vector<int> candidates(1,0);                          //Indexes, in a heap ordered by pq[index]
+  auto lower = [this] (int a, int b) {return is_gt(pq[b],pq[a]);};
+  while (answer.size() < k && !candidates.empty()) {
+    std::pop_heap(candidates.begin(), candidates.end(), lower);
+    int i = candidates.back();
+    candidates.pop_back();
+    answer.enqueue(pq[i]);
+    for (int c = first_child(i), last = std::min(c+arity,used); c < last; ++c) {
+      candidates.push_back(c);
+      std::push_heap(candidates.begin(), candidates.end(), lower);
+    }
+  }
+  return answer;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+std::string HeapPriorityQueue<T,tgt,arity,GT>::str() const {
   std::ostringstream answer;
   answer << "HeapPriorityQueue[";
 
-  if (length != 0) {
+  if (used != 0) {
     answer << "0:" << pq[0];
-    for (int i = 1; i < length; ++i)
+    for (int i = 1; i < used; ++i)
       answer << "," << i << ":" << pq[i];
   }
 
@@ -259,46 +306,107 @@ std::string HeapPriorityQueue<T,tgt>::str() const {
 //
 //Commands
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::enqueue(const T& element) {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+int HeapPriorityQueue<T,tgt,arity,GT>::enqueue(const T& element) {
   this->ensure_length(used+1);
-  pq[used++] = element;
+  add(element);
+  ++mod_count;
+  return 1;
+}
+
 
-  this->percolate_up(used-1);
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+int HeapPriorityQueue<T,tgt,arity,GT>::enqueue(T&& element) {
+  this->ensure_length(used+1);
+  add(std::move(element));
   ++mod_count;
   return 1;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T HeapPriorityQueue<T,tgt>::dequeue() {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+T HeapPriorityQueue<T,tgt,arity,GT>::dequeue() {
   if (this->empty())
     throw EmptyError("HeapPriorityQueue::dequeue");
 
-  T to_return = pq[0];
-  pq[0] = pq[--used];
-
-  percolate_down(0);
+  //Bottom-up: move the root's hole to a leaf (1 fewer comparison per level than
+  //  percolate_down), then percolate the last value up from there (usually
+  //  only a level or two, since it came from the bottom)
+  T to_return = std::move(pq[0]);
+  if (--used > 0) {
+    int hole = hole_to_leaf(0);
+    T last = std::move(pq[used]);
+    fill_hole(hole, last);
+  }
+  pq[used].~T();
 
   ++mod_count;
   return to_return;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::clear() {
+//Few values: dequeue each. Many: select the k highest (O(N)), sort them
+//  (O(k log k)), then heapify the rest (O(N)), instead of k percolations
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+int HeapPriorityQueue<T,tgt,arity,GT>::dequeue_n(int k, ArrayQueue<T>& into) {
+  int count = std::min(k,used);
+  if (count <= 0)
+    return 0;
+
+  if (count*levels() <= used) {
+    for (int i=0; i<count; ++i)
+      into.enqueue(dequeue());
+    return count;
+  }
+
+  auto higher = [this] (const T& a, const T& b) {return is_gt(a,b);};
+  if (count < used)
+    std::nth_element(pq, pq+count, pq+used, higher);
+  std::sort(pq, pq+count, higher);
+  for (int i=0; i<count; ++i)
+    into.enqueue(std::move(pq[i]));
+
+  for (int i=count; i<used; ++i)
+    pq[i-count] = std::move(pq[i]);
+  for (int i=used-count; i<used; ++i)
+    pq[i].~T();
+  used -= count;
+  heapify();
+
+  ++mod_count;
+  return count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+void HeapPriorityQueue<T,tgt,arity,GT>::clear() {
+  for (int i=0; i<used; ++i)
+    pq[i].~T();
   used = 0;
   ++mod_count;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
 template <class Iterable>
-int HeapPriorityQueue<T,tgt>::enqueue_all (const Iterable& i) {
-  int count = 0;
-  for (const T& v : i)
-     count += enqueue(v);
+int HeapPriorityQueue<T,tgt,arity,GT>::enqueue_all (const Iterable& i) {
+  int old_used = used;
+  int count    = 0;
+  for (const T& v : i) {
+    this->ensure_length(used+1);
+    new (pq+used++) T(v);
+    ++count;
+  }
 
+  //Percolating each new value up costs about levels() steps; heapify costs O(used)
+  if (count*levels() > used)
+    heapify();
+  else
+    for (int j=old_used; j<used; ++j)
+      percolate_up(j);
+
+  if (count > 0)
+    ++mod_count;
   return count;
 }
 
@@ -307,31 +415,36 @@ int HeapPriorityQueue<T,tgt>::enqueue_all (const Iterable& i) {
 //
 //Operators
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>& HeapPriorityQueue<T,tgt>::operator = (const HeapPriorityQueue<T,tgt>& rhs) {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+HeapPriorityQueue<T,tgt,arity,GT>& HeapPriorityQueue<T,tgt,arity,GT>::operator = (const HeapPriorityQueue<T,tgt,arity,GT>& rhs) {
   if (this == &rhs)
     return *this;
 
   gt = rhs.gt;   // if tgt != nullptr, gts are already equal (or compiler error)
   this->ensure_length(rhs.used);
-  used = rhs.used;
   for (int i=0; i<rhs.used; ++i)
-    pq[i] = rhs.pq[i];
+    if (i < used)
+      pq[i] = rhs.pq[i];
+    else
+      new (pq+i) T(rhs.pq[i]);
+  for (int i=rhs.used; i<used; ++i)
+    pq[i].~T();
+  used = rhs.used;
 
   ++mod_count;
   return *this;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::operator == (const HeapPriorityQueue<T,tgt>& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+bool HeapPriorityQueue<T,tgt,arity,GT>::operator == (const HeapPriorityQueue<T,tgt,arity,GT>& rhs) const {
   if (this == &rhs)
     return true;
   if (gt != rhs.gt) //For PriorityQueues to be equal, they need the same gt function, and values
     return false;
   if (used != rhs.size())
     return false;
-  HeapPriorityQueue<T,tgt>::Iterator l = this->begin(), r = rhs.begin();
+  HeapPriorityQueue<T,tgt,arity,GT>::Iterator l = this->begin(), r = rhs.begin();
   for (int i=0; i<used; ++i, ++l, ++r)
     if (*l != *r)
       return false;
@@ -340,14 +453,14 @@ bool HeapPriorityQueue<T,tgt>::operator == (const HeapPriorityQueue<T,tgt>& rhs)
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::operator != (const HeapPriorityQueue<T,tgt>& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+bool HeapPriorityQueue<T,tgt,arity,GT>::operator != (const HeapPriorityQueue<T,tgt,arity,GT>& rhs) const {
   return !(*this == rhs);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt>& p) {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt,arity,GT>& p) {
   outs << "priority_queue[";
 
   if (!p.empty()) {
@@ -366,15 +479,15 @@ std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt>& p
 //
 //Iterator constructors
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::begin () const -> HeapPriorityQueue<T,tgt>::Iterator {
-    return Iterator(const_cast<HeapPriorityQueue<T,tgt>*>(this),true);
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+auto HeapPriorityQueue<T,tgt,arity,GT>::begin () const -> HeapPriorityQueue<T,tgt,arity,GT>::Iterator {
+    return Iterator(const_cast<HeapPriorityQueue<T,tgt,arity,GT>*>(this),true);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::end () const -> HeapPriorityQueue<T,tgt>::Iterator {
-  return Iterator(const_cast<HeapPriorityQueue<T,tgt>*>(this));  //Create empty pq (size == 0)
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+auto HeapPriorityQueue<T,tgt,arity,GT>::end () const -> HeapPriorityQueue<T,tgt,arity,GT>::Iterator {
+  return Iterator(const_cast<HeapPriorityQueue<T,tgt,arity,GT>*>(this));  //Create empty pq (size == 0)
 }
 
 
@@ -382,94 +495,181 @@ auto HeapPriorityQueue<T,tgt>::end () const -> HeapPriorityQueue<T,tgt>::Iterato
 //
 //Private helper methods
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::ensure_length(int new_length) {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+bool HeapPriorityQueue<T,tgt,arity,GT>::is_gt (const T& a, const T& b) const {
+  return Functor<GT>::call(tgt != nullptr ? tgt : gt, a, b);
+}
+
+
+//The children of i are pq[arity*i+1 .. arity*i+arity], so aligning &pq[1] to a
+//  cache line aligns every child group; one extra T before it holds the root
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+void HeapPriorityQueue<T,tgt,arity,GT>::allocate(int new_length) {
+  const std::size_t alignment = std::max<std::size_t>(cache_line, alignof(T));
+  storage = static_cast<char*>(::operator new((new_length+1)*sizeof(T) + alignment));
+  std::uintptr_t first_child = reinterpret_cast<std::uintptr_t>(storage) + sizeof(T);
+  first_child = (first_child + alignment-1) / alignment * alignment;
+  pq = reinterpret_cast<T*>(first_child) - 1;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+void HeapPriorityQueue<T,tgt,arity,GT>::destroy() {
+  for (int i=0; i<used; ++i)
+    pq[i].~T();
+  ::operator delete(storage);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+void HeapPriorityQueue<T,tgt,arity,GT>::ensure_length(int new_length) {
   if (length >= new_length)
     return;
-  T*  old_pq  = pq;
+  char* old_storage = storage;
+  T*    old_pq      = pq;
   length = std::max(new_length,2*length);
-  pq = new T[length];
-  for (int i=0; i<used; ++i)
-    pq[i] = old_pq[i];
+  allocate(length);
+  for (int i=0; i<used; ++i) {
+    new (pq+i) T(std::move(old_pq[i]));
+    old_pq[i].~T();
+  }
 
-  delete [] old_pq;
+  ::operator delete(old_storage);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::left_child(int i) const
-{return 2*i+1;}
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+int HeapPriorityQueue<T,tgt,arity,GT>::first_child(int i) const
+{return arity*i+1;}
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::right_child(int i) const
-{return 2*i+2;}
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+int HeapPriorityQueue<T,tgt,arity,GT>::parent(int i) const
+{return (i-1)/arity;}
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::parent(int i) const
-{return (i-1)/2;}
-
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::is_root(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+bool HeapPriorityQueue<T,tgt,arity,GT>::is_root(int i) const
 {return i == 0;}
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::in_heap(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+bool HeapPriorityQueue<T,tgt,arity,GT>::in_heap(int i) const
 {return i < used;}
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::percolate_up(int i) {
-  for (/*parameter*/; !is_root(i) && gt(pq[i],pq[parent(i)]); i = parent(i))
-    std::swap(pq[parent(i)],pq[i]);
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+int HeapPriorityQueue<T,tgt,arity,GT>::max_child(int c) const {
+  int max = c;
+  for (int last = std::min(c+arity,used), s = c+1; s < last; ++s)
+    if (is_gt(pq[s],pq[max]))
+      max = s;
+  return max;
+}
+
+
+//Percolation moves a "hole" instead of swapping: each level costs one move,
+//  and the percolated value is written once, where it ends up
+
+//pq[used] is unconstructed: construct it from element, or from its parent
+//  if element must go higher (then the hole moves up through assignment)
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+template <class U>
+void HeapPriorityQueue<T,tgt,arity,GT>::add(U&& element) {
+  int hole = used;
+  if (is_root(hole) || !is_gt(element,pq[parent(hole)])) {
+    new (pq+hole) T(std::forward<U>(element));
+    ++used;
+    return;
+  }
+
+  new (pq+hole) T(std::move(pq[parent(hole)]));
+  ++used;
+  for (hole = parent(hole); !is_root(hole) && is_gt(element,pq[parent(hole)]); hole = parent(hole))
+    pq[hole] = std::move(pq[parent(hole)]);
+  pq[hole] = std::forward<U>(element);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::percolate_down(int i) {
-  for (int l = left_child(i); in_heap(l); l = left_child(i)) {
-    int r = right_child(i);
-    int max_child = (!in_heap(r) || gt(pq[l],pq[r]) ? l : r);
-    if ( gt(pq[i],pq[max_child]) )
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+void HeapPriorityQueue<T,tgt,arity,GT>::fill_hole(int hole, T& element) {
+  for (/*parameter*/; !is_root(hole) && is_gt(element,pq[parent(hole)]); hole = parent(hole))
+    pq[hole] = std::move(pq[parent(hole)]);
+  pq[hole] = std::move(element);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+int HeapPriorityQueue<T,tgt,arity,GT>::hole_to_leaf(int hole) {
+  for (int c = first_child(hole); in_heap(c); c = first_child(hole)) {
+    int max = max_child(c);
+    pq[hole] = std::move(pq[max]);
+    hole = max;
+  }
+  return hole;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+void HeapPriorityQueue<T,tgt,arity,GT>::percolate_up(int i) {
+  T moving = std::move(pq[i]);
+  fill_hole(i, moving);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+void HeapPriorityQueue<T,tgt,arity,GT>::percolate_down(int i) {
+  T moving = std::move(pq[i]);
+  for (int c = first_child(i); in_heap(c); c = first_child(i)) {
+    int max = max_child(c);
+    if ( !is_gt(pq[max],moving) )
        break;
-    std::swap(pq[i],pq[max_child]);
-    i = max_child;
+    pq[i] = std::move(pq[max]);
+    i = max;
   }
+  pq[i] = std::move(moving);
 }
 
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::heapify() {
-for (int i = used-1; i >= 0; --i)
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+void HeapPriorityQueue<T,tgt,arity,GT>::heapify() {
+for (int i = parent(used-1); i >= 0; --i)   //Leaves are already heaps
   percolate_down(i);
 }
 
 
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+int HeapPriorityQueue<T,tgt,arity,GT>::levels() const {
+  int answer = 0;
+  for (int n = used; n > 0; n /= arity)
+    ++answer;
+  return answer;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Iterator class definitions
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::Iterator::Iterator(HeapPriorityQueue<T,tgt>* iterate_over, bool tgt_nullptr)
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+HeapPriorityQueue<T,tgt,arity,GT>::Iterator::Iterator(HeapPriorityQueue<T,tgt,arity,GT>* iterate_over, bool tgt_nullptr)
 : it(*iterate_over,iterate_over->gt), ref_pq(iterate_over), expected_mod_count(iterate_over->mod_count) {
   // Full priority queue; use copy constructor
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::Iterator::Iterator(HeapPriorityQueue<T,tgt>* iterate_over)
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+HeapPriorityQueue<T,tgt,arity,GT>::Iterator::Iterator(HeapPriorityQueue<T,tgt,arity,GT>* iterate_over)
 : it(iterate_over->gt), ref_pq(iterate_over), expected_mod_count(iterate_over->mod_count) {
   // Empty priority queue; use default constructor (from declaration of "it")
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::Iterator::~Iterator()
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+HeapPriorityQueue<T,tgt,arity,GT>::Iterator::~Iterator()
 {}
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T HeapPriorityQueue<T,tgt>::Iterator::erase() {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+T HeapPriorityQueue<T,tgt,arity,GT>::Iterator::erase() {
   if (expected_mod_count != ref_pq->mod_count)
     throw ConcurrentModificationError("HeapPriorityQueue::Iterator::erase");
   if (!can_erase)
@@ -483,9 +683,12 @@ T HeapPriorityQueue<T,tgt>::Iterator::erase() {
   //Find value from it (heap iterating over) in main heap; percolate it
   for (int i=0; i<ref_pq->used; ++i)
     if (ref_pq->pq[i] == to_return) {
-      ref_pq->pq[i] = ref_pq->pq[--ref_pq->used];
-      ref_pq->percolate_up(i);
-      ref_pq->percolate_down(i);
+      if (i != --ref_pq->used) {
+        ref_pq->pq[i] = ref_pq->pq[ref_pq->used];
+        ref_pq->percolate_up(i);
+        ref_pq->percolate_down(i);
+      }
+      ref_pq->pq[ref_pq->used].~T();
       break;
     }
 
@@ -494,8 +697,8 @@ T HeapPriorityQueue<T,tgt>::Iterator::erase() {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::string HeapPriorityQueue<T,tgt>::Iterator::str() const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+std::string HeapPriorityQueue<T,tgt,arity,GT>::Iterator::str() const {
   std::ostringstream answer;
   answer << it.str() << "/expected_mod_count=" << expected_mod_count << "/can_erase=" << can_erase;
   return answer.str();
@@ -503,8 +706,8 @@ std::string HeapPriorityQueue<T,tgt>::Iterator::str() const {
 
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::Iterator::operator ++ () -> HeapPriorityQueue<T,tgt>::Iterator& {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+auto HeapPriorityQueue<T,tgt,arity,GT>::Iterator::operator ++ () -> HeapPriorityQueue<T,tgt,arity,GT>::Iterator& {
 if (expected_mod_count != ref_pq->mod_count)
     throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator ++");
 
@@ -520,8 +723,8 @@ if (expected_mod_count != ref_pq->mod_count)
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::Iterator::operator ++ (int) -> HeapPriorityQueue<T,tgt>::Iterator {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+auto HeapPriorityQueue<T,tgt,arity,GT>::Iterator::operator ++ (int) -> HeapPriorityQueue<T,tgt,arity,GT>::Iterator {
   if (expected_mod_count != ref_pq->mod_count)
     throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator ++(int)");
 
@@ -538,8 +741,8 @@ auto HeapPriorityQueue<T,tgt>::Iterator::operator ++ (int) -> HeapPriorityQueue<
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::Iterator::operator == (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+bool HeapPriorityQueue<T,tgt,arity,GT>::Iterator::operator == (const HeapPriorityQueue<T,tgt,arity,GT>::Iterator& rhs) const {
   const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
   if (rhsASI == 0)
     throw IteratorTypeError("HeapPriorityQueue::Iterator::operator ==");
@@ -553,8 +756,8 @@ bool HeapPriorityQueue<T,tgt>::Iterator::operator == (const HeapPriorityQueue<T,
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::Iterator::operator != (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+bool HeapPriorityQueue<T,tgt,arity,GT>::Iterator::operator != (const HeapPriorityQueue<T,tgt,arity,GT>::Iterator& rhs) const {
   const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
   if (rhsASI == 0)
     throw IteratorTypeError("HeapPriorityQueue::Iterator::operator !=");
@@ -567,8 +770,8 @@ bool HeapPriorityQueue<T,tgt>::Iterator::operator != (const HeapPriorityQueue<T,
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T& HeapPriorityQueue<T,tgt>::Iterator::operator *() const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+T& HeapPriorityQueue<T,tgt,arity,GT>::Iterator::operator *() const {
   if (expected_mod_count != ref_pq->mod_count)
     throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator *");
   if (!can_erase || it.empty())
@@ -578,8 +781,8 @@ T& HeapPriorityQueue<T,tgt>::Iterator::operator *() const {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T* HeapPriorityQueue<T,tgt>::Iterator::operator ->() const {
+template<class T, bool (*tgt)(const T& a, const T& b), int arity, class GT>
+T* HeapPriorityQueue<T,tgt,arity,GT>::Iterator::operator ->() const {
   if (expected_mod_count != ref_pq->mod_count)
     throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator *");
   if (!can_erase || it.empty())
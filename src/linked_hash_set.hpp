@@ -0,0 +1,587 @@
+#ifndef LINKED_HASH_SET_HPP_
+#define LINKED_HASH_SET_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include "ics_exceptions.hpp"
+#include "functor.hpp"
+#include "hash_map.hpp"         //For the index: value -> its LN
+
+
+namespace ics {
+
+
+//A LinkedSet (values in a linked list ending in a trailer LN, iterated in
+//  insertion order) with a HashMap index from each value to its LN, so
+//  contains/insert/erase are O(1) expected instead of O(N).
+//Erasing a value still copies the next value (and LN link) into its LN and
+//  deletes the next LN (or the trailer); the index entry of the copied value
+//  is updated to its new LN.
+//Instantiate the templated class supplying thash(a): produces a hash value for a.
+//If thash is defaulted to nullptr in the template, then a constructor must supply chash.
+//If both thash and chash are supplied, then they must be the same (by ==) function.
+//If neither is supplied, or both are supplied but different, TemplateFunctionError is raised (by the index).
+//Instead, HASH can be a functor type whose HASH()(a) is the hash value (then neither thash nor chash is supplied).
+template<class T, int (*thash)(const T& a) = nullptr, class HASH = void> class LinkedHashSet {
+  public:
+    //Destructor/Constructors
+    ~LinkedHashSet ();
+
+    LinkedHashSet          (double the_load_threshold = 1.0, int (*chash)(const T& a) = nullptr);
+    explicit LinkedHashSet (int initial_bins, double the_load_threshold = 1.0, int (*chash)(const T& k) = nullptr);
+    LinkedHashSet          (const LinkedHashSet<T,thash,HASH>& to_copy, double the_load_threshold = 1.0, int (*chash)(const T& a) = nullptr);
+    explicit LinkedHashSet (const std::initializer_list<T>& il, double the_load_threshold = 1.0, int (*chash)(const T& a) = nullptr);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit LinkedHashSet (const Iterable& i, double the_load_threshold = 1.0, int (*chash)(const T& a) = nullptr);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    bool contains   (const T& element) const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    bool contains_all (const Iterable& i) const;
+
+
+    //Commands
+    int  insert (const T& element);
+    int  erase  (const T& element);
+    void clear  ();
+
+    //Iterable class must support "for" loop: .begin()/.end() and prefix ++ on returned result
+
+    template <class Iterable>
+    int insert_all(const Iterable& i);
+
+    template <class Iterable>
+    int erase_all(const Iterable& i);
+
+    template<class Iterable>
+    int retain_all(const Iterable& i);  //Returns # erased
+
+
+    //Operators
+    LinkedHashSet<T,thash,HASH>& operator = (const LinkedHashSet<T,thash,HASH>& rhs);
+    bool operator == (const LinkedHashSet<T,thash,HASH>& rhs) const;
+    bool operator != (const LinkedHashSet<T,thash,HASH>& rhs) const;
+    bool operator <= (const LinkedHashSet<T,thash,HASH>& rhs) const;
+    bool operator <  (const LinkedHashSet<T,thash,HASH>& rhs) const;
+    bool operator >= (const LinkedHashSet<T,thash,HASH>& rhs) const;
+    bool operator >  (const LinkedHashSet<T,thash,HASH>& rhs) const;
+
+    template<class T2, int (*hash2)(const T2& a), class HASH2>
+    friend std::ostream& operator << (std::ostream& outs, const LinkedHashSet<T2,hash2,HASH2>& s);
+
+
+
+  private:
+    class LN;
+
+  public:
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of LinkedHashSet<T,thash,HASH>
+        ~Iterator();
+        T           erase();
+        std::string str  () const;
+        LinkedHashSet<T,thash,HASH>::Iterator& operator ++ ();
+        LinkedHashSet<T,thash,HASH>::Iterator  operator ++ (int);
+        bool operator == (const LinkedHashSet<T,thash,HASH>::Iterator& rhs) const;
+        bool operator != (const LinkedHashSet<T,thash,HASH>::Iterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const LinkedHashSet<T,thash,HASH>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+        friend Iterator LinkedHashSet<T,thash,HASH>::begin () const;
+        friend Iterator LinkedHashSet<T,thash,HASH>::end   () const;
+
+      private:
+        //If can_erase is false, current indexes the "next" value (must ++ to reach it)
+        LN*                          current;  //if can_erase is false, this value is unusable
+        LinkedHashSet<T,thash,HASH>* ref_set;
+        int                          expected_mod_count;
+        bool                         can_erase = true;
+
+        //Called in friends begin/end
+        Iterator(LinkedHashSet<T,thash,HASH>* iterate_over, LN* initial);
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+    class LN {
+      public:
+        LN ()                      : value(T()) {}
+        LN (const LN& ln)          : value(ln.value), next(ln.next){}
+        LN (T v,  LN* n = nullptr) : value(v), next(n){}
+
+        T   value;
+        LN* next   = nullptr;
+    };
+
+
+    int (*hash)(const T& k);               //Hashing function used (from template, constructor, or copied set)
+    HashMap<T,LN*,thash,HASH> index;       //Each value in the list -> its LN
+    LN* front     = new LN();
+    LN* trailer   = front;                 //Must always point to special trailer LN
+    int used      = 0;                     //Cache of number of values in linked list
+    int mod_count = 0;                     //For sensing concurrent modification
+
+    //Helper methods
+    int  erase_at   (LN* p);
+    void delete_list(LN*& front);          //Deallocate all LNs (but trailer), and set front's argument to trailer;
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//LinkedHashSet class and related definitions
+
+//Destructor/Constructors
+
+template<class T, int (*thash)(const T& a), class HASH>
+LinkedHashSet<T,thash,HASH>::~LinkedHashSet() {
+  delete_list(front);
+  delete trailer;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+LinkedHashSet<T,thash,HASH>::LinkedHashSet(double the_load_threshold, int (*chash)(const T& element))
+: hash(thash != nullptr ? thash : chash), index(the_load_threshold, chash)
+{}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+LinkedHashSet<T,thash,HASH>::LinkedHashSet(int initial_bins, double the_load_threshold, int (*chash)(const T& element))
+: hash(thash != nullptr ? thash : chash), index(initial_bins, the_load_threshold, chash)
+{}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+LinkedHashSet<T,thash,HASH>::LinkedHashSet(const LinkedHashSet<T,thash,HASH>& to_copy, double the_load_threshold, int (*chash)(const T& element))
+: hash(thash != nullptr ? thash : (chash != nullptr ? chash : to_copy.hash)),
+  index(to_copy.size(), the_load_threshold, thash != nullptr ? thash : (chash != nullptr ? chash : to_copy.hash)) {
+  if ((thash != nullptr || !std::is_void<HASH>::value) && chash != nullptr && thash != chash)
+    throw TemplateFunctionError("LinkedHashSet::copy constructor: both specified and different");
+
+  for (LN* p = to_copy.front; p != to_copy.trailer; p = p->next)
+    insert(p->value);
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+LinkedHashSet<T,thash,HASH>::LinkedHashSet(const std::initializer_list<T>& il, double the_load_threshold, int (*chash)(const T& element))
+: hash(thash != nullptr ? thash : chash), index(int(il.size()), the_load_threshold, chash) {
+  for (const T& s_elem : il)
+    insert(s_elem);
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+template<class Iterable>
+LinkedHashSet<T,thash,HASH>::LinkedHashSet(const Iterable& i, double the_load_threshold, int (*chash)(const T& a))
+: hash(thash != nullptr ? thash : chash), index(the_load_threshold, chash) {
+  for (const T& s_elem : i)
+    insert(s_elem);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, int (*thash)(const T& a), class HASH>
+bool LinkedHashSet<T,thash,HASH>::empty() const {
+  return used == 0;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+int LinkedHashSet<T,thash,HASH>::size() const {
+  return used;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+bool LinkedHashSet<T,thash,HASH>::contains (const T& element) const {
+  return index.has_key(element);
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+std::string LinkedHashSet<T,thash,HASH>::str() const {
+  std::ostringstream answer;
+  answer << "linked_hash_set[";
+  for (LN* p = front; p != trailer; p = p->next)
+    answer << p->value << "->";
+  answer << "TRAILER](used=" << used << ",front=" << front << ",trailer=" << trailer << ",mod_count=" << mod_count << ")";
+  return answer.str();
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+template<class Iterable>
+bool LinkedHashSet<T,thash,HASH>::contains_all (const Iterable& i) const {
+  for (const T& v : i)
+    if (!contains(v))
+      return false;
+
+  return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+//The trailer gets the value (and an index entry); a new LN becomes the trailer
+template<class T, int (*thash)(const T& a), class HASH>
+int LinkedHashSet<T,thash,HASH>::insert(const T& element) {
+  if (contains(element))
+    return 0;
+
+  trailer->value = element;
+  index.put(element, trailer);
+  trailer = trailer->next = new LN();
+  ++used;
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+int LinkedHashSet<T,thash,HASH>::erase(const T& element) {
+  if (!contains(element))
+    return 0;
+
+  return erase_at(index[element]);
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+void LinkedHashSet<T,thash,HASH>::clear() {
+  delete_list(front);
+  index.clear();
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+template<class Iterable>
+int LinkedHashSet<T,thash,HASH>::insert_all(const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+    count += insert(v);
+
+  return count;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+template<class Iterable>
+int LinkedHashSet<T,thash,HASH>::erase_all(const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+    count += erase(v);
+
+  return count;
+}
+
+
+//Marks the values of i that are in this set, then erases the unmarked ones
+//  in one pass over the list (keeping the remaining values in order)
+template<class T, int (*thash)(const T& a), class HASH>
+template<class Iterable>
+int LinkedHashSet<T,thash,HASH>::retain_all(const Iterable& i) {
+  HashMap<T,bool,thash,HASH> keep(1.0, hash);
+  for (const T& v : i)
+    if (contains(v))
+      keep[v] = true;
+
+  int count = 0;
+  for (LN* p = front; p != trailer; /*See body*/)
+    if (keep.has_key(p->value))
+      p = p->next;
+    else
+      count += erase_at(p);   //p now stores the next value
+
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T, int (*thash)(const T& a), class HASH>
+LinkedHashSet<T,thash,HASH>& LinkedHashSet<T,thash,HASH>::operator = (const LinkedHashSet<T,thash,HASH>& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  clear();
+  for (LN* p = rhs.front; p != rhs.trailer; p = p->next)
+    insert(p->value);
+  return *this;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+bool LinkedHashSet<T,thash,HASH>::operator == (const LinkedHashSet<T,thash,HASH>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (used != rhs.size())
+    return false;
+
+  return rhs.contains_all(*this);
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+bool LinkedHashSet<T,thash,HASH>::operator != (const LinkedHashSet<T,thash,HASH>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+bool LinkedHashSet<T,thash,HASH>::operator <= (const LinkedHashSet<T,thash,HASH>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (used > rhs.size())
+    return false;
+
+  return rhs.contains_all(*this);
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+bool LinkedHashSet<T,thash,HASH>::operator < (const LinkedHashSet<T,thash,HASH>& rhs) const {
+  if (this == &rhs)
+    return false;
+  if (used >= rhs.size())
+    return false;
+
+  return rhs.contains_all(*this);
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+bool LinkedHashSet<T,thash,HASH>::operator >= (const LinkedHashSet<T,thash,HASH>& rhs) const {
+  return rhs <= *this;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+bool LinkedHashSet<T,thash,HASH>::operator > (const LinkedHashSet<T,thash,HASH>& rhs) const {
+  return rhs < *this;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+std::ostream& operator << (std::ostream& outs, const LinkedHashSet<T,thash,HASH>& s) {
+  outs << "set[";
+
+  int printed = 0;
+  for (const T& v : s)
+    outs << (printed++ == 0 ? "" : ",") << v;
+
+  outs << "]";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class T, int (*thash)(const T& a), class HASH>
+auto LinkedHashSet<T,thash,HASH>::begin () const -> LinkedHashSet<T,thash,HASH>::Iterator {
+  return Iterator(const_cast<LinkedHashSet<T,thash,HASH>*>(this),front);
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+auto LinkedHashSet<T,thash,HASH>::end () const -> LinkedHashSet<T,thash,HASH>::Iterator {
+  return Iterator(const_cast<LinkedHashSet<T,thash,HASH>*>(this),trailer);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, int (*thash)(const T& a), class HASH>
+int LinkedHashSet<T,thash,HASH>::erase_at(LN* p) {
+  index.erase(p->value);
+  if (p->next == trailer) {
+    delete trailer;
+    p->next = nullptr;
+    trailer = p;
+  }else{
+    LN* to_delete = p->next;
+    p->value = to_delete->value;
+    p->next  = to_delete->next;
+    delete to_delete;
+    index[p->value] = p;
+  }
+
+  --used;
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+void LinkedHashSet<T,thash,HASH>::delete_list(LN*& front) {
+  for (LN* p = front; p != trailer; /*See body*/) {
+    LN* to_delete = p;
+    p = p->next;
+    delete to_delete;
+  }
+  front = trailer;
+  used = 0;
+  ++mod_count;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class T, int (*thash)(const T& a), class HASH>
+LinkedHashSet<T,thash,HASH>::Iterator::Iterator(LinkedHashSet<T,thash,HASH>* iterate_over, LN* initial)
+: current(initial), ref_set(iterate_over), expected_mod_count(iterate_over->mod_count)
+{}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+LinkedHashSet<T,thash,HASH>::Iterator::~Iterator()
+{}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+T LinkedHashSet<T,thash,HASH>::Iterator::erase() {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("LinkedHashSet::Iterator::erase");
+  if (!can_erase)
+    throw CannotEraseError("LinkedHashSet::Iterator::erase Iterator cursor already erased");
+  if (current == ref_set->trailer)
+    throw CannotEraseError("LinkedHashSet::Iterator::erase Iterator cursor beyond data structure");
+
+  can_erase = false;
+  T to_return = current->value;
+  ref_set->erase_at(current);   //current now stores the next value (or is the trailer)
+  expected_mod_count = ref_set->mod_count;
+  return to_return;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+std::string LinkedHashSet<T,thash,HASH>::Iterator::str() const {
+  std::ostringstream answer;
+  answer << ref_set->str() << "(current=" << current << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
+  return answer.str();
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+auto LinkedHashSet<T,thash,HASH>::Iterator::operator ++ () -> LinkedHashSet<T,thash,HASH>::Iterator& {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("LinkedHashSet::Iterator::operator ++");
+
+  if (current == ref_set->trailer)
+    return *this;
+
+  if (can_erase)
+    current = current->next;
+  else
+    can_erase = true;   //current already stores the next value: just allow erase
+  return *this;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+auto LinkedHashSet<T,thash,HASH>::Iterator::operator ++ (int) -> LinkedHashSet<T,thash,HASH>::Iterator {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("LinkedHashSet::Iterator::operator ++(int)");
+
+  if (current == ref_set->trailer)
+    return *this;
+
+  Iterator to_return(*this);
+  if (can_erase)
+    current = current->next;
+  else
+    can_erase = true;
+  return to_return;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+bool LinkedHashSet<T,thash,HASH>::Iterator::operator == (const LinkedHashSet<T,thash,HASH>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("LinkedHashSet::Iterator::operator ==");
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("LinkedHashSet::Iterator::operator ==");
+  if (ref_set != rhsASI->ref_set)
+    throw ComparingDifferentIteratorsError("LinkedHashSet::Iterator::operator ==");
+
+  return current == rhsASI->current;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+bool LinkedHashSet<T,thash,HASH>::Iterator::operator != (const LinkedHashSet<T,thash,HASH>::Iterator& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+T& LinkedHashSet<T,thash,HASH>::Iterator::operator *() const {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("LinkedHashSet::Iterator::operator *");
+  if (!can_erase || current == ref_set->trailer) {
+    std::ostringstream where;
+    where << current << " when front = " << ref_set->front << " and trailer = " << ref_set->trailer;
+    throw IteratorPositionIllegal("LinkedHashSet::Iterator::operator * Iterator illegal: "+where.str());
+  }
+
+  return current->value;
+}
+
+
+template<class T, int (*thash)(const T& a), class HASH>
+T* LinkedHashSet<T,thash,HASH>::Iterator::operator ->() const {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("LinkedHashSet::Iterator::operator ->");
+  if (!can_erase || current == ref_set->trailer) {
+    std::ostringstream where;
+    where << current << " when front = " << ref_set->front << " and trailer = " << ref_set->trailer;
+    throw IteratorPositionIllegal("LinkedHashSet::Iterator::operator -> Iterator illegal: "+where.str());
+  }
+
+  return &current->value;
+}
+
+
+}
+
+#endif /* LINKED_HASH_SET_HPP_ */
@@ -6,6 +6,7 @@
 #include <sstream>
 #include <initializer_list>
 #include "ics_exceptions.hpp"
+#include "functor.hpp"
 #include "array_stack.hpp"      //See operator <<
 
 
@@ -14,13 +15,16 @@ namespace ics {
 //Instantiate the template such that tgt(a,b) is true, iff a has higher priority than b
 //With a tgt specified in the template, the constructor cannot specify a cgt.
 //If a tgt is defaulted, then the constructor must supply a cgt (they cannot both be nullptr)
-template<class T, bool (*tgt)(const T& a, const T& b) = nullptr> class LinkedPriorityQueue {
+//Instead, GT can be a functor type whose GT()(a,b) is the priority order (then neither tgt nor cgt is supplied)
+//Values are stored highest priority first (equal priorities in enqueue order); enqueue splices one node into
+//  the list, finding its place by a linear scan, or (after use_index(true)) via a skip-list index: O(log N) expected
+template<class T, bool (*tgt)(const T& a, const T& b) = nullptr, class GT = void> class LinkedPriorityQueue {
   public:
     //Destructor/Constructors
     ~LinkedPriorityQueue();
 
     LinkedPriorityQueue          (bool (*cgt)(const T& a, const T& b) = nullptr);
-    LinkedPriorityQueue          (const LinkedPriorityQueue<T,tgt>& to_copy, bool (*cgt)(const T& a, const T& b) = nullptr);
+    LinkedPriorityQueue          (const LinkedPriorityQueue<T,tgt,GT>& to_copy, bool (*cgt)(const T& a, const T& b) = nullptr);
     explicit LinkedPriorityQueue (const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b) = nullptr);
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
@@ -32,26 +36,30 @@ template<class T, bool (*tgt)(const T& a, const T& b) = nullptr> class LinkedPri
     bool empty      () const;
     int  size       () const;
     T&   peek       () const;
+    bool indexed    () const;
     std::string str () const; //supplies useful debugging information; contrast to operator <<
 
 
     //Commands
-    int  enqueue (const T& element);
-    T    dequeue ();
-    void clear   ();
+    int  enqueue   (const T& element);
+    T    dequeue   ();
+    void clear     ();
+    void use_index (bool on); //Build (or discard) the skip-list index used by enqueue: O(N)
+    int  merge     (LinkedPriorityQueue<T,tgt,GT>&& other); //Splice in all of other's LNs: O(N+M); return # moved
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    //Sorts the values (in new LNs) and merges them into the list: O(N + M Log M)
     template <class Iterable>
     int enqueue_all (const Iterable& i);
 
 
     //Operators
-    LinkedPriorityQueue<T,tgt>& operator = (const LinkedPriorityQueue<T,tgt>& rhs);
-    bool operator == (const LinkedPriorityQueue<T,tgt>& rhs) const;
-    bool operator != (const LinkedPriorityQueue<T,tgt>& rhs) const;
+    LinkedPriorityQueue<T,tgt,GT>& operator = (const LinkedPriorityQueue<T,tgt,GT>& rhs);
+    bool operator == (const LinkedPriorityQueue<T,tgt,GT>& rhs) const;
+    bool operator != (const LinkedPriorityQueue<T,tgt,GT>& rhs) const;
 
-    template<class T2, bool (*gt2)(const T2& a, const T2& b)>
-    friend std::ostream& operator << (std::ostream& outs, const LinkedPriorityQueue<T2,gt2>& pq);
+    template<class T2, bool (*gt2)(const T2& a, const T2& b), class GT2>
+    friend std::ostream& operator << (std::ostream& outs, const LinkedPriorityQueue<T2,gt2,GT2>& pq);
 
 
 
@@ -61,33 +69,33 @@ template<class T, bool (*tgt)(const T& a, const T& b) = nullptr> class LinkedPri
   public:
     class Iterator {
       public:
-        //Private constructor called in begin/end, which are friends of LinkedPriorityQueue<T,tgt>
+        //Private constructor called in begin/end, which are friends of LinkedPriorityQueue<T,tgt,GT>
         ~Iterator();
         T           erase();
         std::string str  () const;
-        LinkedPriorityQueue<T,tgt>::Iterator& operator ++ ();
-        LinkedPriorityQueue<T,tgt>::Iterator  operator ++ (int);
-        bool operator == (const LinkedPriorityQueue<T,tgt>::Iterator& rhs) const;
-        bool operator != (const LinkedPriorityQueue<T,tgt>::Iterator& rhs) const;
+        LinkedPriorityQueue<T,tgt,GT>::Iterator& operator ++ ();
+        LinkedPriorityQueue<T,tgt,GT>::Iterator  operator ++ (int);
+        bool operator == (const LinkedPriorityQueue<T,tgt,GT>::Iterator& rhs) const;
+        bool operator != (const LinkedPriorityQueue<T,tgt,GT>::Iterator& rhs) const;
         T& operator *  () const;
         T* operator -> () const;
-        friend std::ostream& operator << (std::ostream& outs, const LinkedPriorityQueue<T,tgt>::Iterator& i) {
+        friend std::ostream& operator << (std::ostream& outs, const LinkedPriorityQueue<T,tgt,GT>::Iterator& i) {
           outs << i.str(); //Use the same meaning as the debugging .str() method
           return outs;
         }
-        friend Iterator LinkedPriorityQueue<T,tgt>::begin () const;
-        friend Iterator LinkedPriorityQueue<T,tgt>::end   () const;
+        friend Iterator LinkedPriorityQueue<T,tgt,GT>::begin () const;
+        friend Iterator LinkedPriorityQueue<T,tgt,GT>::end   () const;
 
       private:
         //If can_erase is false, current indexes the "next" value (must ++ to reach it)
-        LN*             prev;            //prev should be initalized to the header
-        LN*             current;         //current == prev->next
-        LinkedPriorityQueue<T,tgt>* ref_pq;
-        int             expected_mod_count;
-        bool            can_erase = true;
+        LN*                            prev;            //prev should be initalized to the header
+        LN*                            current;         //current == prev->next
+        LinkedPriorityQueue<T,tgt,GT>* ref_pq;
+        int                            expected_mod_count;
+        bool                           can_erase = true;
 
         //Called in friends begin/end
-        Iterator(LinkedPriorityQueue<T,tgt>* iterate_over, LN* initial);
+        Iterator(LinkedPriorityQueue<T,tgt,GT>* iterate_over, LN* initial);
     };
 
 
@@ -101,19 +109,37 @@ template<class T, bool (*tgt)(const T& a, const T& b) = nullptr> class LinkedPri
         LN ()                      {}
         LN (const LN& ln)          : value(ln.value), next(ln.next){}
         LN (T v,  LN* n = nullptr) : value(v), next(n){}
+        ~LN ()                     {delete[] skip;}
 
         T   value;
-        LN* next = nullptr;
+        LN* next   = nullptr;
+        LN** skip  = nullptr;            //skip[l]: next LN in index level l+1 (only when indexed)
+        int levels = 0;                  //Number of index levels this LN is in (size of skip)
     };
 
 
+    static const int index_levels = 15;  //Index levels above the list; level l+1 links 1/4 of level l's LNs
+
+    static_assert(std::is_void<GT>::value || tgt == nullptr, "LinkedPriorityQueue: specify tgt or GT, not both");
     bool (*gt) (const T& a, const T& b); // The gt used by enqueue (from template or constructor)
     LN* front     =  new LN();
     int used      =  0;                  //Cache for number of values in linked list
     int mod_count =  0;                  //For sensing concurrent modification
+    bool index_on =  false;
+    unsigned int seed = 2463534242u;     //For random_levels
 
     //Helper methods
+    bool is_gt (const T& a, const T& b) const; //True iff a has higher priority than b: via the functor type, tgt or gt (see functor.hpp)
     void delete_list(LN*& front);        //Deallocate all LNs, and set front's argument to nullptr;
+    LN*  find_insert   (const T& element, LN* update[]) const; //Return the LN to splice after; fill update (index predecessors) if indexed
+    int  random_levels ();
+    void link_levels   (LN* node, LN* update[]);  //Add node (just spliced in) to the index
+    void unlink_levels (LN* node);                //Remove node from the index (before it is unspliced)
+    void build_index   ();
+    void drop_index    ();
+    LN*  merge_lists   (LN* a, LN* b) const;      //Merge sorted lists a and b (a's values first among equal priorities)
+    LN*  sort_list     (LN* list, int n) const;   //Stable merge sort of the n LNs in list
+    void splice_sorted (LN* list, int n);         //Merge the n LNs in sorted list into this queue
 };
 
 
@@ -126,29 +152,29 @@ template<class T, bool (*tgt)(const T& a, const T& b) = nullptr> class LinkedPri
 
 //Destructor/Constructors
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-LinkedPriorityQueue<T,tgt>::~LinkedPriorityQueue() {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+LinkedPriorityQueue<T,tgt,GT>::~LinkedPriorityQueue() {
   delete_list(front); //Including header node
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-LinkedPriorityQueue<T,tgt>::LinkedPriorityQueue(bool (*cgt)(const T& a, const T& b))
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+LinkedPriorityQueue<T,tgt,GT>::LinkedPriorityQueue(bool (*cgt)(const T& a, const T& b))
 	:gt (tgt ? tgt: cgt)
 {
-	if (gt == nullptr)
+	if (gt == nullptr && std::is_void<GT>::value)
 		throw TemplateFunctionError("LinkedPriorityQueue::default constructor: neither specified");
-	if (tgt && cgt && tgt != cgt)
+	if ((tgt || !std::is_void<GT>::value) && cgt && tgt != cgt)
 		throw TemplateFunctionError("LinkedPriorityQueue::default constructor: both specified and different");
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-LinkedPriorityQueue<T,tgt>::LinkedPriorityQueue(const LinkedPriorityQueue<T,tgt>& to_copy, bool (*cgt)(const T& a, const T& b))
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+LinkedPriorityQueue<T,tgt,GT>::LinkedPriorityQueue(const LinkedPriorityQueue<T,tgt,GT>& to_copy, bool (*cgt)(const T& a, const T& b))
 	:gt (tgt ? tgt: cgt){
 	if (!gt)
 		gt = to_copy.gt;
-	if (tgt && cgt && tgt != cgt)
+	if ((tgt || !std::is_void<GT>::value) && cgt && tgt != cgt)
 		throw TemplateFunctionError("LinkedPriorityQueue::copy constructor: both specified and different");
 	if (gt == to_copy.gt){
 		used = to_copy.used;
@@ -161,33 +187,32 @@ LinkedPriorityQueue<T,tgt>::LinkedPriorityQueue(const LinkedPriorityQueue<T,tgt>
 		for (LN *copy_ln = to_copy.front->next; copy_ln; copy_ln = copy_ln->next)
 			enqueue(copy_ln->value);
 	}
+	use_index(to_copy.index_on);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-LinkedPriorityQueue<T,tgt>::LinkedPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b))
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+LinkedPriorityQueue<T,tgt,GT>::LinkedPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b))
 	:gt(tgt ? tgt: cgt)
 {
-	if (gt == nullptr)
+	if (gt == nullptr && std::is_void<GT>::value)
 	    throw TemplateFunctionError("LinkedPriorityQueue::initializer_list constructor: neither specified");
-	if (tgt != nullptr && cgt != nullptr && tgt != cgt)
+	if ((tgt != nullptr || !std::is_void<GT>::value) && cgt != nullptr && tgt != cgt)
 	    throw TemplateFunctionError("LinkedPriorityQueue::initializer_list constructor: both specified and different");
-	for (auto &i : il)
-		enqueue(i);
+	enqueue_all(il);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
 template<class Iterable>
-LinkedPriorityQueue<T,tgt>::LinkedPriorityQueue(const Iterable& i, bool (*cgt)(const T& a, const T& b))
+LinkedPriorityQueue<T,tgt,GT>::LinkedPriorityQueue(const Iterable& i, bool (*cgt)(const T& a, const T& b))
 	:gt(tgt ? tgt: cgt)
 {
-	if (gt == nullptr)
+	if (gt == nullptr && std::is_void<GT>::value)
 		throw TemplateFunctionError("ArrayPriorityQueue::Iterable constructor: neither specified");
-	if (tgt != nullptr && cgt != nullptr && tgt != cgt)
+	if ((tgt != nullptr || !std::is_void<GT>::value) && cgt != nullptr && tgt != cgt)
 	    throw TemplateFunctionError("ArrayPriorityQueue::Iterable constructor: both specified and different");
-	for (auto item : i)
-		enqueue(item);
+	enqueue_all(i);
 }
 
 
@@ -195,34 +220,40 @@ LinkedPriorityQueue<T,tgt>::LinkedPriorityQueue(const Iterable& i, bool (*cgt)(c
 //
 //Queries
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool LinkedPriorityQueue<T,tgt>::empty() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool LinkedPriorityQueue<T,tgt,GT>::empty() const {
 	return used == 0;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int LinkedPriorityQueue<T,tgt>::size() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+int LinkedPriorityQueue<T,tgt,GT>::size() const {
 	return used;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T& LinkedPriorityQueue<T,tgt>::peek () const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T& LinkedPriorityQueue<T,tgt,GT>::peek () const {
 	if (empty())
 	    throw EmptyError("ArrayPriorityQueue::peek");
 	return front->next->value;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::string LinkedPriorityQueue<T,tgt>::str() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool LinkedPriorityQueue<T,tgt,GT>::indexed () const {
+	return index_on;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+std::string LinkedPriorityQueue<T,tgt,GT>::str() const {
 	std::ostringstream result;
 	result << "linked_queue[HEADER";
 	for (LN* it = front->next; it; it=it->next)
 		result << "->" << it->value;
 	result << "](used=" << used << ",front=" << front <<
-	",mod_count=" << mod_count << ")";
+	",mod_count=" << mod_count << ",indexed=" << index_on << ")";
 	return result.str();
 }
 
@@ -231,24 +262,27 @@ std::string LinkedPriorityQueue<T,tgt>::str() const {
 //
 //Commands
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int LinkedPriorityQueue<T,tgt>::enqueue(const T& element) {
-	front->value = element;
-	front = new LN(T(), front);
-	for (LN *temp = front->next; temp && temp->next && !gt(temp->value, temp->next->value); temp=temp->next)
-		std::swap(temp->value, temp->next->value);
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+int LinkedPriorityQueue<T,tgt,GT>::enqueue(const T& element) {
+	LN* update[index_levels];
+	LN* prev = find_insert(element, update);
+	prev->next = new LN(element, prev->next);
+	if (index_on)
+		link_levels(prev->next, update);
 	used++;
 	mod_count++;
 	return 1;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T LinkedPriorityQueue<T,tgt>::dequeue() {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T LinkedPriorityQueue<T,tgt,GT>::dequeue() {
 	if (this->empty())
 	    throw EmptyError("ArrayPriorityQueue::dequeue");
 	LN *temp = front->next;
 	T to_return = temp->value;
+	if (index_on)
+		unlink_levels(temp);
 	front->next = front->next->next;
 	delete temp;
 	--used;
@@ -257,30 +291,66 @@ T LinkedPriorityQueue<T,tgt>::dequeue() {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void LinkedPriorityQueue<T,tgt>::clear() {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void LinkedPriorityQueue<T,tgt,GT>::clear() {
 	delete_list(front->next);
 	front->next = nullptr;
+	for (int l = 0; l < front->levels; ++l)
+		front->skip[l] = nullptr;
 	mod_count++;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void LinkedPriorityQueue<T,tgt,GT>::use_index (bool on) {
+	drop_index();
+	if (on)
+		build_index();
+	index_on = on;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
 template <class Iterable>
-int LinkedPriorityQueue<T,tgt>::enqueue_all (const Iterable& i) {
+int LinkedPriorityQueue<T,tgt,GT>::enqueue_all (const Iterable& i) {
 	int count = 0;
-	for (auto &it : i)
-		enqueue(it), count++;
+	LN* batch = nullptr;
+	LN** rear = &batch;
+	for (auto &it : i) {
+		*rear = new LN(it);
+		rear = &(*rear)->next;
+		count++;
+	}
+	if (count > 0)
+		splice_sorted(sort_list(batch, count), count);
 	return count;
 }
 
 
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+int LinkedPriorityQueue<T,tgt,GT>::merge (LinkedPriorityQueue<T,tgt,GT>&& other) {
+	if (this == &other || other.empty())
+		return 0;
+	if (gt != other.gt)
+		throw TemplateFunctionError("LinkedPriorityQueue::merge: different gt functions");
+	int moved = other.used;
+	LN* list = other.front->next;
+	other.drop_index();           //other's towers would index the wrong list
+	other.front->next = nullptr;
+	other.used = 0;
+	other.use_index(other.index_on);
+	other.mod_count++;
+	splice_sorted(list, moved);
+	return moved;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Operators
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-LinkedPriorityQueue<T,tgt>& LinkedPriorityQueue<T,tgt>::operator = (const LinkedPriorityQueue<T,tgt>& rhs) {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+LinkedPriorityQueue<T,tgt,GT>& LinkedPriorityQueue<T,tgt,GT>::operator = (const LinkedPriorityQueue<T,tgt,GT>& rhs) {
 	if (this == &rhs)
 	    return *this;
 	LN *temp = front;
@@ -294,12 +364,13 @@ LinkedPriorityQueue<T,tgt>& LinkedPriorityQueue<T,tgt>::operator = (const Linked
 		delete_list(temp->next);
 	gt = rhs.gt;
 	used = rhs.size();
+	use_index(rhs.index_on); //Values moved between LNs: any index is stale
 	return *this;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool LinkedPriorityQueue<T,tgt>::operator == (const LinkedPriorityQueue<T,tgt>& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool LinkedPriorityQueue<T,tgt,GT>::operator == (const LinkedPriorityQueue<T,tgt,GT>& rhs) const {
 	if (this == &rhs) return true;
 	if (gt != rhs.gt) return false;
 	if (used != rhs.size()) return false;
@@ -309,14 +380,14 @@ bool LinkedPriorityQueue<T,tgt>::operator == (const LinkedPriorityQueue<T,tgt>&
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool LinkedPriorityQueue<T,tgt>::operator != (const LinkedPriorityQueue<T,tgt>& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool LinkedPriorityQueue<T,tgt,GT>::operator != (const LinkedPriorityQueue<T,tgt,GT>& rhs) const {
 	return !(*this == rhs);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::ostream& operator << (std::ostream& outs, const LinkedPriorityQueue<T,tgt>& pq) {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+std::ostream& operator << (std::ostream& outs, const LinkedPriorityQueue<T,tgt,GT>& pq) {
 	outs << "priority_queue[";
 	if (!pq.empty()){
 		std::string temp;
@@ -337,15 +408,15 @@ std::ostream& operator << (std::ostream& outs, const LinkedPriorityQueue<T,tgt>&
 //Iterator constructors
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto LinkedPriorityQueue<T,tgt>::begin () const -> LinkedPriorityQueue<T,tgt>::Iterator {
-	return Iterator(const_cast<LinkedPriorityQueue<T,tgt>*>(this),front->next);
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto LinkedPriorityQueue<T,tgt,GT>::begin () const -> LinkedPriorityQueue<T,tgt,GT>::Iterator {
+	return Iterator(const_cast<LinkedPriorityQueue<T,tgt,GT>*>(this),front->next);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto LinkedPriorityQueue<T,tgt>::end () const -> LinkedPriorityQueue<T,tgt>::Iterator {
-	return Iterator(const_cast<LinkedPriorityQueue<T,tgt>*>(this),nullptr);
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto LinkedPriorityQueue<T,tgt,GT>::end () const -> LinkedPriorityQueue<T,tgt,GT>::Iterator {
+	return Iterator(const_cast<LinkedPriorityQueue<T,tgt,GT>*>(this),nullptr);
 }
 
 
@@ -353,8 +424,14 @@ auto LinkedPriorityQueue<T,tgt>::end () const -> LinkedPriorityQueue<T,tgt>::Ite
 //
 //Private helper methods
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void LinkedPriorityQueue<T,tgt>::delete_list(LN*& front) {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool LinkedPriorityQueue<T,tgt,GT>::is_gt (const T& a, const T& b) const {
+	return Functor<GT>::call(tgt != nullptr ? tgt : gt, a, b);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void LinkedPriorityQueue<T,tgt,GT>::delete_list(LN*& front) {
 	for (LN* temp = front; front; temp = front){
 		front = front->next;
 		delete temp;
@@ -363,6 +440,129 @@ void LinkedPriorityQueue<T,tgt>::delete_list(LN*& front) {
 }
 
 
+//Without the index, scan the list; with it, descend the index levels first
+//Either way, pass all values with priority >= element's (so equal priorities stay in enqueue order)
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto LinkedPriorityQueue<T,tgt,GT>::find_insert (const T& element, LN* update[]) const -> LN* {
+	LN* prev = front;
+	if (index_on)
+		for (int l = index_levels-1; l >= 0; --l) {
+			while (prev->skip[l] && !is_gt(element, prev->skip[l]->value))
+				prev = prev->skip[l];
+			update[l] = prev;
+		}
+	while (prev->next && !is_gt(element, prev->next->value))
+		prev = prev->next;
+	return prev;
+}
+
+
+//Geometric with p = 1/4, from an xorshift generator
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+int LinkedPriorityQueue<T,tgt,GT>::random_levels () {
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	int levels = 0;
+	for (unsigned int bits = seed; levels < index_levels && (bits & 3) == 0; bits >>= 2)
+		++levels;
+	return levels;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void LinkedPriorityQueue<T,tgt,GT>::link_levels (LN* node, LN* update[]) {
+	node->levels = random_levels();
+	if (node->levels == 0)
+		return;
+	node->skip = new LN*[node->levels];
+	for (int l = 0; l < node->levels; ++l) {
+		node->skip[l] = update[l]->skip[l];
+		update[l]->skip[l] = node;
+	}
+}
+
+
+//Above node's levels, pass only values with higher priority (all before node);
+//  in node's levels, continue to node itself (past any equal priorities)
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void LinkedPriorityQueue<T,tgt,GT>::unlink_levels (LN* node) {
+	LN* prev = front;
+	for (int l = index_levels-1; l >= 0; --l)
+		if (l >= node->levels)
+			while (prev->skip[l] && is_gt(prev->skip[l]->value, node->value))
+				prev = prev->skip[l];
+		else {
+			while (prev->skip[l] != node)
+				prev = prev->skip[l];
+			prev->skip[l] = node->skip[l];
+		}
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void LinkedPriorityQueue<T,tgt,GT>::build_index () {
+	LN* rear[index_levels];
+	front->levels = index_levels;
+	front->skip = new LN*[index_levels];
+	for (int l = 0; l < index_levels; ++l)
+		front->skip[l] = nullptr, rear[l] = front;
+	for (LN* temp = front->next; temp; temp = temp->next) {
+		link_levels(temp, rear);  //Appends temp at each of its levels
+		for (int l = 0; l < temp->levels; ++l)
+			rear[l] = temp;
+	}
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto LinkedPriorityQueue<T,tgt,GT>::merge_lists (LN* a, LN* b) const -> LN* {
+	LN* merged = nullptr;
+	LN** rear = &merged;
+	while (a && b)
+		if (is_gt(b->value, a->value))
+			*rear = b, rear = &b->next, b = b->next;
+		else
+			*rear = a, rear = &a->next, a = a->next;
+	*rear = (a ? a : b);
+	return merged;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto LinkedPriorityQueue<T,tgt,GT>::sort_list (LN* list, int n) const -> LN* {
+	if (n <= 1)
+		return list;
+	LN* last_left = list;
+	for (int i = 1; i < n/2; ++i)
+		last_left = last_left->next;
+	LN* right = last_left->next;
+	last_left->next = nullptr;
+	return merge_lists(sort_list(list, n/2), sort_list(right, n-n/2));
+}
+
+
+//If indexed, rebuilds the index over the merged list: O(N+M)
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void LinkedPriorityQueue<T,tgt,GT>::splice_sorted (LN* list, int n) {
+	front->next = merge_lists(front->next, list);
+	used += n;
+	mod_count++;
+	if (index_on)
+		use_index(true);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void LinkedPriorityQueue<T,tgt,GT>::drop_index () {
+	for (LN* temp = front; temp; temp = temp->next) {
+		delete[] temp->skip;
+		temp->skip = nullptr;
+		temp->levels = 0;
+	}
+}
+
+
 
 
 
@@ -370,20 +570,20 @@ void LinkedPriorityQueue<T,tgt>::delete_list(LN*& front) {
 //
 //Iterator class definitions
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-LinkedPriorityQueue<T,tgt>::Iterator::Iterator(LinkedPriorityQueue<T,tgt>* iterate_over, LN* initial)
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+LinkedPriorityQueue<T,tgt,GT>::Iterator::Iterator(LinkedPriorityQueue<T,tgt,GT>* iterate_over, LN* initial)
 	:current(initial), ref_pq(iterate_over), prev(iterate_over->front), expected_mod_count(ref_pq->mod_count)
 {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-LinkedPriorityQueue<T,tgt>::Iterator::~Iterator()
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+LinkedPriorityQueue<T,tgt,GT>::Iterator::~Iterator()
 {}
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T LinkedPriorityQueue<T,tgt>::Iterator::erase() {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T LinkedPriorityQueue<T,tgt,GT>::Iterator::erase() {
 	if (expected_mod_count != ref_pq->mod_count)
 		throw ConcurrentModificationError("LinkedPriorityQueue::Iterator::erase");
 	if (!can_erase)
@@ -395,6 +595,8 @@ T LinkedPriorityQueue<T,tgt>::Iterator::erase() {
 		ref_pq->dequeue();
 	}
 	else{
+		if (ref_pq->index_on)
+			ref_pq->unlink_levels(current);
 		prev->next = current->next;
 		delete current;
 		current = prev->next;
@@ -406,16 +608,16 @@ T LinkedPriorityQueue<T,tgt>::Iterator::erase() {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::string LinkedPriorityQueue<T,tgt>::Iterator::str() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+std::string LinkedPriorityQueue<T,tgt,GT>::Iterator::str() const {
 	std::ostringstream answer;
 	answer << ref_pq->str() << "(current=" << current->value << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
 	return answer.str();
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto LinkedPriorityQueue<T,tgt>::Iterator::operator ++ () -> LinkedPriorityQueue<T,tgt>::Iterator& {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto LinkedPriorityQueue<T,tgt,GT>::Iterator::operator ++ () -> LinkedPriorityQueue<T,tgt,GT>::Iterator& {
 	if (expected_mod_count != ref_pq->mod_count)
 		throw ConcurrentModificationError("LinkedPriorityQueue::Iterator::operator ++");
 	if (!current)
@@ -428,8 +630,8 @@ auto LinkedPriorityQueue<T,tgt>::Iterator::operator ++ () -> LinkedPriorityQueue
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto LinkedPriorityQueue<T,tgt>::Iterator::operator ++ (int) -> LinkedPriorityQueue<T,tgt>::Iterator {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto LinkedPriorityQueue<T,tgt,GT>::Iterator::operator ++ (int) -> LinkedPriorityQueue<T,tgt,GT>::Iterator {
 	if (expected_mod_count != ref_pq->mod_count)
 		throw ConcurrentModificationError("LinkedPriorityQueue::Iterator::operator ++");
 	Iterator to_return(*this);
@@ -443,8 +645,8 @@ auto LinkedPriorityQueue<T,tgt>::Iterator::operator ++ (int) -> LinkedPriorityQu
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool LinkedPriorityQueue<T,tgt>::Iterator::operator == (const LinkedPriorityQueue<T,tgt>::Iterator& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool LinkedPriorityQueue<T,tgt,GT>::Iterator::operator == (const LinkedPriorityQueue<T,tgt,GT>::Iterator& rhs) const {
 	const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
 	if (rhsASI == 0)
 		throw IteratorTypeError("LinkedPriorityQueue::Iterator::operator ==");
@@ -456,8 +658,8 @@ bool LinkedPriorityQueue<T,tgt>::Iterator::operator == (const LinkedPriorityQueu
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool LinkedPriorityQueue<T,tgt>::Iterator::operator != (const LinkedPriorityQueue<T,tgt>::Iterator& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool LinkedPriorityQueue<T,tgt,GT>::Iterator::operator != (const LinkedPriorityQueue<T,tgt,GT>::Iterator& rhs) const {
 	const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
 	if (rhsASI == 0)
 		throw IteratorTypeError("LinkedPriorityQueue::Iterator::operator !=");
@@ -468,8 +670,8 @@ bool LinkedPriorityQueue<T,tgt>::Iterator::operator != (const LinkedPriorityQueu
 	return current != rhsASI->current;
 }
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T& LinkedPriorityQueue<T,tgt>::Iterator::operator *() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T& LinkedPriorityQueue<T,tgt,GT>::Iterator::operator *() const {
 	if (expected_mod_count != ref_pq->mod_count)
 		throw ConcurrentModificationError("LinkedPriorityQueue::Iterator::operator *");
 	if (!can_erase || !current) {
@@ -481,8 +683,8 @@ T& LinkedPriorityQueue<T,tgt>::Iterator::operator *() const {
 	return current->value;
 }
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T* LinkedPriorityQueue<T,tgt>::Iterator::operator ->() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T* LinkedPriorityQueue<T,tgt,GT>::Iterator::operator ->() const {
 	if (expected_mod_count != ref_pq->mod_count)
 		throw ConcurrentModificationError("LinkedPriorityQueue::Iterator::operator ->");
 	if (!can_erase || !current) {
@@ -6,12 +6,19 @@
 #include <sstream>
 #include <initializer_list>
 #include <iterator>
+#include <new>                  //For placement new
+#include <utility>              //For std::move
 #include "ics_exceptions.hpp"
 
 
 namespace ics {
 
 
+//Values are stored in a linked list of blocks (LB), each storing up to block_size
+//  values contiguously: enqueue constructs values at the end of the rear block,
+//  dequeue destroys them at the start of the front block. A block is allocated
+//  (or reused) only every block_size enqueues, and a block emptied by dequeue is
+//  kept on a short free list for reuse, rather than deleted.
 template<class T> class LinkedQueue {
   public:
     //Destructor/Constructors
@@ -54,7 +61,7 @@ template<class T> class LinkedQueue {
 
 
   private:
-    class LN;
+    class LB;
 
   public:
     class Iterator {
@@ -77,15 +84,16 @@ template<class T> class LinkedQueue {
         friend Iterator LinkedQueue<T>::end   () const;
 
       private:
-        //If can_erase is false, current indexes the "next" value (must ++ to reach it)
-        LN*             prev = nullptr;  //if nullptr, current at front of list
-        LN*             current;         //current == prev->next (if prev != nullptr)
+        //If can_erase is false, current/index is the "next" value (must ++ to reach it)
+        LB*             prev = nullptr;  //if nullptr, current is the front block
+        LB*             current;         //current == prev->next (if prev != nullptr); nullptr at end
+        int             index;           //Position of the value in current
         LinkedQueue<T>* ref_queue;
         int             expected_mod_count;
         bool            can_erase = true;
 
         //Called in friends begin/end
-        Iterator(LinkedQueue<T>* iterate_over, LN* initial);
+        Iterator(LinkedQueue<T>* iterate_over, LB* initial);
     };
 
 
@@ -94,24 +102,32 @@ template<class T> class LinkedQueue {
 
 
   private:
-    class LN {
+    static const int block_size = 64;   //Values per LB
+    static const int max_free   = 2;    //Emptied LBs kept for reuse
+
+    class LB {
       public:
-        LN ()                      {}
-        LN (const LN& ln)          : value(ln.value), next(ln.next){}
-        LN (T v,  LN* n = nullptr) : value(v), next(n){}
+        T* value (int i) {return reinterpret_cast<T*>(storage) + i;}
 
-        T   value;
-        LN* next = nullptr;
+        alignas(T) unsigned char storage[block_size*sizeof(T)];
+        int first = 0;                   //Values are constructed in value(first) .. value(last-1)
+        int last  = 0;
+        LB* next  = nullptr;
     };
 
 
-    LN* front     =  nullptr;
-    LN* rear      =  nullptr;
-    int used      =  0;            //Cache for number of values in linked list
-    int mod_count =  0;            //For sensing any concurrent modifications
+    LB* front       =  nullptr;
+    LB* rear        =  nullptr;
+    LB* free_blocks =  nullptr;    //Emptied LBs (linked by next), for reuse by enqueue
+    int free_count  =  0;
+    int used        =  0;          //Cache for number of values in linked list
+    int mod_count   =  0;          //For sensing any concurrent modifications
 
     //Helper methods
-    void delete_list(LN*& front);  //Deallocate all LNs, and set front's argument to nullptr;
+    LB*  new_block  ();            //From free_blocks if possible; empty, with next == nullptr
+    void free_block (LB* b);       //b must be empty: keep it in free_blocks or delete it
+    void unlink     (LB* b, LB* prev); //Remove empty b (after prev, or front if prev == nullptr) from the list
+    void delete_list(LB*& front);  //Destroy all values; deallocate all LBs, and set front's argument to nullptr;
 };
 
 
@@ -127,6 +143,7 @@ template<class T> class LinkedQueue {
 template<class T>
 LinkedQueue<T>::~LinkedQueue(){
 	delete_list(front);
+	delete_list(free_blocks);
 }
 
 
@@ -139,30 +156,26 @@ LinkedQueue<T>::LinkedQueue()
 template<class T>
 LinkedQueue<T>::LinkedQueue(const LinkedQueue<T>& to_copy)
 {
-	LN *_temp = to_copy.front;
-	for (front = rear = new LN(_temp->value, nullptr); _temp->next; _temp=_temp->next)
-		enqueue(_temp->next->value);
-	used++;
+	for (LB* b = to_copy.front; b; b = b->next)
+		for (int i = b->first; i < b->last; ++i)
+			enqueue(*b->value(i));
+	mod_count = 0;
 }
 
 
 template<class T>
 LinkedQueue<T>::LinkedQueue(const std::initializer_list<T>& il)
 {
-	if (il.size() > 0){
-		const T* it = il.begin();
-		front = rear = new LN(*(it++));
-		for (; it != il.end(); ++it)
-			enqueue(*it);
-		used++;
-	}
+	enqueue_all(il);
+	mod_count = 0;
 }
 
 
 template<class T>
 template<class Iterable>
 LinkedQueue<T>::LinkedQueue(const Iterable& i) {
-	used = enqueue_all(i);
+	enqueue_all(i);
+	mod_count = 0;
 }
 
 
@@ -185,8 +198,8 @@ int LinkedQueue<T>::size() const {
 template<class T>
 T& LinkedQueue<T>::peek () const {
 	if (this->empty())
-	    throw EmptyError("ArrayQueue::peek");
-	return front->value;
+	    throw EmptyError("LinkedQueue::peek");
+	return *front->value(front->first);
 }
 
 
@@ -194,13 +207,14 @@ template<class T>
 std::string LinkedQueue<T>::str() const {
 	std::ostringstream result;
 	result << "linked_queue[";
-	if(!empty()){
-		result << front->value;
-		for (LN* it = front->next; it; it=it->next)
-			result << "->" << it->value;
+	int blocks = 0;
+	for (LB* b = front; b; b = b->next, ++blocks){
+		result << (blocks == 0 ? "" : "|");
+		for (int i = b->first; i < b->last; ++i)
+			result << (i == b->first ? "" : "->") << *b->value(i);
 	}
-	result << "](used=" << used << ",front=" << front <<
-					",rear=" << rear << ",mod_count=" << mod_count << ")";
+	result << "](used=" << used << ",blocks=" << blocks << ",free_blocks=" << free_count <<
+					",front=" << front << ",rear=" << rear << ",mod_count=" << mod_count << ")";
 	return result.str();
 }
 
@@ -211,7 +225,12 @@ std::string LinkedQueue<T>::str() const {
 
 template<class T>
 int LinkedQueue<T>::enqueue(const T& element) {
-	rear = (front ? rear->next : front) = new LN(element);
+	if (!rear || rear->last == block_size){
+		LB* b = new_block();
+		rear = (front ? rear->next : front) = b;
+	}
+	new (rear->value(rear->last)) T(element);
+	++rear->last;
 	++mod_count, ++used;
 	return 1;
 }
@@ -219,10 +238,13 @@ int LinkedQueue<T>::enqueue(const T& element) {
 
 template<class T>
 T LinkedQueue<T>::dequeue() {
-	LN* temp = front;
-	T result = temp->value;
-	front = front->next;
-	delete temp;
+	if (this->empty())
+	    throw EmptyError("LinkedQueue::dequeue");
+	T* v = front->value(front->first++);
+	T result(std::move(*v));
+	v->~T();
+	if (front->first == front->last)
+		unlink(front, nullptr);
 	--used, ++mod_count;
 	return result;
 }
@@ -230,7 +252,16 @@ T LinkedQueue<T>::dequeue() {
 
 template<class T>
 void LinkedQueue<T>::clear() {
-	delete_list(front);
+	while (front){
+		LB* b = front;
+		for (int i = b->first; i < b->last; ++i)
+			b->value(i)->~T();
+		b->first = b->last = 0;
+		front = front->next;
+		free_block(b);
+	}
+	rear = nullptr;
+	used = 0;
 	++mod_count;
 }
 
@@ -253,35 +284,20 @@ template<class T>
 LinkedQueue<T>& LinkedQueue<T>::operator = (const LinkedQueue<T>& rhs) {
 	if (this == &rhs)
 		return *this;
-	if (rhs.empty()) {
-		delete_list(front);
-		return *this;
-	}
-	if (this->empty()){
-		front = rear = new LN(rhs.front->value);
-		for (LN *rhs_temp = rhs.front->next; rhs_temp; rhs_temp=rhs_temp->next, rear = rear->next)
-			rear->next = new LN(rhs_temp->value);
-	}
-	else {
-		for (LN* temp = front, *rhs_temp = rhs.front; rhs_temp;rhs_temp = rhs_temp->next){
-			temp->value = rhs_temp->value;
-			if (temp->next)
-				rear = temp = temp->next;
-			else if (rhs_temp->next)
-				rear = temp = temp->next = new LN();
-		}
-		delete_list(rear->next);
-	}
-	used = rhs.size(), ++mod_count;
+	clear();                       //Keeps up to max_free LBs for the enqueues
+	for (LB* b = rhs.front; b; b = b->next)
+		for (int i = b->first; i < b->last; ++i)
+			enqueue(*b->value(i));
 	return *this;
 }
 
 
 template<class T>
 bool LinkedQueue<T>::operator == (const LinkedQueue<T>& rhs) const {
+	if (this == &rhs) return 1;
 	if (used != rhs.used) return 0;
-	for (LN *this_it = front, *rhs_it = rhs.front; this_it && rhs_it; this_it = this_it->next, rhs_it = rhs_it->next){
-		if (this_it->value != rhs_it->value) return 0;
+	for (auto this_it = begin(), rhs_it = rhs.begin(); this_it != end(); ++this_it, ++rhs_it){
+		if (*this_it != *rhs_it) return 0;
 	}
 	return 1;
 }
@@ -327,13 +343,47 @@ auto LinkedQueue<T>::end () const -> LinkedQueue<T>::Iterator {
 //Private helper methods
 
 template<class T>
-void LinkedQueue<T>::delete_list(LN*& front) {
-	for (LN* temp = front; front; temp = front){
+auto LinkedQueue<T>::new_block() -> LB* {
+	if (!free_blocks)
+		return new LB;
+	LB* b = free_blocks;
+	free_blocks = free_blocks->next;
+	--free_count;
+	b->next = nullptr;
+	return b;
+}
+
+
+template<class T>
+void LinkedQueue<T>::free_block(LB* b) {
+	if (free_count == max_free){
+		delete b;
+		return;
+	}
+	b->first = b->last = 0;
+	b->next = free_blocks;
+	free_blocks = b;
+	++free_count;
+}
+
+
+template<class T>
+void LinkedQueue<T>::unlink(LB* b, LB* prev) {
+	(prev ? prev->next : front) = b->next;
+	if (b == rear)
+		rear = prev;
+	free_block(b);
+}
+
+
+template<class T>
+void LinkedQueue<T>::delete_list(LB*& front) {
+	for (LB* temp = front; front; temp = front){
 		front = front->next;
+		for (int i = temp->first; i < temp->last; ++i)
+			temp->value(i)->~T();
 		delete temp;
 	}
-	used = 0;
-	rear = nullptr;
 }
 
 
@@ -345,8 +395,8 @@ void LinkedQueue<T>::delete_list(LN*& front) {
 //Iterator class definitions
 
 template<class T>
-LinkedQueue<T>::Iterator::Iterator(LinkedQueue<T>* iterate_over, LN* initial)
-	:current(initial), ref_queue(iterate_over), expected_mod_count(ref_queue->mod_count)
+LinkedQueue<T>::Iterator::Iterator(LinkedQueue<T>* iterate_over, LB* initial)
+	:current(initial), index(initial ? initial->first : 0), ref_queue(iterate_over), expected_mod_count(ref_queue->mod_count)
 {
 }
 
@@ -356,27 +406,41 @@ LinkedQueue<T>::Iterator::~Iterator()
 {}
 
 
+//Erasing the front value is a dequeue; erasing any other shifts the values
+//  after it in its block (at most block_size-1) toward the front
 template<class T>
 T LinkedQueue<T>::Iterator::erase() {
 	if (expected_mod_count != ref_queue->mod_count)
-		throw ConcurrentModificationError("ArrayQueue::Iterator::erase");
+		throw ConcurrentModificationError("LinkedQueue::Iterator::erase");
 	if (!can_erase)
-	    throw CannotEraseError("ArrayQueue::Iterator::erase Iterator cursor already erased");
+	    throw CannotEraseError("LinkedQueue::Iterator::erase Iterator cursor already erased");
+	if (!current)
+	    throw CannotEraseError("LinkedQueue::Iterator::erase Iterator cursor beyond data structure");
 	can_erase = false;
 
-	T to_return = current->value;
-	if (!prev){
+	T to_return(std::move(*current->value(index)));
+	if (index == current->first)
+		current->value(current->first++)->~T();
+	else {
+		for (int i = index; i+1 < current->last; ++i)
+			*current->value(i) = std::move(*current->value(i+1));
+		current->value(--current->last)->~T();
+	}
+	if (current->first == current->last){
+		LB* emptied = current;
 		current = current->next;
-		ref_queue->dequeue();
+		ref_queue->unlink(emptied, prev);
+		index = current ? current->first : 0;
 	}
-	else{
-		prev->next = current->next;
-		if (current == ref_queue->rear) ref_queue->rear = prev;
-		delete current;
-		current = prev->next;
-		ref_queue->used--;
-		ref_queue->mod_count++;
+	else if (index == current->last){
+		prev = current;
+		current = current->next;
+		index = current ? current->first : 0;
 	}
+	else if (index < current->first)
+		index = current->first;
+	ref_queue->used--;
+	ref_queue->mod_count++;
 	expected_mod_count = ref_queue->mod_count;
 	return to_return;
 }
@@ -385,7 +449,12 @@ T LinkedQueue<T>::Iterator::erase() {
 template<class T>
 std::string LinkedQueue<T>::Iterator::str() const {
 	std::ostringstream answer;
-	answer << ref_queue->str() << "(current=" << current->value << ",previous=" << prev->value << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
+	answer << ref_queue->str() << "(current=";
+	if (current)
+		answer << *current->value(index) << "@" << index;
+	else
+		answer << "end";
+	answer << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
 	return answer.str();
 }
 
@@ -396,8 +465,12 @@ auto LinkedQueue<T>::Iterator::operator ++ () -> LinkedQueue<T>::Iterator& {
 	    throw ConcurrentModificationError("LinkedQueue::Iterator::operator ++");
 	if (!current)
 		can_erase = false;
-	else if (can_erase)
-		current = (prev = current)->next;
+	else if (can_erase){
+		if (++index == current->last){
+			current = (prev = current)->next;
+			index = current ? current->first : 0;
+		}
+	}
 	else
 		can_erase = true;
 	return *this;
@@ -409,12 +482,7 @@ auto LinkedQueue<T>::Iterator::operator ++ (int) -> LinkedQueue<T>::Iterator {
 	if (expected_mod_count != ref_queue->mod_count)
 		throw ConcurrentModificationError("LinkedQueue::Iterator::operator ++");
 	Iterator to_return(*this);
-	if (!current)
-		can_erase = false;
-	else if (can_erase)
-		current = (prev = current)->next;
-	else
-		can_erase = true;
+	++(*this);
 	return to_return;
 }
 
@@ -428,7 +496,7 @@ bool LinkedQueue<T>::Iterator::operator == (const LinkedQueue<T>::Iterator& rhs)
 		throw ConcurrentModificationError("LinkedQueue::Iterator::operator ==");
 	if (ref_queue != rhsASI->ref_queue)
 		throw ComparingDifferentIteratorsError("LinkedQueue::Iterator::operator ==");
-	return current == rhsASI->current;
+	return current == rhsASI->current && index == rhsASI->index;
 }
 
 template<class T>
@@ -440,7 +508,7 @@ bool LinkedQueue<T>::Iterator::operator != (const LinkedQueue<T>::Iterator& rhs)
 		throw ConcurrentModificationError("LinkedQueue::Iterator::operator !=");
 	if (ref_queue != rhsASI->ref_queue)
 		throw ComparingDifferentIteratorsError("LinkedQueue::Iterator::operator !=");
-	return current != rhsASI->current;
+	return current != rhsASI->current || index != rhsASI->index;
 }
 
 
@@ -450,12 +518,12 @@ T& LinkedQueue<T>::Iterator::operator *() const {
 		throw ConcurrentModificationError("LinkedQueue::Iterator::operator *");
 	if (!can_erase || !current) {
 		std::ostringstream where;
-		where << current
-			  << " when front = " << ref_queue->front->value << " and "
-			  << " and rear = " << ref_queue->rear->value;
+		where << current << "@" << index
+			  << " when front = " << ref_queue->front
+			  << " and rear = " << ref_queue->rear;
 		throw IteratorPositionIllegal("LinkedQueue::Iterator::operator * Iterator illegal: "+where.str());
 	}
-	return current->value;
+	return *current->value(index);
 }
 
 
@@ -465,12 +533,12 @@ T* LinkedQueue<T>::Iterator::operator ->() const {
 		throw ConcurrentModificationError("LinkedQueue::Iterator::operator ->");
 	if (!can_erase || !current) {
 		std::ostringstream where;
-		where << current
-			  << " when front = " << ref_queue->front->value << " and "
-			  << " and rear = " << ref_queue->rear->value;
+		where << current << "@" << index
+			  << " when front = " << ref_queue->front
+			  << " and rear = " << ref_queue->rear;
 		throw IteratorPositionIllegal("LinkedQueue::Iterator::operator -> Iterator illegal: "+where.str());
 	}
-	return &current->value;
+	return current->value(index);
 }
 
 
@@ -5,10 +5,28 @@
 #include <iostream>
 #include <sstream>
 #include <initializer_list>
+#include <vector>               //For marking/sorting values in set algebra
+#include <algorithm>            //For std::sort/std::equal_range/std::find
+#include <type_traits>          //For std::true_type/std::false_type
+#include <utility>              //For std::declval
 #include "ics_exceptions.hpp"
 
 
 namespace ics {
+
+
+//LessComparable<T>::value is true iff a < b compiles for values of T: then
+//  LinkedSet's set algebra sorts one side and binary searches it (O((N+M) log M))
+//  instead of scanning it for each value (O(N*M)); T needs only == otherwise.
+template<class T> class LessComparable {
+  private:
+    template<class U> static auto test (int) -> decltype(std::declval<const U&>() < std::declval<const U&>(), std::true_type());
+    template<class U> static std::false_type test (...);
+  public:
+    static const bool value = decltype(test<T>(0))::value;
+};
+
+
 template<class T> class LinkedSet {
   public:
     //Destructor/Constructors
@@ -54,6 +72,9 @@ template<class T> class LinkedSet {
 
     //Operators
     LinkedSet<T>& operator = (const LinkedSet<T>& rhs);
+    LinkedSet<T>  operator | (const LinkedSet<T>& rhs) const;   //union (this's values first)
+    LinkedSet<T>  operator & (const LinkedSet<T>& rhs) const;   //intersection (in this's order)
+    LinkedSet<T>  operator - (const LinkedSet<T>& rhs) const;   //difference (in this's order)
     bool operator == (const LinkedSet<T>& rhs) const;
     bool operator != (const LinkedSet<T>& rhs) const;
     bool operator <= (const LinkedSet<T>& rhs) const;
@@ -125,6 +146,17 @@ template<class T> class LinkedSet {
     //Helper methods
     int  erase_at   (LN* p);
     void delete_list(LN*& front);  //Deallocate all LNs (but trailer), and set front's argument to trailer;
+    void append     (const T& element);                            //Insert element known not to be in this set
+    int  erase_marked(const std::vector<bool>& marked, bool which); //Erase the k-th value iff marked[k] == which; return #
+    bool subset_of  (const LinkedSet<T>& rhs) const;
+
+    //Set marked[k] iff the k-th value (in list order) is in i: sort-and-search or scan (see LessComparable)
+    template<class Iterable>
+    void mark_in    (const Iterable& i, std::vector<bool>& marked) const;
+    template<class Iterable>
+    void mark_in    (const Iterable& i, std::vector<bool>& marked, std::true_type) const;
+    template<class Iterable>
+    void mark_in    (const Iterable& i, std::vector<bool>& marked, std::false_type) const;
 };
 
 
@@ -269,25 +301,19 @@ int LinkedSet<T>::insert_all(const Iterable& i) {
 template<class T>
 template<class Iterable>
 int LinkedSet<T>::erase_all(const Iterable& i) {
-	int count = 0;
-	for (auto &element: i)
-		count += erase(element);
-	return count;
+	std::vector<bool> in_i;
+	mark_in(i, in_i);
+	return erase_marked(in_i, true);
 }
 
 
 template<class T>
 template<class Iterable>
 int LinkedSet<T>::retain_all(const Iterable& i) {
-	int count = 0;
-	LinkedSet<T> to_return;
-	for (auto &element : i)
-		if (contains(element))
-			to_return.insert(element);
-	this->LinkedSet<T>::~LinkedSet();
-	new(this) LinkedSet<T>(to_return);
+	std::vector<bool> in_i;
+	mark_in(i, in_i);
+	erase_marked(in_i, false);
 	return size();
-
 }
 
 
@@ -322,13 +348,52 @@ LinkedSet<T>& LinkedSet<T>::operator = (const LinkedSet<T>& rhs) {
 }
 
 
+template<class T>
+LinkedSet<T> LinkedSet<T>::operator | (const LinkedSet<T>& rhs) const {
+	LinkedSet<T> answer(*this);
+	std::vector<bool> in_this;
+	rhs.mark_in(*this, in_this);
+	int k = 0;
+	for (LN* p = rhs.front; p != rhs.trailer; p = p->next, ++k)
+		if (!in_this[k])
+			answer.append(p->value);
+	return answer;
+}
+
+
+template<class T>
+LinkedSet<T> LinkedSet<T>::operator & (const LinkedSet<T>& rhs) const {
+	LinkedSet<T> answer;
+	std::vector<bool> in_rhs;
+	mark_in(rhs, in_rhs);
+	int k = 0;
+	for (LN* p = front; p != trailer; p = p->next, ++k)
+		if (in_rhs[k])
+			answer.append(p->value);
+	return answer;
+}
+
+
+template<class T>
+LinkedSet<T> LinkedSet<T>::operator - (const LinkedSet<T>& rhs) const {
+	LinkedSet<T> answer;
+	std::vector<bool> in_rhs;
+	mark_in(rhs, in_rhs);
+	int k = 0;
+	for (LN* p = front; p != trailer; p = p->next, ++k)
+		if (!in_rhs[k])
+			answer.append(p->value);
+	return answer;
+}
+
+
 template<class T>
 bool LinkedSet<T>::operator == (const LinkedSet<T>& rhs) const {
 	if (this == &rhs)
 		return true;
 	if (used != rhs.size())
 		return false;
-	return contains_all(rhs);
+	return subset_of(rhs);
 }
 
 
@@ -344,11 +409,7 @@ bool LinkedSet<T>::operator <= (const LinkedSet<T>& rhs) const {
 		return true;
 	if (used > rhs.size())
 		return false;
-	for (const auto &i : rhs)
-		if (!rhs.contains(i))
-		  return false;
-
-	return true;
+	return subset_of(rhs);
 }
 
 
@@ -358,11 +419,7 @@ bool LinkedSet<T>::operator < (const LinkedSet<T>& rhs) const {
 	    return false;
 	if (used >= rhs.size())
 	    return false;
-	for (const auto  &i: rhs)
-	    if (!rhs.contains(i))
-	      return false;
-
-	return true;
+	return subset_of(rhs);
 }
 
 
@@ -442,6 +499,79 @@ void LinkedSet<T>::delete_list(LN*& front) {
 }
 
 
+template<class T>
+void LinkedSet<T>::append(const T& element) {
+	trailer->value = element;
+	trailer->next = new LN();
+	trailer = trailer->next;
+	mod_count++;
+	used++;
+}
+
+
+template<class T>
+int LinkedSet<T>::erase_marked(const std::vector<bool>& marked, bool which) {
+	int count = 0, k = 0;
+	for (LN* p = front; p != trailer; ++k)
+		if (marked[k] == which)
+			count += erase_at(p);  //p now stores the next value
+		else
+			p = p->next;
+	return count;
+}
+
+
+template<class T>
+bool LinkedSet<T>::subset_of(const LinkedSet<T>& rhs) const {
+	std::vector<bool> in_rhs;
+	mark_in(rhs, in_rhs);
+	for (bool in : in_rhs)
+		if (!in)
+			return false;
+	return true;
+}
+
+
+template<class T>
+template<class Iterable>
+void LinkedSet<T>::mark_in(const Iterable& i, std::vector<bool>& marked) const {
+	marked.assign(used, false);
+	mark_in(i, marked, std::integral_constant<bool,LessComparable<T>::value>());
+}
+
+
+//Copy i's values into a sorted array once, then binary search it for each value;
+//  membership is still decided by == (as everywhere else in LinkedSet), among the
+//  values < finds equivalent, so a < that is coarser than == gives the same answer
+template<class T>
+template<class Iterable>
+void LinkedSet<T>::mark_in(const Iterable& i, std::vector<bool>& marked, std::true_type) const {
+	std::vector<T> sorted;
+	for (const T& element : i)
+		sorted.push_back(element);
+	std::sort(sorted.begin(), sorted.end());
+	int k = 0;
+	for (LN* p = front; p != trailer; p = p->next, ++k) {
+		auto equivalent = std::equal_range(sorted.begin(), sorted.end(), p->value);
+		marked[k] = std::find(equivalent.first, equivalent.second, p->value) != equivalent.second;
+	}
+}
+
+
+template<class T>
+template<class Iterable>
+void LinkedSet<T>::mark_in(const Iterable& i, std::vector<bool>& marked, std::false_type) const {
+	for (const T& element : i) {
+		int k = 0;
+		for (LN* p = front; p != trailer; p = p->next, ++k)
+			if (p->value == element) {
+				marked[k] = true;
+				break;
+			}
+	}
+}
+
+
 
 
 
@@ -0,0 +1,582 @@
+#ifndef MAPPED_HASH_MAP_HPP_
+#define MAPPED_HASH_MAP_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <vector>
+#include <algorithm>            //For std::max/std::min
+#include <cmath>                //For std::ceil
+#include <cstdint>              //For std::uint32_t/std::uint64_t/std::uintptr_t
+#include <cstring>              //For std::memcmp/std::memset
+#include <type_traits>          //For std::is_trivially_copyable/std::is_void
+#include <fcntl.h>              //For open (POSIX)
+#include <sys/mman.h>           //For mmap/munmap (POSIX)
+#include <sys/stat.h>           //For fstat (POSIX)
+#include <unistd.h>             //For close (POSIX)
+#include "ics_exceptions.hpp"
+#include "functor.hpp"
+#include "pair.hpp"
+
+
+namespace ics {
+
+
+//A std::string key/value stored in a MappedHashMap image: it refers to (does
+//  not copy) the characters in the image's string pool, which are not
+//  null-terminated; str() copies them into a std::string
+class MappedString {
+  public:
+    MappedString (const char* data = "", long size = 0) : chars(data), length(size) {}
+
+    const char* data () const {return chars;}
+    long        size () const {return length;}
+    std::string str  () const {return std::string(chars, length);}
+
+    bool operator == (const MappedString& rhs) const {return length == rhs.length && std::memcmp(chars, rhs.chars, length) == 0;}
+    bool operator != (const MappedString& rhs) const {return !(*this == rhs);}
+    bool operator == (const std::string&  rhs) const {return *this == MappedString(rhs.data(), rhs.size());}
+    bool operator != (const std::string&  rhs) const {return !(*this == rhs);}
+
+    friend std::ostream& operator << (std::ostream& outs, const MappedString& s) {
+      outs.write(s.chars, s.length);
+      return outs;
+    }
+
+  private:
+    const char* chars;
+    long        length;
+};
+
+
+//How a MappedHashMap image stores a key/value of type V: a trivially copyable
+//  V is stored as is (and viewed in place, by const V&); std::string is
+//  specialized below
+template<class V> class MappedField {
+  public:
+    static_assert(std::is_trivially_copyable<V>::value, "MappedHashMap: keys/values must be trivially copyable or std::string");
+
+    typedef V        Stored;
+    typedef const V& View;
+    typedef V        Value;   //View without references: used in Iterator's Entry
+
+    static Stored store  (const V& v, std::string& /*pool*/)                  {return v;}
+    static View   view   (const Stored& s, const char* /*pool*/)              {return s;}
+    static bool   equals (const Stored& s, const char* /*pool*/, const V& v) {return s == v;}
+};
+
+
+//A std::string is stored as the position/length of its characters in the string pool
+template<> class MappedField<std::string> {
+  public:
+    struct Stored {
+      std::uint64_t position;
+      std::uint64_t length;
+    };
+    typedef MappedString View;
+    typedef MappedString Value;
+
+    static Stored store (const std::string& v, std::string& pool) {
+      Stored s;
+      s.position = pool.size();
+      s.length   = v.size();
+      pool += v;
+      return s;
+    }
+    static View view (const Stored& s, const char* pool) {
+      return MappedString(pool + s.position, s.length);
+    }
+    static bool equals (const Stored& s, const char* pool, const std::string& v) {
+      return s.length == v.size() && std::memcmp(pool + s.position, v.data(), s.length) == 0;
+    }
+};
+
+
+//A read-only hash map queried in place in an image (a file written by write),
+//  which it maps into memory (or a caller-supplied copy of the image): nothing
+//  is deserialized, so constructing one costs a few system calls, and only the
+//  pages a query touches are read from disk.
+//KEY/T must be trivially copyable (stored in the image as is: the reading
+//  program must use the same KEY/T, compiler and byte order as the writing
+//  one) or std::string (stored in the image's string pool, and viewed as
+//  MappedString).
+//The hash function is supplied as in HashMap (thash/chash/HASH); write and the
+//  reader must use the same one, and its values must not vary from one run to
+//  the next (e.g., by hashing addresses).
+//The image is
+//  Header | bin starts: bins+1 uint32 | slots: (hash,key,value), grouped by bin | string pool
+//  so each lookup hashes the key and scans the slots of one bin, comparing
+//  stored hashes before keys.
+template<class KEY,class T, int (*thash)(const KEY& a) = nullptr, class HASH = void> class MappedHashMap {
+  public:
+    typedef typename MappedField<KEY>::View                                       KeyView;
+    typedef typename MappedField<T>::View                                         ValueView;
+    typedef ics::pair<typename MappedField<KEY>::Value, typename MappedField<T>::Value> Entry;
+
+    //Destructor/Constructors
+    ~MappedHashMap();
+
+    explicit MappedHashMap (const std::string& file_name, int (*chash)(const KEY& a) = nullptr);
+    MappedHashMap          (const void* image, long bytes, int (*chash)(const KEY& a) = nullptr); //Views (does not copy) image: it must outlive this map
+    MappedHashMap          (const MappedHashMap<KEY,T,thash,HASH>& to_copy) = delete;
+    MappedHashMap<KEY,T,thash,HASH>& operator = (const MappedHashMap<KEY,T,thash,HASH>& rhs) = delete;
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result,
+    //  whose values have .first/.second (e.g., a HashMap)
+    //Write an image of i's key->value pairs (with used/bins <= load_threshold) into file_name; return its size in bytes
+    template <class Iterable>
+    static long write (const Iterable& i, const std::string& file_name, double load_threshold = 1.0, int (*chash)(const KEY& a) = nullptr);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    bool has_key    (const KEY& key) const;
+    long bytes      () const;  //Size of the image
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Operators
+    ValueView operator [] (const KEY& key) const;  //Raises KeyError if key is not in the map
+
+    template<class KEY2,class T2, int (*hash2)(const KEY2& a), class HASH2>
+    friend std::ostream& operator << (std::ostream& outs, const MappedHashMap<KEY2,T2,hash2,HASH2>& m);
+
+
+
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of MappedHashMap<T>
+        ~Iterator();
+        KeyView     key   () const;
+        ValueView   value () const;
+        std::string str   () const;
+        MappedHashMap<KEY,T,thash,HASH>::Iterator& operator ++ ();
+        MappedHashMap<KEY,T,thash,HASH>::Iterator  operator ++ (int);
+        bool operator == (const MappedHashMap<KEY,T,thash,HASH>::Iterator& rhs) const;
+        bool operator != (const MappedHashMap<KEY,T,thash,HASH>::Iterator& rhs) const;
+        Entry operator * () const;   //A copy of the key/value (strings are still MappedStrings)
+        friend std::ostream& operator << (std::ostream& outs, const MappedHashMap<KEY,T,thash,HASH>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+        friend Iterator MappedHashMap<KEY,T,thash,HASH>::begin () const;
+        friend Iterator MappedHashMap<KEY,T,thash,HASH>::end   () const;
+
+      private:
+        //The map cannot change, so there is no mod_count to check
+        std::uint64_t                          current;  //Slot index: size() at the end
+        const MappedHashMap<KEY,T,thash,HASH>* ref_map;
+
+        //Called in friends begin/end
+        Iterator(const MappedHashMap<KEY,T,thash,HASH>* iterate_over, std::uint64_t initial);
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+    struct Header {
+      char          magic[8];    //"ICSMHM1"
+      std::uint32_t byte_order;  //0x01020304, in the writer's byte order
+      std::uint32_t slot_bytes;  //sizeof(Slot): a different KEY/T (or layout) does not match
+      std::uint64_t used;
+      std::uint64_t bins;
+      std::uint64_t bins_at;     //Byte offsets of the sections in the image
+      std::uint64_t slots_at;
+      std::uint64_t pool_at;
+      std::uint64_t total_bytes;
+    };
+
+    struct Slot {
+      std::uint32_t                      hash;
+      typename MappedField<KEY>::Stored key;
+      typename MappedField<T>::Stored   value;
+    };
+
+    static const int section_alignment = 64;
+
+    static_assert(std::is_void<HASH>::value || thash == nullptr, "MappedHashMap: specify thash or HASH, not both");
+    int (*hash)(const KEY& k);             //Hashing function used (from template or constructor)
+    void*                mapping = nullptr; //The mmapped file (nullptr when viewing a caller's image)
+    long                 mapped_bytes = 0;
+    const Header*        header;
+    const std::uint32_t* bin_starts;        //bin b's slots are [bin_starts[b],bin_starts[b+1])
+    const Slot*          slots;
+    const char*          pool;
+
+    //Helper methods
+    static int (*resolve_hash (int (*chash)(const KEY& a), const std::string& where))(const KEY& a);
+    static std::uint32_t hash_value (int (*h)(const KEY& a), const KEY& key);
+    static std::uint64_t align      (std::uint64_t offset);
+    void        attach (const void* image, long bytes);  //Check image's header and set header/bin_starts/slots/pool
+    const Slot* find   (const KEY& key) const;           //Returns key's slot or nullptr
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//MappedHashMap class and related definitions
+
+//Destructor/Constructors
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+MappedHashMap<KEY,T,thash,HASH>::~MappedHashMap() {
+  if (mapping != nullptr)
+    munmap(mapping, mapped_bytes);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+MappedHashMap<KEY,T,thash,HASH>::MappedHashMap(const std::string& file_name, int (*chash)(const KEY& k))
+: hash(resolve_hash(chash, "MappedHashMap::file constructor")) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw IcsError("MappedHashMap::file constructor: cannot open " + file_name);
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    close(fd);
+    throw IcsError("MappedHashMap::file constructor: cannot size (or empty) " + file_name);
+  }
+
+  mapped_bytes = info.st_size;
+  mapping      = mmap(nullptr, mapped_bytes, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);                   //The mapping remains valid after closing
+  if (mapping == MAP_FAILED) {
+    mapping = nullptr;
+    throw IcsError("MappedHashMap::file constructor: cannot map " + file_name);
+  }
+
+  try {
+    attach(mapping, mapped_bytes);
+  } catch (...) {
+    munmap(mapping, mapped_bytes);
+    throw;
+  }
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+MappedHashMap<KEY,T,thash,HASH>::MappedHashMap(const void* image, long bytes, int (*chash)(const KEY& k))
+: hash(resolve_hash(chash, "MappedHashMap::image constructor")) {
+  attach(image, bytes);
+}
+
+
+//Slots are grouped by bin with a counting sort; padding in slots is zeroed, so
+//  the same map always produces the same image
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+template <class Iterable>
+long MappedHashMap<KEY,T,thash,HASH>::write(const Iterable& i, const std::string& file_name, double load_threshold, int (*chash)(const KEY& k)) {
+  int (*h)(const KEY& k) = resolve_hash(chash, "MappedHashMap::write");
+  if (load_threshold <= 0)
+    throw IcsError("MappedHashMap::write: load_threshold(" + std::to_string(load_threshold) + ") must be > 0");
+
+  std::string       pool;
+  std::vector<Slot> unsorted;
+  for (const auto& kv : i) {
+    Slot s;
+    std::memset(&s, 0, sizeof(Slot));
+    s.hash  = hash_value(h, kv.first);
+    s.key   = MappedField<KEY>::store(kv.first,  pool);
+    s.value = MappedField<T>  ::store(kv.second, pool);
+    unsorted.push_back(s);
+  }
+  if (unsorted.size() >= UINT32_MAX)
+    throw IcsError("MappedHashMap::write: too many values(" + std::to_string(unsorted.size()) + ")");
+
+  Header header;
+  std::memset(&header, 0, sizeof(Header));
+  std::memcpy(header.magic, "ICSMHM1", 8);
+  header.byte_order  = 0x01020304;
+  header.slot_bytes  = sizeof(Slot);
+  header.used        = unsorted.size();
+  header.bins        = std::max(std::uint64_t(1), std::uint64_t(std::ceil(unsorted.size() / load_threshold)));
+  header.bins        = std::min(header.bins, std::uint64_t(UINT32_MAX));
+  header.bins_at     = align(sizeof(Header));
+  header.slots_at    = align(header.bins_at + (header.bins+1)*sizeof(std::uint32_t));
+  header.pool_at     = header.slots_at + header.used*sizeof(Slot);
+  header.total_bytes = header.pool_at + pool.size();
+
+  std::vector<std::uint32_t> starts(header.bins+1, 0);
+  for (const Slot& s : unsorted)
+    ++starts[s.hash % header.bins + 1];
+  for (std::uint64_t b=0; b<header.bins; ++b)
+    starts[b+1] += starts[b];
+
+  std::vector<Slot>          slots(unsorted.size());
+  std::vector<std::uint32_t> next(starts.begin(), starts.end()-1);
+  for (const Slot& s : unsorted)
+    slots[next[s.hash % header.bins]++] = s;
+  std::vector<Slot>().swap(unsorted);
+
+  std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+  if (!out)
+    throw IcsError("MappedHashMap::write: cannot open " + file_name);
+  const char padding[section_alignment] = {};
+  out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+  out.write(padding, header.bins_at - sizeof(Header));
+  out.write(reinterpret_cast<const char*>(starts.data()), starts.size()*sizeof(std::uint32_t));
+  out.write(padding, header.slots_at - (header.bins_at + starts.size()*sizeof(std::uint32_t)));
+  out.write(reinterpret_cast<const char*>(slots.data()), slots.size()*sizeof(Slot));
+  out.write(pool.data(), pool.size());
+  out.close();
+  if (!out)
+    throw IcsError("MappedHashMap::write: cannot write " + file_name);
+
+  return header.total_bytes;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool MappedHashMap<KEY,T,thash,HASH>::empty() const {
+  return header->used == 0;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+int MappedHashMap<KEY,T,thash,HASH>::size() const {
+  return header->used;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool MappedHashMap<KEY,T,thash,HASH>::has_key (const KEY& key) const {
+  return find(key) != nullptr;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+long MappedHashMap<KEY,T,thash,HASH>::bytes() const {
+  return header->total_bytes;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+std::string MappedHashMap<KEY,T,thash,HASH>::str() const {
+  std::ostringstream answer;
+  answer << "MappedHashMap[used=" << header->used << ",bins=" << header->bins << ",bytes=" << header->total_bytes
+         << ",mapped=" << (mapping != nullptr) << "]";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto MappedHashMap<KEY,T,thash,HASH>::operator [] (const KEY& key) const -> ValueView {
+  const Slot* s = find(key);
+  if (s == nullptr) {
+    std::ostringstream answer;
+    answer << "MappedHashMap::operator []: key(" << key << ") not in Map";
+    throw KeyError(answer.str());
+  }
+  return MappedField<T>::view(s->value, pool);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+std::ostream& operator << (std::ostream& outs, const MappedHashMap<KEY,T,thash,HASH>& m) {
+  outs << "map[";
+
+  int printed = 0;
+  for (auto i = m.begin(); i != m.end(); ++i)
+    outs << (printed++ == 0? "" : ",") << i.key() << "->" << i.value();
+
+  outs << "]";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto MappedHashMap<KEY,T,thash,HASH>::begin () const -> MappedHashMap<KEY,T,thash,HASH>::Iterator {
+  return Iterator(this, 0);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto MappedHashMap<KEY,T,thash,HASH>::end () const -> MappedHashMap<KEY,T,thash,HASH>::Iterator {
+  return Iterator(this, header->used);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto MappedHashMap<KEY,T,thash,HASH>::resolve_hash(int (*chash)(const KEY& a), const std::string& where) -> int (*)(const KEY& a) {
+  if (thash == nullptr && std::is_void<HASH>::value && chash == nullptr)
+    throw TemplateFunctionError(where + ": neither specified");
+  if ((thash != nullptr || !std::is_void<HASH>::value) && chash != nullptr && thash != chash)
+    throw TemplateFunctionError(where + ": both specified and different");
+  return thash != nullptr ? thash : chash;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+std::uint32_t MappedHashMap<KEY,T,thash,HASH>::hash_value (int (*h)(const KEY& a), const KEY& key) {
+  return static_cast<std::uint32_t>(Functor<HASH>::call(thash != nullptr ? thash : h, key));
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+std::uint64_t MappedHashMap<KEY,T,thash,HASH>::align (std::uint64_t offset) {
+  return (offset + section_alignment-1) / section_alignment * section_alignment;
+}
+
+
+//Checks everything but the slots' contents (e.g., string positions), which are
+//  trusted to come from write
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+void MappedHashMap<KEY,T,thash,HASH>::attach(const void* image, long bytes) {
+  const char* base = static_cast<const char*>(image);
+  if (reinterpret_cast<std::uintptr_t>(base) % alignof(Slot) != 0 || reinterpret_cast<std::uintptr_t>(base) % alignof(Header) != 0)
+    throw IcsError("MappedHashMap::attach: image is not aligned");
+  if (bytes < long(sizeof(Header)))
+    throw IcsError("MappedHashMap::attach: image too small(" + std::to_string(bytes) + ")");
+
+  header = reinterpret_cast<const Header*>(base);
+  if (std::memcmp(header->magic, "ICSMHM1", 8) != 0)
+    throw IcsError("MappedHashMap::attach: not a MappedHashMap image");
+  if (header->byte_order != 0x01020304)
+    throw IcsError("MappedHashMap::attach: image written with a different byte order");
+  if (header->slot_bytes != sizeof(Slot))
+    throw IcsError("MappedHashMap::attach: image written for a different KEY/T (slot bytes " + std::to_string(header->slot_bytes) + " != " + std::to_string(sizeof(Slot)) + ")");
+  if (header->total_bytes > std::uint64_t(bytes) || header->bins == 0 || header->used >= UINT32_MAX
+      || header->bins_at < sizeof(Header) || header->bins_at % alignof(std::uint32_t) != 0
+      || header->bins_at + (header->bins+1)*sizeof(std::uint32_t) > header->slots_at || header->slots_at % alignof(Slot) != 0
+      || header->slots_at + header->used*sizeof(Slot) != header->pool_at || header->pool_at > header->total_bytes)
+    throw IcsError("MappedHashMap::attach: corrupt header");
+
+  bin_starts = reinterpret_cast<const std::uint32_t*>(base + header->bins_at);
+  slots      = reinterpret_cast<const Slot*>         (base + header->slots_at);
+  pool       = base + header->pool_at;
+  if (bin_starts[0] != 0 || bin_starts[header->bins] != header->used)
+    throw IcsError("MappedHashMap::attach: corrupt bins");
+  for (std::uint64_t b = 1; b < header->bins; ++b)   //So find never scans outside slots
+    if (bin_starts[b] < bin_starts[b-1] || bin_starts[b] > header->used)
+      throw IcsError("MappedHashMap::attach: corrupt bins (bin " + std::to_string(b) + " starts at " + std::to_string(bin_starts[b]) + ")");
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto MappedHashMap<KEY,T,thash,HASH>::find (const KEY& key) const -> const Slot* {
+  std::uint32_t h   = hash_value(hash, key);
+  std::uint64_t bin = h % header->bins;
+  for (const Slot* s = slots + bin_starts[bin], *stop = slots + bin_starts[bin+1]; s != stop; ++s)
+    if (s->hash == h && MappedField<KEY>::equals(s->key, pool, key))
+      return s;
+  return nullptr;
+}
+
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+MappedHashMap<KEY,T,thash,HASH>::Iterator::Iterator(const MappedHashMap<KEY,T,thash,HASH>* iterate_over, std::uint64_t initial)
+: current(initial), ref_map(iterate_over)
+{}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+MappedHashMap<KEY,T,thash,HASH>::Iterator::~Iterator()
+{}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto MappedHashMap<KEY,T,thash,HASH>::Iterator::key() const -> KeyView {
+  if (current >= ref_map->header->used)
+    throw IteratorPositionIllegal("MappedHashMap::Iterator::key Iterator illegal: exhausted");
+  return MappedField<KEY>::view(ref_map->slots[current].key, ref_map->pool);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto MappedHashMap<KEY,T,thash,HASH>::Iterator::value() const -> ValueView {
+  if (current >= ref_map->header->used)
+    throw IteratorPositionIllegal("MappedHashMap::Iterator::value Iterator illegal: exhausted");
+  return MappedField<T>::view(ref_map->slots[current].value, ref_map->pool);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+std::string MappedHashMap<KEY,T,thash,HASH>::Iterator::str() const {
+  std::ostringstream answer;
+  answer << ref_map->str() << "(current=" << current << ")";
+  return answer.str();
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto MappedHashMap<KEY,T,thash,HASH>::Iterator::operator ++ () -> MappedHashMap<KEY,T,thash,HASH>::Iterator& {
+  if (current < ref_map->header->used)
+    ++current;
+  return *this;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto MappedHashMap<KEY,T,thash,HASH>::Iterator::operator ++ (int) -> MappedHashMap<KEY,T,thash,HASH>::Iterator {
+  Iterator to_return(*this);
+  if (current < ref_map->header->used)
+    ++current;
+  return to_return;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool MappedHashMap<KEY,T,thash,HASH>::Iterator::operator == (const MappedHashMap<KEY,T,thash,HASH>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("MappedHashMap::Iterator::operator ==");
+  if (ref_map != rhsASI->ref_map)
+    throw ComparingDifferentIteratorsError("MappedHashMap::Iterator::operator ==");
+
+  return current == rhsASI->current;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+bool MappedHashMap<KEY,T,thash,HASH>::Iterator::operator != (const MappedHashMap<KEY,T,thash,HASH>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("MappedHashMap::Iterator::operator !=");
+  if (ref_map != rhsASI->ref_map)
+    throw ComparingDifferentIteratorsError("MappedHashMap::Iterator::operator !=");
+
+  return current != rhsASI->current;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class HASH>
+auto MappedHashMap<KEY,T,thash,HASH>::Iterator::operator *() const -> Entry {
+  return Entry(key(), value());
+}
+
+
+}
+
+#endif /* MAPPED_HASH_MAP_HPP_ */
@@ -0,0 +1,636 @@
+#ifndef PAIRING_PRIORITY_QUEUE_HPP_
+#define PAIRING_PRIORITY_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <utility>              //For std::swap function
+#include "ics_exceptions.hpp"
+#include "functor.hpp"
+#include "array_stack.hpp"      //See operator << and tree walks
+
+
+namespace ics {
+
+
+//A pairing heap: a tree whose root has the highest priority and whose subtrees
+//  are pairing heaps. enqueue and merge just link two roots (O(1)); dequeue
+//  links the root's subtrees in pairs, then the pairs right to left
+//  (O(log N) amortized).
+//Has the HeapPriorityQueue interface, plus merge; use it when queues are
+//  often combined.
+//Instantiate the templated class supplying tgt(a,b): true, iff a has higher priority than b.
+//If tgt is defaulted to nullptr in the template, then a constructor must supply cgt.
+//If both tgt and cgt are supplied, then they must be the same (by ==) function.
+//If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
+//Instead, GT can be a functor type whose GT()(a,b) is the priority order (then neither tgt nor cgt is supplied).
+template<class T, bool (*tgt)(const T& a, const T& b) = nullptr, class GT = void> class PairingPriorityQueue {
+  public:
+    //Destructor/Constructors
+    ~PairingPriorityQueue();
+
+    PairingPriorityQueue(bool (*cgt)(const T& a, const T& b) = nullptr);
+    PairingPriorityQueue(const PairingPriorityQueue<T,tgt,GT>& to_copy, bool (*cgt)(const T& a, const T& b) = nullptr);
+    explicit PairingPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b) = nullptr);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit PairingPriorityQueue (const Iterable& i, bool (*cgt)(const T& a, const T& b) = nullptr);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    T&   peek       () const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    int  enqueue (const T& element);
+    T    dequeue ();
+    void clear   ();
+    int  merge   (PairingPriorityQueue<T,tgt,GT>& other); //Move all of other's values here in O(1); return # moved
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+
+    //Operators
+    PairingPriorityQueue<T,tgt,GT>& operator = (const PairingPriorityQueue<T,tgt,GT>& rhs);
+    bool operator == (const PairingPriorityQueue<T,tgt,GT>& rhs) const;
+    bool operator != (const PairingPriorityQueue<T,tgt,GT>& rhs) const;
+
+    template<class T2, bool (*gt2)(const T2& a, const T2& b), class GT2>
+    friend std::ostream& operator << (std::ostream& outs, const PairingPriorityQueue<T2,gt2,GT2>& pq);
+
+
+
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of PairingPriorityQueue<T,tgt,GT>
+        ~Iterator();
+        T           erase();
+        std::string str  () const;
+        PairingPriorityQueue<T,tgt,GT>::Iterator& operator ++ ();
+        PairingPriorityQueue<T,tgt,GT>::Iterator  operator ++ (int);
+        bool operator == (const PairingPriorityQueue<T,tgt,GT>::Iterator& rhs) const;
+        bool operator != (const PairingPriorityQueue<T,tgt,GT>::Iterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const PairingPriorityQueue<T,tgt,GT>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+
+        friend Iterator PairingPriorityQueue<T,tgt,GT>::begin () const;
+        friend Iterator PairingPriorityQueue<T,tgt,GT>::end   () const;
+
+      private:
+        //If can_erase is false, the value has been removed from "it" (++ does nothing)
+        PairingPriorityQueue<T,tgt,GT>  it;                 //copy of PPQ (from begin), to use as iterator via dequeue
+        PairingPriorityQueue<T,tgt,GT>* ref_pq;
+        int                             expected_mod_count;
+        bool                            can_erase = true;
+
+        //Called in friends begin/end
+        //These constructors have different initializers (see it(...) in first one)
+        Iterator(PairingPriorityQueue<T,tgt,GT>* iterate_over, bool from_begin);    // Called by begin
+        Iterator(PairingPriorityQueue<T,tgt,GT>* iterate_over);                     // Called by end
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+    class PN {
+      public:
+        PN (const T& v) : value(v) {}
+
+        T   value;
+        PN* child   = nullptr;   //Highest-priority value of the first subtree
+        PN* sibling = nullptr;   //Next subtree of this PN's parent
+        PN* prev    = nullptr;   //Parent (if this PN is its first child) or previous sibling; nullptr for the root
+    };
+
+    static_assert(std::is_void<GT>::value || tgt == nullptr, "PairingPriorityQueue: specify tgt or GT, not both");
+    bool (*gt) (const T& a, const T& b); // The gt used by enqueue (from template or constructor)
+    PN* root      = nullptr;
+    int used      = 0;
+    int mod_count = 0;                   //For sensing concurrent modification
+
+
+    //Helper methods
+    bool is_gt          (const T& a, const T& b) const; //True iff a has higher priority than b: via the functor type, tgt or gt (see functor.hpp)
+    PN*  link           (PN* a, PN* b);                 //Make the lower of roots a and b the first child of the higher; return the higher
+    PN*  merge_pairs    (PN* first);                    //Link siblings first... in pairs left to right, then those right to left; return the root
+    void remove         (PN* node);                     //Remove node (keeping its subtrees); delete it
+    PN*  find           (const T& value) const;         //Return a PN storing value (or nullptr)
+    void delete_tree    (PN*& root);                    //Deallocate all PN in root's tree; root == nullptr
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//PairingPriorityQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+PairingPriorityQueue<T,tgt,GT>::~PairingPriorityQueue() {
+  delete_tree(root);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+PairingPriorityQueue<T,tgt,GT>::PairingPriorityQueue(bool (*cgt)(const T& a, const T& b))
+: gt(tgt != nullptr ? tgt : cgt) {
+  if (gt == nullptr && std::is_void<GT>::value)
+    throw TemplateFunctionError("PairingPriorityQueue::default constructor: neither specified");
+  if ((tgt != nullptr || !std::is_void<GT>::value) && cgt != nullptr && tgt != cgt)
+    throw TemplateFunctionError("PairingPriorityQueue::default constructor: both specified and different");
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+PairingPriorityQueue<T,tgt,GT>::PairingPriorityQueue(const PairingPriorityQueue<T,tgt,GT>& to_copy, bool (*cgt)(const T& a, const T& b))
+: gt(tgt != nullptr ? tgt : cgt) {
+  if (gt == nullptr)
+    gt = to_copy.gt;
+  if ((tgt != nullptr || !std::is_void<GT>::value) && cgt != nullptr && tgt != cgt)
+    throw TemplateFunctionError("PairingPriorityQueue::copy constructor: both specified and different");
+
+  ArrayStack<PN*> to_visit;
+  if (to_copy.root != nullptr)
+    to_visit.push(to_copy.root);
+  while (!to_visit.empty()) {
+    PN* next = to_visit.pop();
+    enqueue(next->value);
+    if (next->sibling != nullptr)
+      to_visit.push(next->sibling);
+    if (next->child != nullptr)
+      to_visit.push(next->child);
+  }
+  mod_count = 0;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+PairingPriorityQueue<T,tgt,GT>::PairingPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b))
+: gt(tgt != nullptr ? tgt : cgt) {
+  if (gt == nullptr && std::is_void<GT>::value)
+    throw TemplateFunctionError("PairingPriorityQueue::initializer_list constructor: neither specified");
+  if ((tgt != nullptr || !std::is_void<GT>::value) && cgt != nullptr && tgt != cgt)
+    throw TemplateFunctionError("PairingPriorityQueue::initializer_list constructor: both specified and different");
+
+  for (const T& pq_elem : il)
+    enqueue(pq_elem);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+template<class Iterable>
+PairingPriorityQueue<T,tgt,GT>::PairingPriorityQueue(const Iterable& i, bool (*cgt)(const T& a, const T& b))
+: gt(tgt != nullptr ? tgt : cgt) {
+  if (gt == nullptr && std::is_void<GT>::value)
+    throw TemplateFunctionError("PairingPriorityQueue::Iterable constructor: neither specified");
+  if ((tgt != nullptr || !std::is_void<GT>::value) && cgt != nullptr && tgt != cgt)
+    throw TemplateFunctionError("PairingPriorityQueue::Iterable constructor: both specified and different");
+
+  for (const T& pq_elem : i)
+    enqueue(pq_elem);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool PairingPriorityQueue<T,tgt,GT>::empty() const {
+  return used == 0;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+int PairingPriorityQueue<T,tgt,GT>::size() const {
+  return used;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T& PairingPriorityQueue<T,tgt,GT>::peek () const {
+  if (empty())
+    throw EmptyError("PairingPriorityQueue::peek");
+
+  return root->value;
+}
+
+
+//Values in preorder: each PN, then its subtrees (first child first)
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+std::string PairingPriorityQueue<T,tgt,GT>::str() const {
+  std::ostringstream answer;
+  answer << "PairingPriorityQueue[";
+
+  ArrayStack<PN*> to_visit;
+  if (root != nullptr)
+    to_visit.push(root);
+  for (int printed = 0; !to_visit.empty(); ++printed) {
+    PN* next = to_visit.pop();
+    answer << (printed == 0 ? "" : ",") << next->value;
+    if (next->sibling != nullptr)
+      to_visit.push(next->sibling);
+    if (next->child != nullptr)
+      to_visit.push(next->child);
+  }
+
+  answer << "](used=" << used << ",mod_count=" << mod_count << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+int PairingPriorityQueue<T,tgt,GT>::enqueue(const T& element) {
+  root = link(root, new PN(element));
+  ++used;
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T PairingPriorityQueue<T,tgt,GT>::dequeue() {
+  if (this->empty())
+    throw EmptyError("PairingPriorityQueue::dequeue");
+
+  T to_return = root->value;
+  remove(root);
+  ++mod_count;
+  return to_return;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void PairingPriorityQueue<T,tgt,GT>::clear() {
+  delete_tree(root);
+  used = 0;
+  ++mod_count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+int PairingPriorityQueue<T,tgt,GT>::merge(PairingPriorityQueue<T,tgt,GT>& other) {
+  if (this == &other || other.empty())
+    return 0;
+  if (gt != other.gt)
+    throw TemplateFunctionError("PairingPriorityQueue::merge: different gt functions");
+
+  int moved = other.used;
+  root = link(root, other.root);
+  used += moved;
+  other.root = nullptr;
+  other.used = 0;
+  ++mod_count;
+  ++other.mod_count;
+  return moved;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+template <class Iterable>
+int PairingPriorityQueue<T,tgt,GT>::enqueue_all (const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+     count += enqueue(v);
+
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+PairingPriorityQueue<T,tgt,GT>& PairingPriorityQueue<T,tgt,GT>::operator = (const PairingPriorityQueue<T,tgt,GT>& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  PairingPriorityQueue<T,tgt,GT> copy(rhs);
+  std::swap(gt, copy.gt);   // if tgt != nullptr, gts are already equal (or compiler error)
+  std::swap(root, copy.root);
+  std::swap(used, copy.used);
+  ++mod_count;
+  return *this;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool PairingPriorityQueue<T,tgt,GT>::operator == (const PairingPriorityQueue<T,tgt,GT>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (gt != rhs.gt) //For PriorityQueues to be equal, they need the same gt function, and values
+    return false;
+  if (used != rhs.size())
+    return false;
+  PairingPriorityQueue<T,tgt,GT>::Iterator l = this->begin(), r = rhs.begin();
+  for (int i=0; i<used; ++i, ++l, ++r)
+    if (*l != *r)
+      return false;
+
+  return true;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool PairingPriorityQueue<T,tgt,GT>::operator != (const PairingPriorityQueue<T,tgt,GT>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+std::ostream& operator << (std::ostream& outs, const PairingPriorityQueue<T,tgt,GT>& p) {
+  outs << "priority_queue[";
+
+  if (!p.empty()) {
+    ArrayStack<T> temp(p);
+    outs << temp.pop();
+    for (int i = 1; i < p.used; ++i)
+      outs << "," << temp.pop();
+  }
+
+  outs << "]:highest";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto PairingPriorityQueue<T,tgt,GT>::begin () const -> PairingPriorityQueue<T,tgt,GT>::Iterator {
+  return Iterator(const_cast<PairingPriorityQueue<T,tgt,GT>*>(this),true);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto PairingPriorityQueue<T,tgt,GT>::end () const -> PairingPriorityQueue<T,tgt,GT>::Iterator {
+  return Iterator(const_cast<PairingPriorityQueue<T,tgt,GT>*>(this));  //Create empty pq (size == 0)
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool PairingPriorityQueue<T,tgt,GT>::is_gt (const T& a, const T& b) const {
+  return Functor<GT>::call(tgt != nullptr ? tgt : gt, a, b);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto PairingPriorityQueue<T,tgt,GT>::link (PN* a, PN* b) -> PN* {
+  if (a == nullptr)
+    return b;
+  if (b == nullptr)
+    return a;
+  if (is_gt(b->value,a->value))
+    std::swap(a,b);
+
+  b->prev    = a;
+  b->sibling = a->child;
+  if (a->child != nullptr)
+    a->child->prev = b;
+  a->child = b;
+  return a;
+}
+
+
+//Two passes, each written iteratively (sibling lists can be N long): pair up
+//  left to right, pushing each pair onto a list (linked through sibling);
+//  then link that list, which is right to left
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto PairingPriorityQueue<T,tgt,GT>::merge_pairs (PN* first) -> PN* {
+  PN* pairs = nullptr;
+  while (first != nullptr) {
+    PN* a = first;
+    PN* b = a->sibling;
+    first = (b == nullptr ? nullptr : b->sibling);
+    a->sibling = a->prev = nullptr;
+    if (b != nullptr)
+      b->sibling = b->prev = nullptr;
+    PN* pair = link(a,b);
+    pair->sibling = pairs;
+    pairs = pair;
+  }
+
+  PN* answer = nullptr;
+  while (pairs != nullptr) {
+    PN* next = pairs->sibling;
+    pairs->sibling = nullptr;
+    answer = link(answer, pairs);
+    pairs = next;
+  }
+  return answer;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void PairingPriorityQueue<T,tgt,GT>::remove (PN* node) {
+  if (node == root)
+    root = merge_pairs(node->child);
+  else {
+    if (node->prev->child == node)
+      node->prev->child = node->sibling;
+    else
+      node->prev->sibling = node->sibling;
+    if (node->sibling != nullptr)
+      node->sibling->prev = node->prev;
+    root = link(root, merge_pairs(node->child));
+  }
+  delete node;
+  --used;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto PairingPriorityQueue<T,tgt,GT>::find (const T& value) const -> PN* {
+  ArrayStack<PN*> to_visit;
+  if (root != nullptr)
+    to_visit.push(root);
+  while (!to_visit.empty()) {
+    PN* next = to_visit.pop();
+    if (next->value == value)
+      return next;
+    if (next->sibling != nullptr)
+      to_visit.push(next->sibling);
+    if (next->child != nullptr)
+      to_visit.push(next->child);
+  }
+  return nullptr;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+void PairingPriorityQueue<T,tgt,GT>::delete_tree (PN*& root) {
+  ArrayStack<PN*> to_delete;
+  if (root != nullptr)
+    to_delete.push(root);
+  while (!to_delete.empty()) {
+    PN* next = to_delete.pop();
+    if (next->sibling != nullptr)
+      to_delete.push(next->sibling);
+    if (next->child != nullptr)
+      to_delete.push(next->child);
+    delete next;
+  }
+  root = nullptr;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+PairingPriorityQueue<T,tgt,GT>::Iterator::Iterator(PairingPriorityQueue<T,tgt,GT>* iterate_over, bool from_begin)
+: it(*iterate_over,iterate_over->gt), ref_pq(iterate_over), expected_mod_count(iterate_over->mod_count) {
+  // Full priority queue; use copy constructor
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+PairingPriorityQueue<T,tgt,GT>::Iterator::Iterator(PairingPriorityQueue<T,tgt,GT>* iterate_over)
+: it(iterate_over->gt), ref_pq(iterate_over), expected_mod_count(iterate_over->mod_count) {
+  // Empty priority queue; use default constructor (from declaration of "it")
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+PairingPriorityQueue<T,tgt,GT>::Iterator::~Iterator()
+{}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T PairingPriorityQueue<T,tgt,GT>::Iterator::erase() {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("PairingPriorityQueue::Iterator::erase");
+  if (!can_erase)
+    throw CannotEraseError("PairingPriorityQueue::Iterator::erase Iterator cursor already erased");
+  if (it.empty())
+    throw CannotEraseError("PairingPriorityQueue::Iterator::erase Iterator cursor beyond data structure");
+
+  can_erase = false;
+  T to_return = it.dequeue();
+
+  //Find value from it (heap iterating over) in main heap; remove it
+  PN* found = ref_pq->find(to_return);
+  if (found != nullptr)
+    ref_pq->remove(found);
+
+  expected_mod_count = ref_pq->mod_count;
+  return to_return;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+std::string PairingPriorityQueue<T,tgt,GT>::Iterator::str() const {
+  std::ostringstream answer;
+  answer << it.str() << "/expected_mod_count=" << expected_mod_count << "/can_erase=" << can_erase;
+  return answer.str();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto PairingPriorityQueue<T,tgt,GT>::Iterator::operator ++ () -> PairingPriorityQueue<T,tgt,GT>::Iterator& {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("PairingPriorityQueue::Iterator::operator ++");
+
+  if (it.empty())
+    return *this;
+
+  if (can_erase)
+    it.dequeue();
+  else
+    can_erase = true;
+
+  return *this;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+auto PairingPriorityQueue<T,tgt,GT>::Iterator::operator ++ (int) -> PairingPriorityQueue<T,tgt,GT>::Iterator {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("PairingPriorityQueue::Iterator::operator ++(int)");
+
+  if (it.empty())
+    return *this;
+
+  Iterator to_return(*this);
+  if (can_erase)
+    it.dequeue();
+  else
+    can_erase = true;
+
+  return to_return;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool PairingPriorityQueue<T,tgt,GT>::Iterator::operator == (const PairingPriorityQueue<T,tgt,GT>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("PairingPriorityQueue::Iterator::operator ==");
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("PairingPriorityQueue::Iterator::operator ==");
+  if (ref_pq != rhsASI->ref_pq)
+    throw ComparingDifferentIteratorsError("PairingPriorityQueue::Iterator::operator ==");
+
+  //Two iterators on the same heap are equal if their sizes are equal
+  return this->it.size() == rhsASI->it.size();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+bool PairingPriorityQueue<T,tgt,GT>::Iterator::operator != (const PairingPriorityQueue<T,tgt,GT>::Iterator& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T& PairingPriorityQueue<T,tgt,GT>::Iterator::operator *() const {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("PairingPriorityQueue::Iterator::operator *");
+  if (!can_erase || it.empty())
+    throw IteratorPositionIllegal("PairingPriorityQueue::Iterator::operator * Iterator illegal: exhausted");
+
+  return it.peek();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class GT>
+T* PairingPriorityQueue<T,tgt,GT>::Iterator::operator ->() const {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("PairingPriorityQueue::Iterator::operator ->");
+  if (!can_erase || it.empty())
+    throw IteratorPositionIllegal("PairingPriorityQueue::Iterator::operator -> Iterator illegal: exhausted");
+
+  return &it.peek();
+}
+
+}
+
+#endif /* PAIRING_PRIORITY_QUEUE_HPP_ */
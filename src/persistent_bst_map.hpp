@@ -0,0 +1,847 @@
+#ifndef PERSISTENT_BST_MAP_HPP_
+#define PERSISTENT_BST_MAP_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <atomic>
+#include <algorithm>            //For std::max
+#include "ics_exceptions.hpp"
+#include "functor.hpp"
+#include "pair.hpp"
+#include "array_stack.hpp"   //For in-order walks
+
+
+namespace ics {
+
+
+//A BSTMap whose copies share their TN: copying (or snapshot) is O(1), and a
+//  command copies only the TN on the path from the root to the TN it changes
+//  (path copying), plus any shared TN it rotates. A TN reachable from more
+//  than one map is never changed.
+//The tree is kept AVL-balanced, so each command descends (iteratively) and
+//  copies only O(log N) TN, even for keys put in sorted order.
+//Each map object is single-threaded, but reference counts are atomic: a writer
+//  can hand snapshot()s to reader threads, and each thread then uses its own
+//  map object concurrently with the others.
+//Instantiate such that tlt(a,b) is true, iff a is in the left subtree rooted by b
+//With a tlt specified in the template, the constructor cannot specify a clt.
+//If a tlt is defaulted, then the constructor must supply a clt (they cannot both be nullptr)
+//Instead, LT can be a functor type whose LT()(a,b) is the ordering (then neither tlt nor clt is supplied)
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr, class LT = void> class PersistentBSTMap {
+  public:
+    typedef pair<KEY,T> Entry;
+
+    //Destructor/Constructors
+    ~PersistentBSTMap();
+
+    PersistentBSTMap          (bool (*clt)(const KEY& a, const KEY& b) = nullptr);
+    PersistentBSTMap          (const PersistentBSTMap<KEY,T,tlt,LT>& to_copy, bool (*clt)(const KEY& a, const KEY& b) = nullptr);
+    explicit PersistentBSTMap (const std::initializer_list<Entry>& il, bool (*clt)(const KEY& a, const KEY& b) = nullptr);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit PersistentBSTMap (const Iterable& i, bool (*clt)(const KEY& a, const KEY& b) = nullptr);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    bool has_key    (const KEY& key) const;
+    bool has_value  (const T& value) const;
+    PersistentBSTMap<KEY,T,tlt,LT> snapshot () const; //O(1) point-in-time copy; unaffected by later commands on this map
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    T    put   (const KEY& key, const T& value);
+    T    erase (const KEY& key);
+    void clear ();
+    void rebalance ();  //Rebuild the tree from copies of its TN (which may be shared) so it is perfectly balanced: O(N)
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int put_all(const Iterable& i);
+
+    //Move all of greater's entries (all keys must be > this map's keys) into this map,
+    //  which takes over greater's (possibly shared) TN; O(height)
+    void join (PersistentBSTMap<KEY,T,tlt,LT>& greater);
+
+
+    //Operators
+
+    T&       operator [] (const KEY&);       //Copies the path to key's TN, which may be shared
+    const T& operator [] (const KEY&) const;
+    PersistentBSTMap<KEY,T,tlt,LT>& operator = (const PersistentBSTMap<KEY,T,tlt,LT>& rhs);
+    bool operator == (const PersistentBSTMap<KEY,T,tlt,LT>& rhs) const;
+    bool operator != (const PersistentBSTMap<KEY,T,tlt,LT>& rhs) const;
+
+    template<class KEY2,class T2, bool (*lt2)(const KEY2& a, const KEY2& b), class LT2>
+    friend std::ostream& operator << (std::ostream& outs, const PersistentBSTMap<KEY2,T2,lt2,LT2>& m);
+
+
+
+  private:
+    class TN;
+
+  public:
+    //Iterates over a snapshot taken by begin: entries are read-only (their TN may be shared)
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of PersistentBSTMap<T>
+        ~Iterator();
+        Entry       erase();
+        std::string str  () const;
+        PersistentBSTMap<KEY,T,tlt,LT>::Iterator& operator ++ ();
+        PersistentBSTMap<KEY,T,tlt,LT>::Iterator  operator ++ (int);
+        bool operator == (const PersistentBSTMap<KEY,T,tlt,LT>::Iterator& rhs) const;
+        bool operator != (const PersistentBSTMap<KEY,T,tlt,LT>::Iterator& rhs) const;
+        const Entry& operator *  () const;
+        const Entry* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const PersistentBSTMap<KEY,T,tlt,LT>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+        friend Iterator PersistentBSTMap<KEY,T,tlt,LT>::begin () const;
+        friend Iterator PersistentBSTMap<KEY,T,tlt,LT>::end   () const;
+
+      private:
+        //If can_erase is false, the top of pending is the "next" value (must ++ to reach it)
+        PersistentBSTMap<KEY,T,tlt,LT>  it;                 //O(1) snapshot (from begin): keeps its TN alive
+        ArrayStack<TN*>                 pending;            //In-order walk of it: top is the current TN
+        PersistentBSTMap<KEY,T,tlt,LT>* ref_map;
+        int                             expected_mod_count;
+        bool                            can_erase = true;
+
+        //Called in friends begin/end
+        Iterator(PersistentBSTMap<KEY,T,tlt,LT>* iterate_over, bool from_begin);
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+    class TN {
+      public:
+        TN (Entry v, TN* l = nullptr,
+                     TN* r = nullptr) : value(v), left(l), right(r), height(1 + std::max(height_of(l), height_of(r))){}
+
+        Entry            value;
+        TN*              left;
+        TN*              right;
+        int              height;             //Of the subtree rooted here (a leaf's is 1)
+        std::atomic<int> references{1};      //# of maps/TN pointing to this TN
+    };
+
+  static int height_of (TN* root) {return root == nullptr ? 0 : root->height;}
+  static const int max_height = 64;        //An AVL tree with 2^31 TN is less than 46 high
+
+  static_assert(std::is_void<LT>::value || tlt == nullptr, "PersistentBSTMap: specify tlt or LT, not both");
+  bool (*lt) (const KEY& a, const KEY& b); // The lt used for searching BST (from template or constructor)
+  TN* map       = nullptr;
+  int used      = 0;                       //Cache for number of key->value pairs in the BST
+  int mod_count = 0;                       //For sensing concurrent modification
+
+  //Helper methods
+  bool is_lt (const KEY& a, const KEY& b) const; //True iff a < b: via the functor type, tlt or lt (see functor.hpp)
+  TN*   find_key            (TN*  root, const KEY& key)                 const; //Returns reference to key's node or nullptr
+  void  push_left_spine     (TN*  root, ArrayStack<TN*>& pending)       const; //Push root and its chain of left children (in-order walk)
+  std::string string_rotated(TN* root, std::string indent)              const; //Returns string representing root's tree
+
+  static TN* share          (TN*  root);                                       //Add a reference to root; returns root
+  static void release       (TN*& root);                                       //Drop a reference to root, deleting TN no longer referenced; root == nullptr
+  void  own                 (TN*& root);                                       //Replace a shared root by a private copy (sharing its children)
+  TN*   copy_balanced       (ArrayStack<TN*>& pending, int n)           const; //Balanced tree of copies of the next n TN in pending's in-order walk
+
+  static void fix_height    (TN*  root);                                       //Recompute root's height from its children's
+  void  rotate_left         (TN*& root);                                       //Make root's right child the root (owning both first)
+  void  rotate_right        (TN*& root);                                       //Make root's left child the root (owning both first)
+  void  restore_balance     (TN*& root);                                       //root (owned) has subtrees differing in height by <= 2: rotate so they differ by <= 1
+  void  restore_path        (TN** path[], int depth);                          //restore_balance each link in path, bottom up
+  TN**  descend             (const KEY& key, TN** path[], int& depth);         //Own the TN from map toward key, recording the links; returns the link to key's TN (or nullptr)
+  TN*   join_trees          (TN* less, const Entry& middle, TN* greater);      //Balanced tree of less's entries, middle, then greater's (taking over their references)
+
+  T     insert              (const KEY& key, const T& value);                  //Put key->value, returning key's old value (or new one's, if key absent)
+  T&    find_addempty       (const KEY& key);                                  //Return reference to key's value (adding key->T() first, if key absent)
+  T     remove              (const KEY& key);                                  //Remove key->value (which must be present)
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//PersistentBSTMap class and related definitions
+
+//Destructor/Constructors
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+PersistentBSTMap<KEY,T,tlt,LT>::~PersistentBSTMap() {
+  release(map);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+PersistentBSTMap<KEY,T,tlt,LT>::PersistentBSTMap(bool (*clt)(const KEY& a, const KEY& b))
+: lt(tlt != nullptr ? tlt : clt) {
+  if (lt == nullptr && std::is_void<LT>::value)
+    throw TemplateFunctionError("PersistentBSTMap::default constructor: neither specified");
+  if ((tlt != nullptr || !std::is_void<LT>::value) && clt != nullptr && tlt != clt)
+    throw TemplateFunctionError("PersistentBSTMap::default constructor: both specified and different");
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+PersistentBSTMap<KEY,T,tlt,LT>::PersistentBSTMap(const PersistentBSTMap<KEY,T,tlt,LT>& to_copy, bool (*clt)(const KEY& a, const KEY& b))
+: lt(tlt != nullptr ? tlt : clt) {
+  if (lt == nullptr)
+    lt = to_copy.lt;
+  if ((tlt != nullptr || !std::is_void<LT>::value) && clt != nullptr && tlt != clt)
+    throw TemplateFunctionError("PersistentBSTMap::copy constructor: both specified and different");
+
+  if (lt == to_copy.lt) {
+    map  = share(to_copy.map);
+    used = to_copy.used;
+  }else
+    for (const Entry& m_entry : to_copy)
+      put(m_entry.first,m_entry.second);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+PersistentBSTMap<KEY,T,tlt,LT>::PersistentBSTMap(const std::initializer_list<Entry>& il, bool (*clt)(const KEY& a, const KEY& b))
+: lt(tlt != nullptr ? tlt : clt) {
+  if (lt == nullptr && std::is_void<LT>::value)
+    throw TemplateFunctionError("PersistentBSTMap::initializer_list constructor: neither specified");
+  if ((tlt != nullptr || !std::is_void<LT>::value) && clt != nullptr && tlt != clt)
+    throw TemplateFunctionError("PersistentBSTMap::initializer_list constructor: both specified and different");
+
+  for (const Entry& m_entry : il)
+    put(m_entry.first,m_entry.second);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+template <class Iterable>
+PersistentBSTMap<KEY,T,tlt,LT>::PersistentBSTMap(const Iterable& i, bool (*clt)(const KEY& a, const KEY& b))
+: lt(tlt != nullptr ? tlt : clt) {
+  if (lt == nullptr && std::is_void<LT>::value)
+    throw TemplateFunctionError("PersistentBSTMap::Iterable constructor: neither specified");
+  if ((tlt != nullptr || !std::is_void<LT>::value) && clt != nullptr && tlt != clt)
+    throw TemplateFunctionError("PersistentBSTMap::Iterable constructor: both specified and different");
+
+  for (const auto& m_entry : i)
+    put(m_entry.first,m_entry.second);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool PersistentBSTMap<KEY,T,tlt,LT>::empty() const {
+  return used == 0;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+int PersistentBSTMap<KEY,T,tlt,LT>::size() const {
+  return used;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool PersistentBSTMap<KEY,T,tlt,LT>::has_key (const KEY& key) const {
+  return find_key(map,key) != nullptr;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool PersistentBSTMap<KEY,T,tlt,LT>::has_value (const T& value) const {
+  ArrayStack<TN*> pending;
+  push_left_spine(map,pending);
+  while (!pending.empty()) {
+    TN* next = pending.pop();
+    if (next->value.second == value)
+      return true;
+    push_left_spine(next->right,pending);
+  }
+  return false;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto PersistentBSTMap<KEY,T,tlt,LT>::snapshot () const -> PersistentBSTMap<KEY,T,tlt,LT> {
+  return PersistentBSTMap<KEY,T,tlt,LT>(*this);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+std::string PersistentBSTMap<KEY,T,tlt,LT>::str() const {
+  std::ostringstream answer;
+  answer << "persistent_bst_map[\n" << string_rotated(map, "") << "](used=" << used << ",mod_count=" << mod_count << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T PersistentBSTMap<KEY,T,tlt,LT>::put(const KEY& key, const T& value) {
+  ++mod_count;
+  return insert(key, value);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T PersistentBSTMap<KEY,T,tlt,LT>::erase(const KEY& key) {
+  //Search first: a missing key must not copy the path to it
+  if (find_key(map,key) == nullptr) {
+    std::ostringstream answer;
+    answer << "PersistentBSTMap::erase: key(" << key << ") not in Map";
+    throw KeyError(answer.str());
+  }
+  T to_return = remove(key);
+  --used;
+  ++mod_count;
+  return to_return;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void PersistentBSTMap<KEY,T,tlt,LT>::clear() {
+  release(map);
+  used = 0;
+  ++mod_count;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void PersistentBSTMap<KEY,T,tlt,LT>::rebalance() {
+  ArrayStack<TN*> pending;
+  push_left_spine(map, pending);
+  TN* balanced = copy_balanced(pending, used);
+  release(map);
+  map = balanced;
+  ++mod_count;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+template<class Iterable>
+int PersistentBSTMap<KEY,T,tlt,LT>::put_all(const Iterable& i) {
+  int count = 0;
+  for (const auto& m_entry : i) {
+    ++count;
+    put(m_entry.first, m_entry.second);
+  }
+
+  return count;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void PersistentBSTMap<KEY,T,tlt,LT>::join(PersistentBSTMap<KEY,T,tlt,LT>& greater) {
+  if (this == &greater || greater.empty())
+    return;
+  if (lt != greater.lt)
+    throw TemplateFunctionError("PersistentBSTMap::join: different lt");
+  if (!empty()) {
+    TN* largest = map;
+    while (largest->right != nullptr)
+      largest = largest->right;
+    TN* smallest = greater.map;
+    while (smallest->left != nullptr)
+      smallest = smallest->left;
+    if (!is_lt(largest->value.first, smallest->value.first)) {
+      std::ostringstream answer;
+      answer << "PersistentBSTMap::join: key(" << smallest->value.first << ") not greater than key(" << largest->value.first << ")";
+      throw KeyError(answer.str());
+    }
+    //This tree's largest entry joins both trees
+    Entry middle = largest->value;
+    remove(middle.first);
+    map = join_trees(map, middle, greater.map);
+  }else
+    map = greater.map;
+  used += greater.used;
+  greater.map = nullptr;     //Its reference now belongs to this map
+  greater.used = 0;
+  ++mod_count, ++greater.mod_count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T& PersistentBSTMap<KEY,T,tlt,LT>::operator [] (const KEY& key) {
+  return find_addempty(key);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+const T& PersistentBSTMap<KEY,T,tlt,LT>::operator [] (const KEY& key) const {
+  TN* found = find_key(map,key);
+  if (found != nullptr)
+    return found->value.second;
+
+  std::ostringstream answer;
+  answer << "PersistentBSTMap::operator []: key(" << key << ") not in Map";
+  throw KeyError(answer.str());
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+PersistentBSTMap<KEY,T,tlt,LT>& PersistentBSTMap<KEY,T,tlt,LT>::operator = (const PersistentBSTMap<KEY,T,tlt,LT>& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  TN* old_map = map;
+  lt   = rhs.lt;   // if tlt != nullptr, lts are already equal (or compiler error)
+  map  = share(rhs.map);
+  used = rhs.used;
+  release(old_map);
+  ++mod_count;
+  return *this;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool PersistentBSTMap<KEY,T,tlt,LT>::operator == (const PersistentBSTMap<KEY,T,tlt,LT>& rhs) const {
+  if (this == &rhs || (map == rhs.map && lt == rhs.lt))   //Same snapshot
+    return true;
+  if (used != rhs.size() || lt != rhs.lt)
+    return false;
+
+  //Same lt: equal maps list the same entries in the same in-order sequence
+  ArrayStack<TN*> this_pending, rhs_pending;
+  push_left_spine(map, this_pending);
+  push_left_spine(rhs.map, rhs_pending);
+  while (!this_pending.empty() && !rhs_pending.empty()) {
+    TN* this_next = this_pending.pop();
+    TN* rhs_next  = rhs_pending.pop();
+    if (this_next->value.first != rhs_next->value.first || this_next->value.second != rhs_next->value.second)
+      return false;
+    push_left_spine(this_next->right, this_pending);
+    push_left_spine(rhs_next->right, rhs_pending);
+  }
+  return this_pending.empty() && rhs_pending.empty();
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool PersistentBSTMap<KEY,T,tlt,LT>::operator != (const PersistentBSTMap<KEY,T,tlt,LT>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+std::ostream& operator << (std::ostream& outs, const PersistentBSTMap<KEY,T,tlt,LT>& m) {
+  outs << "map[";
+
+  int printed = 0;
+  for (const auto& m_entry : m)
+    outs << (printed++ == 0? "" : ",") << m_entry.first << "->" << m_entry.second;
+
+  outs << "]";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto PersistentBSTMap<KEY,T,tlt,LT>::begin () const -> PersistentBSTMap<KEY,T,tlt,LT>::Iterator {
+  return Iterator(const_cast<PersistentBSTMap<KEY,T,tlt,LT>*>(this),true);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto PersistentBSTMap<KEY,T,tlt,LT>::end () const -> PersistentBSTMap<KEY,T,tlt,LT>::Iterator {
+  return Iterator(const_cast<PersistentBSTMap<KEY,T,tlt,LT>*>(this),false);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool PersistentBSTMap<KEY,T,tlt,LT>::is_lt (const KEY& a, const KEY& b) const {
+  return Functor<LT>::call(tlt != nullptr ? tlt : lt, a, b);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+typename PersistentBSTMap<KEY,T,tlt,LT>::TN* PersistentBSTMap<KEY,T,tlt,LT>::find_key (TN* root, const KEY& key) const {
+  TN* traverse = root;
+  while (traverse != nullptr && traverse->value.first != key)
+    traverse = is_lt(key, traverse->value.first) ? traverse->left : traverse->right;
+  return traverse;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void PersistentBSTMap<KEY,T,tlt,LT>::push_left_spine (TN* root, ArrayStack<TN*>& pending) const {
+  for (; root != nullptr; root = root->left)
+    pending.push(root);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+std::string PersistentBSTMap<KEY,T,tlt,LT>::string_rotated(TN* root, std::string indent) const {
+  if (root == nullptr)
+    return "";
+  std::ostringstream answer;
+  answer << string_rotated(root->right, indent + "..");
+  answer << indent << root->value.first << "->" << root->value.second << "(references=" << root->references.load() << ")\n";
+  answer << string_rotated(root->left, indent + "..");
+  return answer.str();
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+typename PersistentBSTMap<KEY,T,tlt,LT>::TN* PersistentBSTMap<KEY,T,tlt,LT>::share (TN* root) {
+  if (root != nullptr)
+    root->references.fetch_add(1, std::memory_order_relaxed);
+  return root;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void PersistentBSTMap<KEY,T,tlt,LT>::release (TN*& root) {
+  if (root != nullptr && root->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    release(root->left);
+    release(root->right);
+    delete root;
+  }
+  root = nullptr;
+}
+
+
+//A TN referenced only once is reachable only through this map's own path,
+//  so it can be changed in place; otherwise copy it before changing it
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void PersistentBSTMap<KEY,T,tlt,LT>::own (TN*& root) {
+  if (root->references.load(std::memory_order_acquire) == 1)
+    return;
+  TN* to_release = root;
+  root = new TN(to_release->value, share(to_release->left), share(to_release->right));
+  release(to_release);
+}
+
+
+//pending's top is the next TN in key order; the recursion is only log2(n) deep
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+typename PersistentBSTMap<KEY,T,tlt,LT>::TN* PersistentBSTMap<KEY,T,tlt,LT>::copy_balanced (ArrayStack<TN*>& pending, int n) const {
+  if (n == 0)
+    return nullptr;
+  TN* left = copy_balanced(pending, n/2);
+  TN* next = pending.pop();
+  push_left_spine(next->right, pending);
+  TN* root = new TN(next->value, left);
+  root->right = copy_balanced(pending, n-n/2-1);
+  fix_height(root);
+  return root;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void PersistentBSTMap<KEY,T,tlt,LT>::fix_height (TN* root) {
+  root->height = 1 + std::max(height_of(root->left), height_of(root->right));
+}
+
+
+//root's old child becomes its parent: both must be owned, since both change
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void PersistentBSTMap<KEY,T,tlt,LT>::rotate_left (TN*& root) {
+  own(root);
+  own(root->right);
+  TN* child   = root->right;
+  root->right = child->left;
+  child->left = root;
+  fix_height(root);
+  fix_height(child);
+  root = child;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void PersistentBSTMap<KEY,T,tlt,LT>::rotate_right (TN*& root) {
+  own(root);
+  own(root->left);
+  TN* child    = root->left;
+  root->left   = child->right;
+  child->right = root;
+  fix_height(root);
+  fix_height(child);
+  root = child;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void PersistentBSTMap<KEY,T,tlt,LT>::restore_balance (TN*& root) {
+  int balance = height_of(root->left) - height_of(root->right);
+  if (balance > 1) {
+    if (height_of(root->left->left) < height_of(root->left->right))
+      rotate_left(root->left);
+    rotate_right(root);
+  }else if (balance < -1) {
+    if (height_of(root->right->right) < height_of(root->right->left))
+      rotate_right(root->right);
+    rotate_left(root);
+  }else
+    fix_height(root);
+}
+
+
+//Each link is in the TN (owned, so unmoved by rotations) the link above it leads to
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+void PersistentBSTMap<KEY,T,tlt,LT>::restore_path (TN** path[], int depth) {
+  while (depth > 0)
+    restore_balance(*path[--depth]);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+typename PersistentBSTMap<KEY,T,tlt,LT>::TN** PersistentBSTMap<KEY,T,tlt,LT>::descend (const KEY& key, TN** path[], int& depth) {
+  TN** link = &map;
+  while (*link != nullptr) {
+    own(*link);
+    TN* node = *link;
+    if (node->value.first == key)
+      return link;
+    path[depth++] = link;
+    link = is_lt(key, node->value.first) ? &node->left : &node->right;
+  }
+  return link;
+}
+
+
+//Descend the taller tree's spine facing the other to a subtree at most 1
+//  higher than it; middle joins those two, and rotations restore the spine
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+typename PersistentBSTMap<KEY,T,tlt,LT>::TN* PersistentBSTMap<KEY,T,tlt,LT>::join_trees (TN* less, const Entry& middle, TN* greater) {
+  TN** path[max_height];
+  int  depth = 0;
+  TN*  root  = height_of(less) >= height_of(greater) ? less : greater;
+  TN** link  = &root;
+  if (root == less)
+    while (height_of(*link) > height_of(greater)+1) {
+      own(*link);
+      path[depth++] = link;
+      link = &(*link)->right;
+    }
+  else
+    while (height_of(*link) > height_of(less)+1) {
+      own(*link);
+      path[depth++] = link;
+      link = &(*link)->left;
+    }
+  *link = root == less ? new TN(middle, *link, greater) : new TN(middle, less, *link);
+  restore_path(path, depth);
+  return root;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T PersistentBSTMap<KEY,T,tlt,LT>::insert (const KEY& key, const T& value) {
+  TN** path[max_height];
+  int  depth = 0;
+  TN** link  = descend(key, path, depth);
+  if (*link != nullptr) {
+    T old = (*link)->value.second;
+    (*link)->value.second = value;
+    return old;
+  }
+  *link = new TN(Entry(key,value));
+  ++used;
+  restore_path(path, depth);
+  return value;
+}
+
+
+//Rotations above a new TN move it, but never copy it (it is not shared)
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T& PersistentBSTMap<KEY,T,tlt,LT>::find_addempty (const KEY& key) {
+  TN** path[max_height];
+  int  depth = 0;
+  TN** link  = descend(key, path, depth);
+  if (*link != nullptr)
+    return (*link)->value.second;
+  TN* added = *link = new TN(Entry(key,T()));
+  ++used;
+  ++mod_count;
+  restore_path(path, depth);
+  return added->value.second;
+}
+
+
+//A TN with two children takes the entry of the largest TN in its left
+//  subtree, which is unlinked instead
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+T PersistentBSTMap<KEY,T,tlt,LT>::remove (const KEY& key) {
+  TN** path[max_height];
+  int  depth = 0;
+  TN** link  = descend(key, path, depth);
+  TN*  found = *link;
+  T    to_return = found->value.second;
+  if (found->left != nullptr && found->right != nullptr) {
+    path[depth++] = link;
+    link = &found->left;
+    own(*link);
+    while ((*link)->right != nullptr) {
+      path[depth++] = link;
+      link = &(*link)->right;
+      own(*link);
+    }
+    found->value = (*link)->value;
+  }
+
+  TN* to_release = *link;
+  *link = share(to_release->left != nullptr ? to_release->left : to_release->right);
+  release(to_release);
+  restore_path(path, depth);
+  return to_return;
+}
+
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+PersistentBSTMap<KEY,T,tlt,LT>::Iterator::Iterator(PersistentBSTMap<KEY,T,tlt,LT>* iterate_over, bool from_begin)
+: it(iterate_over->lt), ref_map(iterate_over), expected_mod_count(ref_map->mod_count) {
+  if (from_begin) {
+    it = *iterate_over;
+    it.push_left_spine(it.map, pending);
+  }
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+PersistentBSTMap<KEY,T,tlt,LT>::Iterator::~Iterator()
+{}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto PersistentBSTMap<KEY,T,tlt,LT>::Iterator::erase() -> Entry {
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("PersistentBSTMap::Iterator::erase");
+  if (!can_erase)
+    throw CannotEraseError("PersistentBSTMap::Iterator::erase Iterator cursor already erased");
+  if (pending.empty())
+    throw CannotEraseError("PersistentBSTMap::Iterator::erase Iterator cursor beyond data structure");
+
+  can_erase = false;
+  TN* current = pending.pop();
+  it.push_left_spine(current->right, pending);
+  Entry to_return = current->value;
+  ref_map->erase(to_return.first);         //The snapshot in it is unaffected
+  expected_mod_count = ref_map->mod_count;
+  return to_return;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+std::string PersistentBSTMap<KEY,T,tlt,LT>::Iterator::str() const {
+  std::ostringstream answer;
+  answer << ref_map->str() << "(current=";
+  if (pending.empty())
+    answer << "end";
+  else
+    answer << pending.peek()->value;
+  answer << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
+  return answer.str();
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto PersistentBSTMap<KEY,T,tlt,LT>::Iterator::operator ++ () -> PersistentBSTMap<KEY,T,tlt,LT>::Iterator& {
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("PersistentBSTMap::Iterator::operator ++");
+
+  if (pending.empty())
+    return *this;
+
+  if (can_erase) {
+    TN* current = pending.pop();
+    it.push_left_spine(current->right, pending);
+  }else
+    can_erase = true;
+  return *this;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto PersistentBSTMap<KEY,T,tlt,LT>::Iterator::operator ++ (int) -> PersistentBSTMap<KEY,T,tlt,LT>::Iterator {
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("PersistentBSTMap::Iterator::operator ++(int)");
+
+  Iterator to_return(*this);
+  ++(*this);
+  return to_return;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool PersistentBSTMap<KEY,T,tlt,LT>::Iterator::operator == (const PersistentBSTMap<KEY,T,tlt,LT>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("PersistentBSTMap::Iterator::operator ==");
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("PersistentBSTMap::Iterator::operator ==");
+  if (ref_map != rhsASI->ref_map)
+    throw ComparingDifferentIteratorsError("PersistentBSTMap::Iterator::operator ==");
+
+  //Iterators over the same (unmodified) map are equal when they are at the same TN
+  return (pending.empty() ? nullptr : pending.peek()) == (rhsASI->pending.empty() ? nullptr : rhsASI->pending.peek());
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+bool PersistentBSTMap<KEY,T,tlt,LT>::Iterator::operator != (const PersistentBSTMap<KEY,T,tlt,LT>::Iterator& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto PersistentBSTMap<KEY,T,tlt,LT>::Iterator::operator *() const -> const Entry& {
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("PersistentBSTMap::Iterator::operator *");
+  if (!can_erase || pending.empty())
+    throw IteratorPositionIllegal("PersistentBSTMap::Iterator::operator * Iterator illegal: exhausted");
+
+  return pending.peek()->value;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class LT>
+auto PersistentBSTMap<KEY,T,tlt,LT>::Iterator::operator ->() const -> const Entry* {
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("PersistentBSTMap::Iterator::operator ->");
+  if (!can_erase || pending.empty())
+    throw IteratorPositionIllegal("PersistentBSTMap::Iterator::operator -> Iterator illegal: exhausted");
+
+  return &pending.peek()->value;
+}
+
+
+}
+
+#endif /* PERSISTENT_BST_MAP_HPP_ */
@@ -0,0 +1,615 @@
+#ifndef RADIX_HEAP_PRIORITY_QUEUE_HPP_
+#define RADIX_HEAP_PRIORITY_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <utility>              //For std::swap function
+#include "ics_exceptions.hpp"
+#include "functor.hpp"
+#include "array_stack.hpp"      //See operator <<
+
+
+namespace ics {
+
+
+//A radix heap: a monotone priority queue for values with unsigned integer keys
+//  (e.g., distances in Dijkstra's algorithm). The value with the SMALLEST key has
+//  the highest priority, and no value can be enqueued with a key smaller than the
+//  key of the value most recently dequeued (or peeked at): KeyError is raised.
+//Bucket b (b > 0) stores values whose keys first differ from the last key at bit
+//  b-1; bucket 0 stores values whose keys equal the last key. dequeue empties
+//  the lowest nonempty bucket into lower ones, so each value moves at most 64
+//  times: enqueue is O(1) and dequeue is O(1) amortized (for 64-bit keys).
+//Has the HeapPriorityQueue interface.
+//Instantiate the templated class supplying tkey(a): the key of a.
+//If tkey is defaulted to nullptr in the template, then a constructor must supply ckey.
+//If both tkey and ckey are supplied, then they must be the same (by ==) function.
+//If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
+//Instead, KEYOF can be a functor type whose KEYOF()(a) is the key (then neither tkey nor ckey is supplied).
+template<class T, unsigned long long (*tkey)(const T& a) = nullptr, class KEYOF = void> class RadixHeapPriorityQueue {
+  public:
+    //Destructor/Constructors
+    ~RadixHeapPriorityQueue();
+
+    RadixHeapPriorityQueue(unsigned long long (*ckey)(const T& a) = nullptr);
+    RadixHeapPriorityQueue(const RadixHeapPriorityQueue<T,tkey,KEYOF>& to_copy, unsigned long long (*ckey)(const T& a) = nullptr);
+    explicit RadixHeapPriorityQueue(const std::initializer_list<T>& il, unsigned long long (*ckey)(const T& a) = nullptr);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit RadixHeapPriorityQueue (const Iterable& i, unsigned long long (*ckey)(const T& a) = nullptr);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    T&   peek       () const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    int  enqueue (const T& element);
+    T    dequeue ();
+    void clear   ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+
+    //Operators
+    RadixHeapPriorityQueue<T,tkey,KEYOF>& operator = (const RadixHeapPriorityQueue<T,tkey,KEYOF>& rhs);
+    bool operator == (const RadixHeapPriorityQueue<T,tkey,KEYOF>& rhs) const;
+    bool operator != (const RadixHeapPriorityQueue<T,tkey,KEYOF>& rhs) const;
+
+    template<class T2, unsigned long long (*key2)(const T2& a), class KEYOF2>
+    friend std::ostream& operator << (std::ostream& outs, const RadixHeapPriorityQueue<T2,key2,KEYOF2>& pq);
+
+
+
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of RadixHeapPriorityQueue<T,tkey,KEYOF>
+        ~Iterator();
+        T           erase();
+        std::string str  () const;
+        RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator& operator ++ ();
+        RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator  operator ++ (int);
+        bool operator == (const RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator& rhs) const;
+        bool operator != (const RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+
+        friend Iterator RadixHeapPriorityQueue<T,tkey,KEYOF>::begin () const;
+        friend Iterator RadixHeapPriorityQueue<T,tkey,KEYOF>::end   () const;
+
+      private:
+        //If can_erase is false, the value has been removed from "it" (++ does nothing)
+        RadixHeapPriorityQueue<T,tkey,KEYOF>  it;                 //copy of RHPQ (from begin), to use as iterator via dequeue
+        RadixHeapPriorityQueue<T,tkey,KEYOF>* ref_pq;
+        int                                   expected_mod_count;
+        bool                                  can_erase = true;
+
+        //Called in friends begin/end
+        //These constructors have different initializers (see it(...) in first one)
+        Iterator(RadixHeapPriorityQueue<T,tkey,KEYOF>* iterate_over, bool from_begin);    // Called by begin
+        Iterator(RadixHeapPriorityQueue<T,tkey,KEYOF>* iterate_over);                     // Called by end
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+    class LN {
+      public:
+        LN (const T& v, unsigned long long k, LN* n = nullptr) : value(v), key(k), next(n) {}
+
+        T                  value;
+        unsigned long long key;   //Cached: computed once, at enqueue
+        LN*                next;
+    };
+
+    static const int bucket_count = 65;   //Bucket 0, and one per bit of an unsigned long long key
+
+    static_assert(std::is_void<KEYOF>::value || tkey == nullptr, "RadixHeapPriorityQueue: specify tkey or KEYOF, not both");
+    unsigned long long (*key) (const T& a);      // The key used by enqueue (from template or constructor)
+    mutable LN*                buckets[bucket_count] = {};
+    mutable unsigned long long last = 0;         //Key of the value last dequeued (or peeked at); bucket 0's key
+    int used      = 0;
+    int mod_count = 0;                           //For sensing concurrent modification
+
+
+    //Helper methods
+    unsigned long long key_of    (const T& a) const;               //Via the functor type, tkey or key (see functor.hpp)
+    int                bucket_of (unsigned long long k) const;     //Bucket storing a value whose key is k (k >= last)
+    void               pull      () const;                         //Ensure buckets[0] is nonempty (when !empty())
+    void               copy      (const RadixHeapPriorityQueue<T,tkey,KEYOF>& to_copy);
+    bool               remove    (const T& value);                 //Remove one value == value; return whether found
+    void               delete_buckets ();                          //Deallocate all LN; all buckets == nullptr
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//RadixHeapPriorityQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+RadixHeapPriorityQueue<T,tkey,KEYOF>::~RadixHeapPriorityQueue() {
+  delete_buckets();
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+RadixHeapPriorityQueue<T,tkey,KEYOF>::RadixHeapPriorityQueue(unsigned long long (*ckey)(const T& a))
+: key(tkey != nullptr ? tkey : ckey) {
+  if (key == nullptr && std::is_void<KEYOF>::value)
+    throw TemplateFunctionError("RadixHeapPriorityQueue::default constructor: neither specified");
+  if ((tkey != nullptr || !std::is_void<KEYOF>::value) && ckey != nullptr && tkey != ckey)
+    throw TemplateFunctionError("RadixHeapPriorityQueue::default constructor: both specified and different");
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+RadixHeapPriorityQueue<T,tkey,KEYOF>::RadixHeapPriorityQueue(const RadixHeapPriorityQueue<T,tkey,KEYOF>& to_copy, unsigned long long (*ckey)(const T& a))
+: key(tkey != nullptr ? tkey : ckey) {
+  if (key == nullptr)
+    key = to_copy.key;
+  if ((tkey != nullptr || !std::is_void<KEYOF>::value) && ckey != nullptr && tkey != ckey)
+    throw TemplateFunctionError("RadixHeapPriorityQueue::copy constructor: both specified and different");
+
+  if (key == to_copy.key)
+    copy(to_copy);
+  else
+    //Different key function: last is not a valid lower bound; start from 0
+    for (int b = 0; b < bucket_count; ++b)
+      for (LN* p = to_copy.buckets[b]; p != nullptr; p = p->next)
+        enqueue(p->value);
+  mod_count = 0;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+RadixHeapPriorityQueue<T,tkey,KEYOF>::RadixHeapPriorityQueue(const std::initializer_list<T>& il, unsigned long long (*ckey)(const T& a))
+: key(tkey != nullptr ? tkey : ckey) {
+  if (key == nullptr && std::is_void<KEYOF>::value)
+    throw TemplateFunctionError("RadixHeapPriorityQueue::initializer_list constructor: neither specified");
+  if ((tkey != nullptr || !std::is_void<KEYOF>::value) && ckey != nullptr && tkey != ckey)
+    throw TemplateFunctionError("RadixHeapPriorityQueue::initializer_list constructor: both specified and different");
+
+  for (const T& pq_elem : il)
+    enqueue(pq_elem);
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+template<class Iterable>
+RadixHeapPriorityQueue<T,tkey,KEYOF>::RadixHeapPriorityQueue(const Iterable& i, unsigned long long (*ckey)(const T& a))
+: key(tkey != nullptr ? tkey : ckey) {
+  if (key == nullptr && std::is_void<KEYOF>::value)
+    throw TemplateFunctionError("RadixHeapPriorityQueue::Iterable constructor: neither specified");
+  if ((tkey != nullptr || !std::is_void<KEYOF>::value) && ckey != nullptr && tkey != ckey)
+    throw TemplateFunctionError("RadixHeapPriorityQueue::Iterable constructor: both specified and different");
+
+  for (const T& pq_elem : i)
+    enqueue(pq_elem);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+bool RadixHeapPriorityQueue<T,tkey,KEYOF>::empty() const {
+  return used == 0;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+int RadixHeapPriorityQueue<T,tkey,KEYOF>::size() const {
+  return used;
+}
+
+
+//Raises last to the smallest key: values with smaller keys can no longer be enqueued
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+T& RadixHeapPriorityQueue<T,tkey,KEYOF>::peek () const {
+  if (empty())
+    throw EmptyError("RadixHeapPriorityQueue::peek");
+
+  pull();
+  return buckets[0]->value;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+std::string RadixHeapPriorityQueue<T,tkey,KEYOF>::str() const {
+  std::ostringstream answer;
+  answer << "RadixHeapPriorityQueue[";
+
+  for (int b = 0; b < bucket_count; ++b)
+    if (buckets[b] != nullptr) {
+      answer << std::endl << "  bucket[" << b << "]: ";
+      for (LN* p = buckets[b]; p != nullptr; p = p->next)
+        answer << p->value << "(" << p->key << ")" << (p->next == nullptr ? "" : ",");
+    }
+
+  answer << "](last=" << last << ",used=" << used << ",mod_count=" << mod_count << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+int RadixHeapPriorityQueue<T,tkey,KEYOF>::enqueue(const T& element) {
+  unsigned long long k = key_of(element);
+  if (k < last) {
+    std::ostringstream answer;
+    answer << "RadixHeapPriorityQueue::enqueue: key " << k << " < last dequeued key " << last;
+    throw KeyError(answer.str());
+  }
+
+  int b = bucket_of(k);
+  buckets[b] = new LN(element, k, buckets[b]);
+  ++used;
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+T RadixHeapPriorityQueue<T,tkey,KEYOF>::dequeue() {
+  if (this->empty())
+    throw EmptyError("RadixHeapPriorityQueue::dequeue");
+
+  pull();
+  LN* to_delete = buckets[0];
+  T to_return = to_delete->value;
+  buckets[0] = to_delete->next;
+  delete to_delete;
+  --used;
+  ++mod_count;
+  return to_return;
+}
+
+
+//Also resets last: any key can be enqueued
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+void RadixHeapPriorityQueue<T,tkey,KEYOF>::clear() {
+  delete_buckets();
+  last = 0;
+  used = 0;
+  ++mod_count;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+template <class Iterable>
+int RadixHeapPriorityQueue<T,tkey,KEYOF>::enqueue_all (const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+     count += enqueue(v);
+
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+RadixHeapPriorityQueue<T,tkey,KEYOF>& RadixHeapPriorityQueue<T,tkey,KEYOF>::operator = (const RadixHeapPriorityQueue<T,tkey,KEYOF>& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  delete_buckets();
+  key = rhs.key;   // if tkey != nullptr, keys are already equal (or compiler error)
+  copy(rhs);
+  ++mod_count;
+  return *this;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+bool RadixHeapPriorityQueue<T,tkey,KEYOF>::operator == (const RadixHeapPriorityQueue<T,tkey,KEYOF>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (key != rhs.key) //For PriorityQueues to be equal, they need the same key function, and values
+    return false;
+  if (used != rhs.size())
+    return false;
+  RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator l = this->begin(), r = rhs.begin();
+  for (int i=0; i<used; ++i, ++l, ++r)
+    if (*l != *r)
+      return false;
+
+  return true;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+bool RadixHeapPriorityQueue<T,tkey,KEYOF>::operator != (const RadixHeapPriorityQueue<T,tkey,KEYOF>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+std::ostream& operator << (std::ostream& outs, const RadixHeapPriorityQueue<T,tkey,KEYOF>& p) {
+  outs << "priority_queue[";
+
+  if (!p.empty()) {
+    ArrayStack<T> temp(p);
+    outs << temp.pop();
+    for (int i = 1; i < p.used; ++i)
+      outs << "," << temp.pop();
+  }
+
+  outs << "]:highest";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+auto RadixHeapPriorityQueue<T,tkey,KEYOF>::begin () const -> RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator {
+  return Iterator(const_cast<RadixHeapPriorityQueue<T,tkey,KEYOF>*>(this),true);
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+auto RadixHeapPriorityQueue<T,tkey,KEYOF>::end () const -> RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator {
+  return Iterator(const_cast<RadixHeapPriorityQueue<T,tkey,KEYOF>*>(this));  //Create empty pq (size == 0)
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+unsigned long long RadixHeapPriorityQueue<T,tkey,KEYOF>::key_of (const T& a) const {
+  return Functor<KEYOF>::call(tkey != nullptr ? tkey : key, a);
+}
+
+
+//1 + the index of the highest bit in which k and last differ (0 if equal)
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+int RadixHeapPriorityQueue<T,tkey,KEYOF>::bucket_of (unsigned long long k) const {
+  unsigned long long diff = k ^ last;
+  if (diff == 0)
+    return 0;
+#if defined(__GNUC__) || defined(__clang__)
+  return 64 - __builtin_clzll(diff);
+#else
+  int b = 0;
+  for (; diff != 0; diff >>= 1)
+    ++b;
+  return b;
+#endif
+}
+
+
+//Every key in bucket b > 0 shares last's bits above b-1 and has bit b-1 set,
+//  so after last becomes the smallest key in the lowest nonempty bucket, each of
+//  its values goes into a lower bucket (its smallest into bucket 0)
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+void RadixHeapPriorityQueue<T,tkey,KEYOF>::pull () const {
+  if (buckets[0] != nullptr)
+    return;
+
+  int b = 1;
+  while (buckets[b] == nullptr)
+    ++b;
+
+  unsigned long long smallest = buckets[b]->key;
+  for (LN* p = buckets[b]->next; p != nullptr; p = p->next)
+    if (p->key < smallest)
+      smallest = p->key;
+  last = smallest;
+
+  for (LN* p = buckets[b]; p != nullptr; /*see body*/) {
+    LN* to_move = p;
+    p = p->next;
+    int into = bucket_of(to_move->key);
+    to_move->next = buckets[into];
+    buckets[into] = to_move;
+  }
+  buckets[b] = nullptr;
+}
+
+
+//Preserves each value's bucket (and order in it), and last
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+void RadixHeapPriorityQueue<T,tkey,KEYOF>::copy (const RadixHeapPriorityQueue<T,tkey,KEYOF>& to_copy) {
+  last = to_copy.last;
+  used = to_copy.used;
+  for (int b = 0; b < bucket_count; ++b) {
+    LN** rear = &buckets[b];
+    for (LN* p = to_copy.buckets[b]; p != nullptr; p = p->next) {
+      *rear = new LN(p->value, p->key);
+      rear = &(*rear)->next;
+    }
+  }
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+bool RadixHeapPriorityQueue<T,tkey,KEYOF>::remove (const T& value) {
+  int b = bucket_of(key_of(value));
+  for (LN** p = &buckets[b]; *p != nullptr; p = &(*p)->next)
+    if ((*p)->value == value) {
+      LN* to_delete = *p;
+      *p = to_delete->next;
+      delete to_delete;
+      --used;
+      return true;
+    }
+  return false;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+void RadixHeapPriorityQueue<T,tkey,KEYOF>::delete_buckets () {
+  for (int b = 0; b < bucket_count; ++b)
+    for (LN* p = buckets[b]; p != nullptr; /*see body*/) {
+      LN* to_delete = p;
+      p = p->next;
+      delete to_delete;
+    }
+  for (int b = 0; b < bucket_count; ++b)
+    buckets[b] = nullptr;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator::Iterator(RadixHeapPriorityQueue<T,tkey,KEYOF>* iterate_over, bool from_begin)
+: it(*iterate_over,iterate_over->key), ref_pq(iterate_over), expected_mod_count(iterate_over->mod_count) {
+  // Full priority queue; use copy constructor
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator::Iterator(RadixHeapPriorityQueue<T,tkey,KEYOF>* iterate_over)
+: it(iterate_over->key), ref_pq(iterate_over), expected_mod_count(iterate_over->mod_count) {
+  // Empty priority queue; use default constructor (from declaration of "it")
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator::~Iterator()
+{}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+T RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator::erase() {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("RadixHeapPriorityQueue::Iterator::erase");
+  if (!can_erase)
+    throw CannotEraseError("RadixHeapPriorityQueue::Iterator::erase Iterator cursor already erased");
+  if (it.empty())
+    throw CannotEraseError("RadixHeapPriorityQueue::Iterator::erase Iterator cursor beyond data structure");
+
+  can_erase = false;
+  T to_return = it.dequeue();
+
+  //Remove value from it (heap iterating over) from the main heap: its key is at
+  //  least ref_pq's last (it started as a copy of ref_pq), so bucket_of finds it
+  ref_pq->remove(to_return);
+
+  expected_mod_count = ref_pq->mod_count;
+  return to_return;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+std::string RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator::str() const {
+  std::ostringstream answer;
+  answer << it.str() << "/expected_mod_count=" << expected_mod_count << "/can_erase=" << can_erase;
+  return answer.str();
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+auto RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator::operator ++ () -> RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator& {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("RadixHeapPriorityQueue::Iterator::operator ++");
+
+  if (it.empty())
+    return *this;
+
+  if (can_erase)
+    it.dequeue();
+  else
+    can_erase = true;
+
+  return *this;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+auto RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator::operator ++ (int) -> RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("RadixHeapPriorityQueue::Iterator::operator ++(int)");
+
+  if (it.empty())
+    return *this;
+
+  Iterator to_return(*this);
+  if (can_erase)
+    it.dequeue();
+  else
+    can_erase = true;
+
+  return to_return;
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+bool RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator::operator == (const RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("RadixHeapPriorityQueue::Iterator::operator ==");
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("RadixHeapPriorityQueue::Iterator::operator ==");
+  if (ref_pq != rhsASI->ref_pq)
+    throw ComparingDifferentIteratorsError("RadixHeapPriorityQueue::Iterator::operator ==");
+
+  //Two iterators on the same heap are equal if their sizes are equal
+  return this->it.size() == rhsASI->it.size();
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+bool RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator::operator != (const RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+T& RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator::operator *() const {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("RadixHeapPriorityQueue::Iterator::operator *");
+  if (!can_erase || it.empty())
+    throw IteratorPositionIllegal("RadixHeapPriorityQueue::Iterator::operator * Iterator illegal: exhausted");
+
+  return it.peek();
+}
+
+
+template<class T, unsigned long long (*tkey)(const T& a), class KEYOF>
+T* RadixHeapPriorityQueue<T,tkey,KEYOF>::Iterator::operator ->() const {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("RadixHeapPriorityQueue::Iterator::operator ->");
+  if (!can_erase || it.empty())
+    throw IteratorPositionIllegal("RadixHeapPriorityQueue::Iterator::operator -> Iterator illegal: exhausted");
+
+  return &it.peek();
+}
+
+}
+
+#endif /* RADIX_HEAP_PRIORITY_QUEUE_HPP_ */
@@ -0,0 +1,386 @@
+#ifndef RING_BUFFER_QUEUE_HPP_
+#define RING_BUFFER_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <atomic>
+#include <thread>
+#include <new>                  //For placement new
+#include <utility>              //For std::move
+#include "ics_exceptions.hpp"
+#include "array_queue.hpp"      //For dequeue_n results
+
+
+namespace ics {
+
+
+//A bounded FIFO queue, stored in a contiguous circular array (whose capacity is
+//  a power of 2), that threads can use to hand values to each other without
+//  locks and without allocating per value.
+//If spsc is true, at most one thread may enqueue and at most one (other) thread
+//  may dequeue at any time: each side owns one index, and reads the other's
+//  index only when its cached copy says the array is full (or empty).
+//If spsc is false, any number of threads may enqueue and dequeue (D. Vyukov's
+//  bounded MPMC queue): each cell stores a sequence number telling whether it
+//  is ready to be filled (== position) or emptied (== position+1) in the
+//  current lap; threads claim positions by compare_exchange on the shared index.
+//enqueue waits (yielding) while the queue is full; try_enqueue returns false
+//  instead. dequeue raises EmptyError if the queue is empty; try_dequeue
+//  returns false instead.
+//There is no peek, Iterator, copying or comparison: while other threads are
+//  enqueueing/dequeueing, no value is stable enough to refer to. size/empty
+//  are exact only when no other thread is using the queue.
+template<class T, bool spsc = false> class RingBufferQueue {
+  public:
+    //Destructor/Constructors
+    ~RingBufferQueue();
+
+    explicit RingBufferQueue (int capacity = 1024);   //capacity is rounded up to a power of 2 (at least 2 if mpmc)
+    RingBufferQueue          (const RingBufferQueue<T,spsc>& to_copy) = delete;
+    RingBufferQueue<T,spsc>& operator = (const RingBufferQueue<T,spsc>& rhs) = delete;
+
+
+    //Queries
+    bool empty      () const;
+    bool full       () const;
+    int  size       () const;
+    int  capacity   () const;
+    std::string str () const; //supplies useful debugging information (indexes only, not values)
+
+
+    //Commands
+    int  enqueue     (const T& element);
+    int  enqueue     (T&& element);
+    bool try_enqueue (const T& element);
+    bool try_enqueue (T&& element);
+    T    dequeue     ();
+    bool try_dequeue (T& into);
+    int  dequeue_n   (int k, ArrayQueue<T>& into); //Dequeue up to k values (as many as are there) into into; return #
+    void clear       ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    //Waits (like enqueue) for room for each value
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+
+    template<class T2, bool spsc2>
+    friend std::ostream& operator << (std::ostream& outs, const RingBufferQueue<T2,spsc2>& q);
+
+
+  private:
+    class Cell {
+      public:
+        std::atomic<unsigned long> sequence;   //Unused when spsc
+        alignas(T) unsigned char   storage[sizeof(T)];
+
+        T* value () {return reinterpret_cast<T*>(storage);}
+    };
+
+    //Keep the indexes on different cache lines; alignas(line) also rounds sizeof
+    //  up to a multiple of line, so nothing after the queue shares front's line
+    static const int line = 64;
+
+    Cell*         cells;
+    unsigned long mask;                     //capacity-1: position & mask is its cell
+    alignas(line) std::atomic<unsigned long> rear{0};   //Next position to enqueue at
+    unsigned long cached_front = 0;                     //spsc: enqueuer's copy of front
+    alignas(line) std::atomic<unsigned long> front{0};  //Next position to dequeue from
+    unsigned long cached_rear  = 0;                     //spsc: dequeuer's copy of rear
+
+
+    //Helper methods
+    template<class U> bool add      (U&& element);      //try_enqueue with U (T& or T) forwarded
+    Cell*                  claim    ();                 //Claim a filled cell to empty (or nullptr); call release next
+    void                   release  (Cell* c);          //Destroy c's (moved from) value, and release c for enqueueing
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//RingBufferQueue class and related definitions
+
+//Destructor/Constructors
+
+//No other thread may be using the queue when it is destroyed
+template<class T, bool spsc>
+RingBufferQueue<T,spsc>::~RingBufferQueue() {
+  for (unsigned long p = front.load(); p != rear.load(); ++p)
+    cells[p & mask].value()->~T();
+  delete[] cells;
+}
+
+
+template<class T, bool spsc>
+RingBufferQueue<T,spsc>::RingBufferQueue(int capacity) {
+  if (capacity <= 0)
+    throw IcsError("RingBufferQueue::constructor: capacity(" + std::to_string(capacity) + ") must be > 0");
+
+  //An mpmc cell's sequence tells its lap only if there are at least 2 cells
+  unsigned long length = spsc ? 1 : 2;
+  while (length < static_cast<unsigned long>(capacity))
+    length <<= 1;
+  mask  = length-1;
+  cells = new Cell[length];
+  for (unsigned long i=0; i<length; ++i)
+    cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, bool spsc>
+bool RingBufferQueue<T,spsc>::empty() const {
+  return size() == 0;
+}
+
+
+template<class T, bool spsc>
+bool RingBufferQueue<T,spsc>::full() const {
+  return size() == capacity();
+}
+
+
+//Read front first: rear (read later) is at least as large, so size >= 0
+template<class T, bool spsc>
+int RingBufferQueue<T,spsc>::size() const {
+  unsigned long f = front.load(std::memory_order_acquire);
+  unsigned long r = rear.load(std::memory_order_acquire);
+  return r - f > mask+1 ? mask+1 : r - f;
+}
+
+
+template<class T, bool spsc>
+int RingBufferQueue<T,spsc>::capacity() const {
+  return mask+1;
+}
+
+
+template<class T, bool spsc>
+std::string RingBufferQueue<T,spsc>::str() const {
+  std::ostringstream answer;
+  answer << "RingBufferQueue[" << (spsc ? "spsc" : "mpmc") << "](capacity=" << capacity()
+         << ",front=" << front.load() << ",rear=" << rear.load() << ",size=" << size() << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, bool spsc>
+int RingBufferQueue<T,spsc>::enqueue(const T& element) {
+  while (!add(element))
+    std::this_thread::yield();
+  return 1;
+}
+
+
+template<class T, bool spsc>
+int RingBufferQueue<T,spsc>::enqueue(T&& element) {
+  while (!add(std::move(element)))
+    std::this_thread::yield();
+  return 1;
+}
+
+
+template<class T, bool spsc>
+bool RingBufferQueue<T,spsc>::try_enqueue(const T& element) {
+  return add(element);
+}
+
+
+template<class T, bool spsc>
+bool RingBufferQueue<T,spsc>::try_enqueue(T&& element) {
+  return add(std::move(element));
+}
+
+
+template<class T, bool spsc>
+T RingBufferQueue<T,spsc>::dequeue() {
+  Cell* c = claim();
+  if (c == nullptr)
+    throw EmptyError("RingBufferQueue::dequeue");
+
+  T to_return(std::move(*c->value()));
+  release(c);
+  return to_return;
+}
+
+
+template<class T, bool spsc>
+bool RingBufferQueue<T,spsc>::try_dequeue(T& into) {
+  Cell* c = claim();
+  if (c == nullptr)
+    return false;
+
+  into = std::move(*c->value());
+  release(c);
+  return true;
+}
+
+
+//spsc: learn rear once, move out every value up to it (or k), then publish
+//  front once; mpmc: claim cells one at a time
+template<class T, bool spsc>
+int RingBufferQueue<T,spsc>::dequeue_n(int k, ArrayQueue<T>& into) {
+  int count = 0;
+  if (spsc) {
+    unsigned long f = front.load(std::memory_order_relaxed);
+    if (cached_rear - f < static_cast<unsigned long>(k))
+      cached_rear = rear.load(std::memory_order_acquire);
+    for (; count < k && f != cached_rear; ++count, ++f) {
+      T* v = cells[f & mask].value();
+      into.enqueue(std::move(*v));
+      v->~T();
+    }
+    front.store(f, std::memory_order_release);
+  }
+  else
+    for (Cell* c; count < k && (c = claim()) != nullptr; ++count) {
+      into.enqueue(std::move(*c->value()));
+      release(c);
+    }
+
+  return count;
+}
+
+
+//Dequeues values until (at some moment) the queue is empty
+template<class T, bool spsc>
+void RingBufferQueue<T,spsc>::clear() {
+  for (Cell* c; (c = claim()) != nullptr; /*see body*/)
+    release(c);
+}
+
+
+//spsc: fill free cells, publishing rear only when out of known-free cells
+//  (and at the end); mpmc: enqueue one at a time
+template<class T, bool spsc>
+template<class Iterable>
+int RingBufferQueue<T,spsc>::enqueue_all(const Iterable& i) {
+  int count = 0;
+  if (spsc) {
+    unsigned long r = rear.load(std::memory_order_relaxed);
+    for (const T& v : i) {
+      while (r - cached_front > mask) {
+        rear.store(r, std::memory_order_release);
+        cached_front = front.load(std::memory_order_acquire);
+        if (r - cached_front > mask)
+          std::this_thread::yield();
+      }
+      new (cells[r & mask].value()) T(v);
+      ++r, ++count;
+    }
+    rear.store(r, std::memory_order_release);
+  }
+  else
+    for (const T& v : i)
+      count += enqueue(v);
+
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+//Prints only the queue's description: see str
+template<class T, bool spsc>
+std::ostream& operator << (std::ostream& outs, const RingBufferQueue<T,spsc>& q) {
+  outs << "ring_buffer_queue[size=" << q.size() << "]";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+//The dequeuer (spsc) or the thread that moved sequence to position+1 (mpmc)
+//  owns a cell until it updates front (spsc) or sequence (mpmc) with release,
+//  which publishes the constructed/destroyed value to the other side
+template<class T, bool spsc>
+template<class U>
+bool RingBufferQueue<T,spsc>::add(U&& element) {
+  if (spsc) {
+    unsigned long r = rear.load(std::memory_order_relaxed);
+    if (r - cached_front > mask) {
+      cached_front = front.load(std::memory_order_acquire);
+      if (r - cached_front > mask)
+        return false;
+    }
+    new (cells[r & mask].value()) T(std::forward<U>(element));
+    rear.store(r+1, std::memory_order_release);
+    return true;
+  }
+
+  unsigned long r = rear.load(std::memory_order_relaxed);
+  for (;;) {
+    Cell& c = cells[r & mask];
+    long difference = static_cast<long>(c.sequence.load(std::memory_order_acquire) - r);
+    if (difference == 0) {
+      if (rear.compare_exchange_weak(r, r+1, std::memory_order_relaxed)) {
+        new (c.value()) T(std::forward<U>(element));
+        c.sequence.store(r+1, std::memory_order_release);
+        return true;
+      }
+    }
+    else if (difference < 0)   //Cell not yet emptied from the previous lap: full
+      return false;
+    else                       //Another enqueuer claimed position r: retry at the latest
+      r = rear.load(std::memory_order_relaxed);
+  }
+}
+
+
+template<class T, bool spsc>
+auto RingBufferQueue<T,spsc>::claim() -> Cell* {
+  if (spsc) {
+    unsigned long f = front.load(std::memory_order_relaxed);
+    if (f == cached_rear) {
+      cached_rear = rear.load(std::memory_order_acquire);
+      if (f == cached_rear)
+        return nullptr;
+    }
+    return &cells[f & mask];
+  }
+
+  unsigned long f = front.load(std::memory_order_relaxed);
+  for (;;) {
+    Cell& c = cells[f & mask];
+    long difference = static_cast<long>(c.sequence.load(std::memory_order_acquire) - (f+1));
+    if (difference == 0) {
+      if (front.compare_exchange_weak(f, f+1, std::memory_order_relaxed))
+        return &c;
+    }
+    else if (difference < 0)   //Cell not yet filled in this lap: empty
+      return nullptr;
+    else                       //Another dequeuer claimed position f: retry at the latest
+      f = front.load(std::memory_order_relaxed);
+  }
+}
+
+
+//The mpmc cell for position p is ready for position p+capacity once its
+//  sequence is p+capacity (it is p+1 now)
+template<class T, bool spsc>
+void RingBufferQueue<T,spsc>::release(Cell* c) {
+  c->value()->~T();
+  if (spsc)
+    front.store(front.load(std::memory_order_relaxed)+1, std::memory_order_release);
+  else
+    c->sequence.store(c->sequence.load(std::memory_order_relaxed) + mask, std::memory_order_release);
+}
+
+}
+
+#endif /* RING_BUFFER_QUEUE_HPP_ */
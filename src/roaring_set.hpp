@@ -0,0 +1,1211 @@
+#ifndef ROARING_SET_HPP_
+#define ROARING_SET_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <vector>
+#include <algorithm>            //For std::lower_bound/std::upper_bound/std::set_union
+#include <cstdint>              //For std::uint16_t/std::uint32_t/std::uint64_t
+#include <type_traits>          //For std::is_integral/std::is_signed
+#include "ics_exceptions.hpp"
+
+
+namespace ics {
+
+
+//A set of integers (any integral T of at most 32 bits) stored as a compressed
+//  ("roaring") bitmap: each value is split into a 16-bit key (its high bits)
+//  and a 16-bit low part, and the low parts of the values sharing a key are
+//  stored in one container, in whichever of three forms is smallest:
+//    ARRAY:  a sorted array of low parts (2 bytes per value; at most 4096 values)
+//    BITMAP: 65536 bits (8KB: smaller than an ARRAY beyond 4096 values)
+//    RUN:    sorted runs of consecutive low parts (4 bytes per run)
+//  Containers are kept sorted by key, so lookups are a binary search over the
+//  containers then one within the container.
+//Inserting/erasing switches a container between ARRAY and BITMAP as its size
+//  crosses 4096; insert_range creates RUN containers, and optimize converts
+//  every container whose runs are smaller than its current form to RUN.
+//Union, intersection, difference and subset tests work container by container:
+//  BITMAP containers are combined a 64-bit word at a time (simple loops over
+//  1024 words that the compiler can vectorize), and ARRAY containers by probing
+//  or merging.
+//Values are iterated in increasing order.
+template<class T = int> class RoaringSet {
+  static_assert(std::is_integral<T>::value && sizeof(T) <= 4, "RoaringSet: T must be an integral type of at most 32 bits");
+
+  public:
+    //Destructor/Constructors
+    ~RoaringSet();
+
+    RoaringSet          ();
+    RoaringSet          (const RoaringSet<T>& to_copy);
+    explicit RoaringSet (const std::initializer_list<T>& il);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit RoaringSet (const Iterable& i);
+
+
+    //Queries
+    bool empty      () const;
+    long long size  () const;  //Up to 2^32 values: more than an int can count
+    bool contains   (const T& element) const;
+    long bytes      () const; //bytes storing the containers (not counting std::vector overhead)
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    bool contains_all (const Iterable& i) const;
+
+
+    //Commands
+    int  insert       (const T& element);
+    long long insert_range (const T& first, const T& last);  //Insert first..last (inclusive); return # inserted
+    int  erase        (const T& element);
+    void clear        ();
+    int  optimize     ();                                //Use RUN containers where smaller; return # RUN containers
+
+    //Iterable class must support "for" loop: .begin()/.end() and prefix ++ on returned result
+
+    template <class Iterable>
+    long long insert_all(const Iterable& i);
+
+    template <class Iterable>
+    long long erase_all(const Iterable& i);
+
+    template<class Iterable>
+    long long retain_all(const Iterable& i);  //Returns # erased
+
+
+    //Operators
+    RoaringSet<T>& operator = (const RoaringSet<T>& rhs);
+    RoaringSet<T>  operator | (const RoaringSet<T>& rhs) const;  //union
+    RoaringSet<T>  operator & (const RoaringSet<T>& rhs) const;  //intersection
+    RoaringSet<T>  operator - (const RoaringSet<T>& rhs) const;  //difference
+    bool operator == (const RoaringSet<T>& rhs) const;
+    bool operator != (const RoaringSet<T>& rhs) const;
+    bool operator <= (const RoaringSet<T>& rhs) const;
+    bool operator <  (const RoaringSet<T>& rhs) const;
+    bool operator >= (const RoaringSet<T>& rhs) const;
+    bool operator >  (const RoaringSet<T>& rhs) const;
+
+    template<class T2>
+    friend std::ostream& operator << (std::ostream& outs, const RoaringSet<T2>& s);
+
+
+
+  public:
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of RoaringSet<T>
+        ~Iterator();
+        T           erase();
+        std::string str  () const;
+        RoaringSet<T>::Iterator& operator ++ ();
+        RoaringSet<T>::Iterator  operator ++ (int);
+        bool operator == (const RoaringSet<T>::Iterator& rhs) const;
+        bool operator != (const RoaringSet<T>::Iterator& rhs) const;
+        const T& operator *  () const;   //Values cannot be changed in place
+        const T* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const RoaringSet<T>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+        friend Iterator RoaringSet<T>::begin () const;
+        friend Iterator RoaringSet<T>::end   () const;
+
+      private:
+        //If can_erase is false, current is the "next" value (must ++ to reach it)
+        std::uint32_t  current;      //bits (see to_bits) of the current value; unusable if at_end
+        T              value;        //The current value (referred to by operator *)
+        bool           at_end;
+        RoaringSet<T>* ref_set;
+        int            expected_mod_count;
+        bool           can_erase = true;
+
+        //Helper methods
+        void move_to(std::uint32_t from);  //Move to the smallest value whose bits >= from (or to the end)
+
+        //Called in friends begin/end
+        Iterator(RoaringSet<T>* iterate_over, bool from_begin);
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+    class Run {
+      public:
+        Run ()                                    : start(0), length(0) {}
+        Run (std::uint16_t s, std::uint16_t l)    : start(s), length(l) {}
+
+        std::uint16_t start;
+        std::uint16_t length;          //Run is start..start+length (so length is 1 less than its size)
+    };
+
+    class Container {
+      public:
+        enum Kind {ARRAY, BITMAP, RUN};
+        static const int array_max = 4096;   //An ARRAY with more values becomes a BITMAP
+        static const int words     = 1024;   //64-bit words in a BITMAP (65536 bits)
+
+        Container (std::uint16_t k = 0) : key(k) {}
+
+        std::uint16_t              key;
+        Kind                       kind        = ARRAY;
+        int                        cardinality = 0;
+        std::vector<std::uint16_t> array;    //ARRAY: the values, increasing
+        std::vector<std::uint64_t> bitmap;   //BITMAP: bit low of word low/64 is set iff low is in the container
+        std::vector<Run>           runs;     //RUN: disjoint, non-adjacent runs, increasing
+
+        bool contains  (std::uint16_t low) const;
+        bool add       (std::uint16_t low);
+        bool remove    (std::uint16_t low);
+        bool next      (int from, std::uint16_t& into) const;  //Smallest low >= from, if any
+        long bytes     () const;
+        int  count_runs() const;
+        bool subset_of (const Container& rhs) const;
+
+        //Call visit(low) for each value, increasing, while it returns true; return false if stopped
+        template<class Visit>
+        bool for_each  (Visit visit) const;
+
+        void to_array  ();
+        void to_bitmap ();
+        void to_runs   ();
+        void shrink    ();                   //After changes: use ARRAY/BITMAP by size, unless RUN is smaller
+    };
+
+
+    std::vector<Container> chunks;      //Sorted by key; no empty containers
+    long long used = 0;                 //Cache for number of values in all containers
+    int mod_count = 0;                  //For sensing concurrent modification
+
+    //Helper methods
+    static std::uint32_t to_bits   (const T& element);  //Increasing bits for increasing values
+    static T             from_bits (std::uint32_t bits);
+    static int           popcount  (std::uint64_t word);
+    static int           lowest_bit(std::uint64_t word); //word != 0
+    static void          set_range (std::vector<std::uint64_t>& bitmap, int first, int last);
+
+    //The bitmap of c: c's own if a BITMAP, otherwise filled into scratch
+    static const std::vector<std::uint64_t>& bitmap_of (const Container& c, std::vector<std::uint64_t>& scratch);
+    static Container unite     (const Container& a, const Container& b);
+    static Container intersect (const Container& a, const Container& b);
+    static Container subtract  (const Container& a, const Container& b);
+
+    int  chunk_index (std::uint16_t key) const;           //Index of first container with key >= key
+    bool next_bits   (std::uint32_t from, std::uint32_t& into) const;  //Smallest value's bits >= from, if any
+    bool subset_of   (const RoaringSet<T>& rhs) const;
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//RoaringSet class and related definitions
+
+//Destructor/Constructors
+
+template<class T>
+RoaringSet<T>::~RoaringSet()
+{}
+
+
+template<class T>
+RoaringSet<T>::RoaringSet()
+{}
+
+
+template<class T>
+RoaringSet<T>::RoaringSet(const RoaringSet<T>& to_copy)
+: chunks(to_copy.chunks), used(to_copy.used)
+{}
+
+
+template<class T>
+RoaringSet<T>::RoaringSet(const std::initializer_list<T>& il) {
+  for (const T& v : il)
+    insert(v);
+}
+
+
+template<class T>
+template<class Iterable>
+RoaringSet<T>::RoaringSet(const Iterable& i) {
+  for (const T& v : i)
+    insert(v);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T>
+bool RoaringSet<T>::empty() const {
+  return used == 0;
+}
+
+
+template<class T>
+long long RoaringSet<T>::size() const {
+  return used;
+}
+
+
+template<class T>
+bool RoaringSet<T>::contains (const T& element) const {
+  std::uint32_t bits = to_bits(element);
+  int c = chunk_index(bits >> 16);
+  return c != int(chunks.size()) && chunks[c].key == (bits >> 16) && chunks[c].contains(bits & 0xFFFF);
+}
+
+
+template<class T>
+long RoaringSet<T>::bytes () const {
+  long answer = 0;
+  for (const Container& c : chunks)
+    answer += sizeof(Container) + c.bytes();
+  return answer;
+}
+
+
+template<class T>
+std::string RoaringSet<T>::str() const {
+  static const char* kinds[] = {"ARRAY","BITMAP","RUN"};
+  std::ostringstream answer;
+  answer << "roaring_set[";
+  for (int c=0; c<int(chunks.size()); ++c)
+    answer << (c == 0 ? "" : ",") << chunks[c].key << ":" << kinds[chunks[c].kind] << "(" << chunks[c].cardinality << ")";
+  answer << "](used=" << used << ",bytes=" << bytes() << ",mod_count=" << mod_count << ")";
+  return answer.str();
+}
+
+
+template<class T>
+template<class Iterable>
+bool RoaringSet<T>::contains_all (const Iterable& i) const {
+  for (const T& v : i)
+    if (!contains(v))
+      return false;
+
+  return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T>
+int RoaringSet<T>::insert(const T& element) {
+  std::uint32_t bits = to_bits(element);
+  std::uint16_t key  = bits >> 16;
+  int c = chunk_index(key);
+  if (c == int(chunks.size()) || chunks[c].key != key)
+    chunks.insert(chunks.begin()+c, Container(key));
+  if (!chunks[c].add(bits & 0xFFFF))
+    return 0;
+
+  ++used;
+  ++mod_count;
+  return 1;
+}
+
+
+//A new container is a single RUN; an existing one is filled as a BITMAP, then
+//  converted to RUN (if smaller) or shrunk
+template<class T>
+long long RoaringSet<T>::insert_range(const T& first, const T& last) {
+  std::uint32_t from = to_bits(first), to = to_bits(last);
+  if (from > to)
+    return 0;
+
+  long long count = 0;
+  for (std::uint32_t key = from >> 16; key <= (to >> 16); ++key) {
+    int lo = (key == (from >> 16) ? from & 0xFFFF : 0);
+    int hi = (key == (to   >> 16) ? to   & 0xFFFF : 0xFFFF);
+    int c  = chunk_index(key);
+    if (c == int(chunks.size()) || chunks[c].key != key) {
+      Container range(key);
+      range.kind        = Container::RUN;
+      range.cardinality = hi-lo+1;
+      range.runs.push_back(Run(lo,hi-lo));
+      chunks.insert(chunks.begin()+c, range);
+      count += hi-lo+1;
+      continue;
+    }
+
+    Container& r = chunks[c];
+    int before = r.cardinality;
+    r.to_bitmap();
+    set_range(r.bitmap, lo, hi);
+    r.cardinality = 0;
+    for (std::uint64_t w : r.bitmap)
+      r.cardinality += popcount(w);
+    if (4L*r.count_runs() < r.bytes())
+      r.to_runs();
+    else
+      r.shrink();
+    count += r.cardinality - before;
+  }
+
+  used += count;
+  if (count != 0)
+    ++mod_count;
+  return count;
+}
+
+
+template<class T>
+int RoaringSet<T>::erase(const T& element) {
+  std::uint32_t bits = to_bits(element);
+  int c = chunk_index(bits >> 16);
+  if (c == int(chunks.size()) || chunks[c].key != (bits >> 16) || !chunks[c].remove(bits & 0xFFFF))
+    return 0;
+
+  if (chunks[c].cardinality == 0)
+    chunks.erase(chunks.begin()+c);
+  --used;
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T>
+void RoaringSet<T>::clear() {
+  chunks.clear();
+  used = 0;
+  ++mod_count;
+}
+
+
+template<class T>
+int RoaringSet<T>::optimize() {
+  int count = 0;
+  for (Container& c : chunks) {
+    if (c.kind != Container::RUN && 4L*c.count_runs() < c.bytes())
+      c.to_runs();
+    else
+      c.shrink();
+    count += c.kind == Container::RUN;
+  }
+
+  ++mod_count;
+  return count;
+}
+
+
+template<class T>
+template<class Iterable>
+long long RoaringSet<T>::insert_all(const Iterable& i) {
+  long long count = 0;
+  for (const T& v : i)
+    count += insert(v);
+
+  return count;
+}
+
+
+template<class T>
+template<class Iterable>
+long long RoaringSet<T>::erase_all(const Iterable& i) {
+  long long count = 0;
+  for (const T& v : i)
+    count += erase(v);
+
+  return count;
+}
+
+
+//The kept values are collected into a (compact) RoaringSet, which replaces this one
+template<class T>
+template<class Iterable>
+long long RoaringSet<T>::retain_all(const Iterable& i) {
+  RoaringSet<T> keep;
+  for (const T& v : i)
+    if (contains(v))
+      keep.insert(v);
+
+  long long count = used - keep.used;
+  chunks.swap(keep.chunks);
+  used = keep.used;
+  ++mod_count;
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T>
+RoaringSet<T>& RoaringSet<T>::operator = (const RoaringSet<T>& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  chunks = rhs.chunks;
+  used   = rhs.used;
+  ++mod_count;
+  return *this;
+}
+
+
+template<class T>
+RoaringSet<T> RoaringSet<T>::operator | (const RoaringSet<T>& rhs) const {
+  RoaringSet<T> answer;
+  int i = 0, j = 0;
+  while (i < int(chunks.size()) || j < int(rhs.chunks.size())) {
+    if (j == int(rhs.chunks.size()) || (i < int(chunks.size()) && chunks[i].key < rhs.chunks[j].key))
+      answer.chunks.push_back(chunks[i++]);
+    else if (i == int(chunks.size()) || rhs.chunks[j].key < chunks[i].key)
+      answer.chunks.push_back(rhs.chunks[j++]);
+    else
+      answer.chunks.push_back(unite(chunks[i++], rhs.chunks[j++]));
+    answer.used += answer.chunks.back().cardinality;
+  }
+
+  return answer;
+}
+
+
+template<class T>
+RoaringSet<T> RoaringSet<T>::operator & (const RoaringSet<T>& rhs) const {
+  RoaringSet<T> answer;
+  for (int i = 0, j = 0; i < int(chunks.size()) && j < int(rhs.chunks.size()); /*See body*/)
+    if (chunks[i].key < rhs.chunks[j].key)
+      ++i;
+    else if (rhs.chunks[j].key < chunks[i].key)
+      ++j;
+    else {
+      Container c = intersect(chunks[i++], rhs.chunks[j++]);
+      if (c.cardinality != 0) {
+        answer.used += c.cardinality;
+        answer.chunks.push_back(c);
+      }
+    }
+
+  return answer;
+}
+
+
+template<class T>
+RoaringSet<T> RoaringSet<T>::operator - (const RoaringSet<T>& rhs) const {
+  RoaringSet<T> answer;
+  int j = 0;
+  for (const Container& a : chunks) {
+    while (j < int(rhs.chunks.size()) && rhs.chunks[j].key < a.key)
+      ++j;
+    if (j == int(rhs.chunks.size()) || rhs.chunks[j].key != a.key) {
+      answer.used += a.cardinality;
+      answer.chunks.push_back(a);
+      continue;
+    }
+
+    Container c = subtract(a, rhs.chunks[j]);
+    if (c.cardinality != 0) {
+      answer.used += c.cardinality;
+      answer.chunks.push_back(c);
+    }
+  }
+
+  return answer;
+}
+
+
+template<class T>
+bool RoaringSet<T>::operator == (const RoaringSet<T>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (used != rhs.size() || chunks.size() != rhs.chunks.size())
+    return false;
+
+  return subset_of(rhs);
+}
+
+
+template<class T>
+bool RoaringSet<T>::operator != (const RoaringSet<T>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T>
+bool RoaringSet<T>::operator <= (const RoaringSet<T>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (used > rhs.size())
+    return false;
+
+  return subset_of(rhs);
+}
+
+
+template<class T>
+bool RoaringSet<T>::operator < (const RoaringSet<T>& rhs) const {
+  if (this == &rhs)
+    return false;
+  if (used >= rhs.size())
+    return false;
+
+  return subset_of(rhs);
+}
+
+
+template<class T>
+bool RoaringSet<T>::operator >= (const RoaringSet<T>& rhs) const {
+  return rhs <= *this;
+}
+
+
+template<class T>
+bool RoaringSet<T>::operator > (const RoaringSet<T>& rhs) const {
+  return rhs < *this;
+}
+
+
+template<class T>
+std::ostream& operator << (std::ostream& outs, const RoaringSet<T>& s) {
+  outs << "set[";
+
+  int printed = 0;
+  for (const T& v : s)
+    outs << (printed++ == 0 ? "" : ",") << v;
+
+  outs << "]";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class T>
+auto RoaringSet<T>::begin () const -> RoaringSet<T>::Iterator {
+  return Iterator(const_cast<RoaringSet<T>*>(this),true);
+}
+
+
+template<class T>
+auto RoaringSet<T>::end () const -> RoaringSet<T>::Iterator {
+  return Iterator(const_cast<RoaringSet<T>*>(this),false);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+//Flipping the sign bit of a signed value's (sign extended) bits orders
+//  negative values before non-negative ones
+template<class T>
+std::uint32_t RoaringSet<T>::to_bits(const T& element) {
+  return static_cast<std::uint32_t>(element) ^ (std::is_signed<T>::value ? 0x80000000u : 0u);
+}
+
+
+template<class T>
+T RoaringSet<T>::from_bits(std::uint32_t bits) {
+  return static_cast<T>(bits ^ (std::is_signed<T>::value ? 0x80000000u : 0u));
+}
+
+
+template<class T>
+int RoaringSet<T>::popcount(std::uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(word);
+#else
+  int count = 0;
+  for (; word != 0; word &= word-1)
+    ++count;
+  return count;
+#endif
+}
+
+
+template<class T>
+int RoaringSet<T>::lowest_bit(std::uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(word);
+#else
+  int b = 0;
+  for (; (word & 1) == 0; word >>= 1)
+    ++b;
+  return b;
+#endif
+}
+
+
+template<class T>
+void RoaringSet<T>::set_range(std::vector<std::uint64_t>& bitmap, int first, int last) {
+  for (int w = first >> 6; w <= (last >> 6); ++w) {
+    int lo = (w == (first >> 6) ? first & 63 : 0);
+    int hi = (w == (last  >> 6) ? last  & 63 : 63);
+    bitmap[w] |= (hi-lo == 63 ? ~std::uint64_t(0) : ((std::uint64_t(1) << (hi-lo+1)) - 1) << lo);
+  }
+}
+
+
+template<class T>
+const std::vector<std::uint64_t>& RoaringSet<T>::bitmap_of(const Container& c, std::vector<std::uint64_t>& scratch) {
+  if (c.kind == Container::BITMAP)
+    return c.bitmap;
+
+  scratch.assign(Container::words, 0);
+  if (c.kind == Container::RUN)
+    for (const Run& r : c.runs)
+      set_range(scratch, r.start, r.start+r.length);
+  else
+    for (std::uint16_t low : c.array)
+      scratch[low >> 6] |= std::uint64_t(1) << (low & 63);
+  return scratch;
+}
+
+
+//Merge two ARRAYs if the result fits in an ARRAY; otherwise OR bitmaps
+template<class T>
+auto RoaringSet<T>::unite(const Container& a, const Container& b) -> Container {
+  Container answer(a.key);
+  if (a.kind == Container::ARRAY && b.kind == Container::ARRAY && a.cardinality+b.cardinality <= Container::array_max) {
+    answer.array.resize(a.cardinality+b.cardinality);
+    answer.array.resize(std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), answer.array.begin()) - answer.array.begin());
+    answer.cardinality = answer.array.size();
+    return answer;
+  }
+
+  std::vector<std::uint64_t> scratch_a, scratch_b;
+  const std::vector<std::uint64_t>& wa = bitmap_of(a, scratch_a);
+  const std::vector<std::uint64_t>& wb = bitmap_of(b, scratch_b);
+  answer.kind = Container::BITMAP;
+  answer.bitmap.resize(Container::words);
+  for (int w=0; w<Container::words; ++w)
+    answer.bitmap[w] = wa[w] | wb[w];
+  for (int w=0; w<Container::words; ++w)
+    answer.cardinality += popcount(answer.bitmap[w]);
+  answer.shrink();
+  return answer;
+}
+
+
+//Probe an ARRAY's values in the other container; otherwise AND bitmaps
+template<class T>
+auto RoaringSet<T>::intersect(const Container& a, const Container& b) -> Container {
+  Container answer(a.key);
+  if (a.kind == Container::ARRAY || b.kind == Container::ARRAY) {
+    const Container& probe = (a.kind == Container::ARRAY && (b.kind != Container::ARRAY || a.cardinality <= b.cardinality) ? a : b);
+    const Container& other = (&probe == &a ? b : a);
+    for (std::uint16_t low : probe.array)
+      if (other.contains(low))
+        answer.array.push_back(low);
+    answer.cardinality = answer.array.size();
+    return answer;
+  }
+
+  std::vector<std::uint64_t> scratch_a, scratch_b;
+  const std::vector<std::uint64_t>& wa = bitmap_of(a, scratch_a);
+  const std::vector<std::uint64_t>& wb = bitmap_of(b, scratch_b);
+  answer.kind = Container::BITMAP;
+  answer.bitmap.resize(Container::words);
+  for (int w=0; w<Container::words; ++w)
+    answer.bitmap[w] = wa[w] & wb[w];
+  for (int w=0; w<Container::words; ++w)
+    answer.cardinality += popcount(answer.bitmap[w]);
+  answer.shrink();
+  return answer;
+}
+
+
+//Filter an ARRAY by the other container; otherwise AND with the complement
+template<class T>
+auto RoaringSet<T>::subtract(const Container& a, const Container& b) -> Container {
+  Container answer(a.key);
+  if (a.kind == Container::ARRAY) {
+    for (std::uint16_t low : a.array)
+      if (!b.contains(low))
+        answer.array.push_back(low);
+    answer.cardinality = answer.array.size();
+    return answer;
+  }
+
+  std::vector<std::uint64_t> scratch_a, scratch_b;
+  const std::vector<std::uint64_t>& wa = bitmap_of(a, scratch_a);
+  const std::vector<std::uint64_t>& wb = bitmap_of(b, scratch_b);
+  answer.kind = Container::BITMAP;
+  answer.bitmap.resize(Container::words);
+  for (int w=0; w<Container::words; ++w)
+    answer.bitmap[w] = wa[w] & ~wb[w];
+  for (int w=0; w<Container::words; ++w)
+    answer.cardinality += popcount(answer.bitmap[w]);
+  answer.shrink();
+  return answer;
+}
+
+
+template<class T>
+int RoaringSet<T>::chunk_index(std::uint16_t key) const {
+  return std::lower_bound(chunks.begin(), chunks.end(), key,
+                          [](const Container& c, std::uint16_t k) {return c.key < k;}) - chunks.begin();
+}
+
+
+template<class T>
+bool RoaringSet<T>::next_bits(std::uint32_t from, std::uint32_t& into) const {
+  std::uint16_t key = from >> 16;
+  for (int c = chunk_index(key); c < int(chunks.size()); ++c) {
+    std::uint16_t low;
+    if (chunks[c].next(chunks[c].key == key ? from & 0xFFFF : 0, low)) {
+      into = (std::uint32_t(chunks[c].key) << 16) | low;
+      return true;
+    }
+  }
+  return false;
+}
+
+
+template<class T>
+bool RoaringSet<T>::subset_of(const RoaringSet<T>& rhs) const {
+  int j = 0;
+  for (const Container& a : chunks) {
+    while (j < int(rhs.chunks.size()) && rhs.chunks[j].key < a.key)
+      ++j;
+    if (j == int(rhs.chunks.size()) || rhs.chunks[j].key != a.key || !a.subset_of(rhs.chunks[j]))
+      return false;
+  }
+  return true;
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Container class definitions
+
+template<class T>
+bool RoaringSet<T>::Container::contains(std::uint16_t low) const {
+  switch (kind) {
+    case ARRAY:
+      return std::binary_search(array.begin(), array.end(), low);
+    case BITMAP:
+      return (bitmap[low >> 6] >> (low & 63)) & 1;
+    default: {
+      auto after = std::upper_bound(runs.begin(), runs.end(), low, [](std::uint16_t v, const Run& r) {return v < r.start;});
+      return after != runs.begin() && low <= (after-1)->start + (after-1)->length;
+    }
+  }
+}
+
+
+template<class T>
+bool RoaringSet<T>::Container::add(std::uint16_t low) {
+  if (kind == ARRAY) {
+    auto at = std::lower_bound(array.begin(), array.end(), low);
+    if (at != array.end() && *at == low)
+      return false;
+    if (cardinality < array_max) {
+      array.insert(at, low);
+      ++cardinality;
+      return true;
+    }
+    to_bitmap();
+  }
+
+  if (kind == BITMAP) {
+    std::uint64_t bit = std::uint64_t(1) << (low & 63);
+    if (bitmap[low >> 6] & bit)
+      return false;
+    bitmap[low >> 6] |= bit;
+    ++cardinality;
+    return true;
+  }
+
+  //RUN: extend the run before and/or after low, or start a new run
+  auto after = std::upper_bound(runs.begin(), runs.end(), low, [](std::uint16_t v, const Run& r) {return v < r.start;});
+  bool joins_before = after != runs.begin() && (after-1)->start + (after-1)->length + 1 >= low;
+  if (after != runs.begin() && low <= (after-1)->start + (after-1)->length)
+    return false;
+  bool joins_after  = after != runs.end() && low + 1 == after->start;
+
+  if (joins_before && joins_after) {
+    (after-1)->length += after->length + 2;
+    runs.erase(after);
+  }else if (joins_before)
+    ++(after-1)->length;
+  else if (joins_after) {
+    after->start = low;
+    ++after->length;
+  }else
+    runs.insert(after, Run(low,0));
+
+  ++cardinality;
+  shrink();
+  return true;
+}
+
+
+template<class T>
+bool RoaringSet<T>::Container::remove(std::uint16_t low) {
+  if (kind == ARRAY) {
+    auto at = std::lower_bound(array.begin(), array.end(), low);
+    if (at == array.end() || *at != low)
+      return false;
+    array.erase(at);
+    --cardinality;
+    return true;
+  }
+
+  if (kind == BITMAP) {
+    std::uint64_t bit = std::uint64_t(1) << (low & 63);
+    if (!(bitmap[low >> 6] & bit))
+      return false;
+    bitmap[low >> 6] &= ~bit;
+    --cardinality;
+    shrink();
+    return true;
+  }
+
+  //RUN: shorten, split or erase the run containing low
+  auto after = std::upper_bound(runs.begin(), runs.end(), low, [](std::uint16_t v, const Run& r) {return v < r.start;});
+  if (after == runs.begin() || low > (after-1)->start + (after-1)->length)
+    return false;
+
+  Run& r = *(after-1);
+  int last = r.start + r.length;
+  if (r.length == 0)
+    runs.erase(after-1);
+  else if (low == r.start) {
+    ++r.start;
+    --r.length;
+  }else if (low == last)
+    --r.length;
+  else {
+    r.length = low - r.start - 1;
+    runs.insert(after, Run(low+1, last-low-1));
+  }
+
+  --cardinality;
+  shrink();
+  return true;
+}
+
+
+template<class T>
+bool RoaringSet<T>::Container::next(int from, std::uint16_t& into) const {
+  if (from > 0xFFFF)
+    return false;
+
+  if (kind == ARRAY) {
+    auto at = std::lower_bound(array.begin(), array.end(), from);
+    if (at == array.end())
+      return false;
+    into = *at;
+    return true;
+  }
+
+  if (kind == BITMAP) {
+    int w = from >> 6;
+    std::uint64_t word = bitmap[w] & (~std::uint64_t(0) << (from & 63));
+    for (;;) {
+      if (word != 0) {
+        into = w*64 + lowest_bit(word);
+        return true;
+      }
+      if (++w == words)
+        return false;
+      word = bitmap[w];
+    }
+  }
+
+  auto after = std::upper_bound(runs.begin(), runs.end(), from, [](int v, const Run& r) {return v < r.start;});
+  if (after != runs.begin() && from <= (after-1)->start + (after-1)->length) {
+    into = from;
+    return true;
+  }
+  if (after == runs.end())
+    return false;
+  into = after->start;
+  return true;
+}
+
+
+template<class T>
+long RoaringSet<T>::Container::bytes() const {
+  switch (kind) {
+    case ARRAY:  return 2L*array.size();
+    case BITMAP: return 8L*words;
+    default:     return 4L*runs.size();
+  }
+}
+
+
+//A run starts at each set bit whose preceding bit (carried across words) is clear
+template<class T>
+int RoaringSet<T>::Container::count_runs() const {
+  switch (kind) {
+    case ARRAY: {
+      int count = 0;
+      for (int i=0; i<int(array.size()); ++i)
+        if (i == 0 || array[i-1]+1 != array[i])
+          ++count;
+      return count;
+    }
+    case BITMAP: {
+      int count = 0;
+      std::uint64_t carry = 0;
+      for (std::uint64_t word : bitmap) {
+        count += popcount(word & ~((word << 1) | carry));
+        carry = word >> 63;
+      }
+      return count;
+    }
+    default:
+      return runs.size();
+  }
+}
+
+
+template<class T>
+bool RoaringSet<T>::Container::subset_of(const Container& rhs) const {
+  if (cardinality > rhs.cardinality)
+    return false;
+
+  if (kind == BITMAP && rhs.kind == BITMAP) {
+    std::uint64_t outside = 0;
+    for (int w=0; w<words; ++w)
+      outside |= bitmap[w] & ~rhs.bitmap[w];
+    return outside == 0;
+  }
+
+  return for_each([&rhs](std::uint16_t low) {return rhs.contains(low);});
+}
+
+
+template<class T>
+template<class Visit>
+bool RoaringSet<T>::Container::for_each(Visit visit) const {
+  switch (kind) {
+    case ARRAY:
+      for (std::uint16_t low : array)
+        if (!visit(low))
+          return false;
+      return true;
+    case BITMAP:
+      for (int w=0; w<words; ++w)
+        for (std::uint64_t word = bitmap[w]; word != 0; word &= word-1)
+          if (!visit(std::uint16_t(w*64 + lowest_bit(word))))
+            return false;
+      return true;
+    default:
+      for (const Run& r : runs)
+        for (int low = r.start; low <= r.start+r.length; ++low)
+          if (!visit(std::uint16_t(low)))
+            return false;
+      return true;
+  }
+}
+
+
+template<class T>
+void RoaringSet<T>::Container::to_array() {
+  if (kind == ARRAY)
+    return;
+
+  std::vector<std::uint16_t> values;
+  values.reserve(cardinality);
+  for_each([&values](std::uint16_t low) {values.push_back(low); return true;});
+  array.swap(values);
+  std::vector<std::uint64_t>().swap(bitmap);
+  std::vector<Run>().swap(runs);
+  kind = ARRAY;
+}
+
+
+template<class T>
+void RoaringSet<T>::Container::to_bitmap() {
+  if (kind == BITMAP)
+    return;
+
+  std::vector<std::uint64_t> scratch;
+  bitmap_of(*this, scratch);
+  bitmap.swap(scratch);
+  std::vector<std::uint16_t>().swap(array);
+  std::vector<Run>().swap(runs);
+  kind = BITMAP;
+}
+
+
+template<class T>
+void RoaringSet<T>::Container::to_runs() {
+  if (kind == RUN)
+    return;
+
+  std::vector<Run> found;
+  for_each([&found](std::uint16_t low) {
+    if (!found.empty() && found.back().start + found.back().length + 1 == low)
+      ++found.back().length;
+    else
+      found.push_back(Run(low,0));
+    return true;
+  });
+  runs.swap(found);
+  std::vector<std::uint16_t>().swap(array);
+  std::vector<std::uint64_t>().swap(bitmap);
+  kind = RUN;
+}
+
+
+template<class T>
+void RoaringSet<T>::Container::shrink() {
+  long other_bytes = (cardinality <= array_max ? 2L*cardinality : 8L*words);
+  if (kind == RUN) {
+    if (4L*long(runs.size()) <= other_bytes)
+      return;
+  }else if ((kind == ARRAY) == (cardinality <= array_max))
+    return;
+
+  if (cardinality <= array_max)
+    to_array();
+  else
+    to_bitmap();
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class T>
+RoaringSet<T>::Iterator::Iterator(RoaringSet<T>* iterate_over, bool from_begin)
+: current(0), value(T()), at_end(true), ref_set(iterate_over), expected_mod_count(iterate_over->mod_count) {
+  if (from_begin)
+    move_to(0);
+}
+
+
+template<class T>
+RoaringSet<T>::Iterator::~Iterator()
+{}
+
+
+template<class T>
+void RoaringSet<T>::Iterator::move_to(std::uint32_t from) {
+  at_end = !ref_set->next_bits(from, current);
+  if (!at_end)
+    value = from_bits(current);
+}
+
+
+template<class T>
+T RoaringSet<T>::Iterator::erase() {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("RoaringSet::Iterator::erase");
+  if (!can_erase)
+    throw CannotEraseError("RoaringSet::Iterator::erase Iterator cursor already erased");
+  if (at_end)
+    throw CannotEraseError("RoaringSet::Iterator::erase Iterator cursor beyond data structure");
+
+  can_erase = false;
+  T to_return = value;
+  ref_set->erase(to_return);
+  move_to(current);    //current is no longer in the set: move to the next value
+  expected_mod_count = ref_set->mod_count;
+  return to_return;
+}
+
+
+template<class T>
+std::string RoaringSet<T>::Iterator::str() const {
+  std::ostringstream answer;
+  answer << ref_set->str() << "(current=";
+  if (at_end)
+    answer << "end";
+  else
+    answer << value;
+  answer << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
+  return answer.str();
+}
+
+
+template<class T>
+auto RoaringSet<T>::Iterator::operator ++ () -> RoaringSet<T>::Iterator& {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("RoaringSet::Iterator::operator ++");
+
+  if (at_end)
+    return *this;
+
+  if (!can_erase)
+    can_erase = true;   //Already at the next value: just allow erase
+  else if (current == 0xFFFFFFFFu)
+    at_end = true;
+  else
+    move_to(current+1);
+  return *this;
+}
+
+
+template<class T>
+auto RoaringSet<T>::Iterator::operator ++ (int) -> RoaringSet<T>::Iterator {
+  Iterator to_return(*this);
+  ++(*this);
+  return to_return;
+}
+
+
+template<class T>
+bool RoaringSet<T>::Iterator::operator == (const RoaringSet<T>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("RoaringSet::Iterator::operator ==");
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("RoaringSet::Iterator::operator ==");
+  if (ref_set != rhsASI->ref_set)
+    throw ComparingDifferentIteratorsError("RoaringSet::Iterator::operator ==");
+
+  return at_end == rhsASI->at_end && (at_end || current == rhsASI->current);
+}
+
+
+template<class T>
+bool RoaringSet<T>::Iterator::operator != (const RoaringSet<T>::Iterator& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T>
+const T& RoaringSet<T>::Iterator::operator *() const {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("RoaringSet::Iterator::operator *");
+  if (!can_erase || at_end)
+    throw IteratorPositionIllegal("RoaringSet::Iterator::operator * Iterator illegal: " + str());
+
+  return value;
+}
+
+
+template<class T>
+const T* RoaringSet<T>::Iterator::operator ->() const {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("RoaringSet::Iterator::operator ->");
+  if (!can_erase || at_end)
+    throw IteratorPositionIllegal("RoaringSet::Iterator::operator -> Iterator illegal: " + str());
+
+  return &value;
+}
+
+
+}
+
+#endif /* ROARING_SET_HPP_ */
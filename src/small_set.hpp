@@ -0,0 +1,594 @@
+#ifndef SMALL_SET_HPP_
+#define SMALL_SET_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <algorithm>            //For std::max
+#include <new>                  //For placement new
+#include <utility>              //For std::move
+#include "ics_exceptions.hpp"
+
+
+namespace ics {
+
+
+//A set storing its values contiguously (in insertion order) and finding them by
+//  a linear search: for small sets this beats hashing/following links, and the
+//  search loop over adjacent values is one the compiler can vectorize.
+//The first N values are stored inside the set object itself, so constructing,
+//  copying and filling a set of at most N values never allocates; only when an
+//  insert exceeds N are the values moved to an array on the heap (which then
+//  doubles as needed). clear returns the set to its in-object storage.
+//Erasing a value shifts the later values down one (keeping insertion order).
+template<class T, int N = 16> class SmallSet {
+  static_assert(N > 0, "SmallSet: N (in-object capacity) must be > 0");
+
+  public:
+    //Destructor/Constructors
+    ~SmallSet();
+
+    SmallSet          ();
+    explicit SmallSet (int initial_length);
+    SmallSet          (const SmallSet<T,N>& to_copy);
+    explicit SmallSet (const std::initializer_list<T>& il);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit SmallSet (const Iterable& i);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    bool inline_storage () const;  //true iff the values are still stored in the set object
+    bool contains   (const T& element) const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    bool contains_all (const Iterable& i) const;
+
+
+    //Commands
+    int  insert (const T& element);
+    int  erase  (const T& element);
+    void clear  ();
+
+    //Iterable class must support "for" loop: .begin()/.end() and prefix ++ on returned result
+
+    template <class Iterable>
+    int insert_all(const Iterable& i);
+
+    template <class Iterable>
+    int erase_all(const Iterable& i);
+
+    template<class Iterable>
+    int retain_all(const Iterable& i);  //Returns # erased
+
+
+    //Operators
+    SmallSet<T,N>& operator = (const SmallSet<T,N>& rhs);
+    bool operator == (const SmallSet<T,N>& rhs) const;
+    bool operator != (const SmallSet<T,N>& rhs) const;
+    bool operator <= (const SmallSet<T,N>& rhs) const;
+    bool operator <  (const SmallSet<T,N>& rhs) const;
+    bool operator >= (const SmallSet<T,N>& rhs) const;
+    bool operator >  (const SmallSet<T,N>& rhs) const;
+
+    template<class T2, int N2>
+    friend std::ostream& operator << (std::ostream& outs, const SmallSet<T2,N2>& s);
+
+
+
+  public:
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of SmallSet<T,N>
+        ~Iterator();
+        T           erase();
+        std::string str  () const;
+        SmallSet<T,N>::Iterator& operator ++ ();
+        SmallSet<T,N>::Iterator  operator ++ (int);
+        bool operator == (const SmallSet<T,N>::Iterator& rhs) const;
+        bool operator != (const SmallSet<T,N>::Iterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const SmallSet<T,N>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+        friend Iterator SmallSet<T,N>::begin () const;
+        friend Iterator SmallSet<T,N>::end   () const;
+
+      private:
+        //If can_erase is false, current indexes the "next" value (must ++ to reach it)
+        int            current;  //if can_erase is false, this value is unusable
+        SmallSet<T,N>* ref_set;
+        int            expected_mod_count;
+        bool           can_erase = true;
+
+        //Called in friends begin/end
+        Iterator(SmallSet<T,N>* iterate_over, int initial);
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+    alignas(T) unsigned char local[N*sizeof(T)];   //In-object storage for the first N values
+    T*  set       = reinterpret_cast<T*>(local);   //local, or a heap array once more than N values
+    int length    = N;                             //Physical length of set: must be >= .size()
+    int used      = 0;                             //Amount of set used: invariant: 0 <= used <= length
+    int mod_count = 0;                             //For sensing concurrent modification
+
+    //Helper methods
+    int  index_of      (const T& element) const;   //Index of element in set, or -1
+    int  erase_at      (int i);
+    void destroy_all   ();                         //Destroy the values, free any heap array, and use local again
+    void ensure_length (int new_length);           //Move the values to a heap array of at least new_length
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//SmallSet class and related definitions
+
+//Destructor/Constructors
+
+template<class T, int N>
+SmallSet<T,N>::~SmallSet() {
+  destroy_all();
+}
+
+
+template<class T, int N>
+SmallSet<T,N>::SmallSet()
+{}
+
+
+template<class T, int N>
+SmallSet<T,N>::SmallSet(int initial_length) {
+  ensure_length(initial_length);
+}
+
+
+template<class T, int N>
+SmallSet<T,N>::SmallSet(const SmallSet<T,N>& to_copy) {
+  ensure_length(to_copy.used);
+  for (; used < to_copy.used; ++used)
+    new (set+used) T(to_copy.set[used]);
+}
+
+
+template<class T, int N>
+SmallSet<T,N>::SmallSet(const std::initializer_list<T>& il) {
+  ensure_length(int(il.size()));
+  for (const T& s_elem : il)
+    insert(s_elem);
+}
+
+
+template<class T, int N>
+template<class Iterable>
+SmallSet<T,N>::SmallSet(const Iterable& i) {
+  for (const T& s_elem : i)
+    insert(s_elem);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, int N>
+bool SmallSet<T,N>::empty() const {
+  return used == 0;
+}
+
+
+template<class T, int N>
+int SmallSet<T,N>::size() const {
+  return used;
+}
+
+
+template<class T, int N>
+bool SmallSet<T,N>::inline_storage() const {
+  return set == reinterpret_cast<const T*>(local);
+}
+
+
+template<class T, int N>
+bool SmallSet<T,N>::contains (const T& element) const {
+  return index_of(element) != -1;
+}
+
+
+template<class T, int N>
+std::string SmallSet<T,N>::str() const {
+  std::ostringstream answer;
+  answer << "small_set[";
+  for (int i=0; i<used; ++i)
+    answer << (i == 0 ? "" : ",") << i << ":" << set[i];
+  answer << "](length=" << length << ",used=" << used << ",inline=" << inline_storage() << ",mod_count=" << mod_count << ")";
+  return answer.str();
+}
+
+
+template<class T, int N>
+template<class Iterable>
+bool SmallSet<T,N>::contains_all (const Iterable& i) const {
+  for (const T& v : i)
+    if (!contains(v))
+      return false;
+
+  return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, int N>
+int SmallSet<T,N>::insert(const T& element) {
+  if (contains(element))
+    return 0;
+
+  if (used == length)
+    ensure_length(2*length);
+  new (set+used) T(element);
+  ++used;
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T, int N>
+int SmallSet<T,N>::erase(const T& element) {
+  int i = index_of(element);
+  if (i == -1)
+    return 0;
+
+  return erase_at(i);
+}
+
+
+template<class T, int N>
+void SmallSet<T,N>::clear() {
+  destroy_all();
+  ++mod_count;
+}
+
+
+template<class T, int N>
+template<class Iterable>
+int SmallSet<T,N>::insert_all(const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+    count += insert(v);
+
+  return count;
+}
+
+
+template<class T, int N>
+template<class Iterable>
+int SmallSet<T,N>::erase_all(const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+    count += erase(v);
+
+  return count;
+}
+
+
+//Compacts the kept values (in order) to the front of set in one pass
+template<class T, int N>
+template<class Iterable>
+int SmallSet<T,N>::retain_all(const Iterable& i) {
+  SmallSet<T,N> keep;
+  for (const T& v : i)
+    if (contains(v))
+      keep.insert(v);
+
+  int kept = 0;
+  for (int j=0; j<used; ++j)
+    if (keep.contains(set[j])) {
+      if (kept != j)
+        set[kept] = std::move(set[j]);
+      ++kept;
+    }
+
+  int count = used - kept;
+  for (int j=kept; j<used; ++j)
+    set[j].~T();
+  used = kept;
+  if (count != 0)
+    ++mod_count;
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T, int N>
+SmallSet<T,N>& SmallSet<T,N>::operator = (const SmallSet<T,N>& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  destroy_all();
+  ensure_length(rhs.used);
+  for (; used < rhs.used; ++used)
+    new (set+used) T(rhs.set[used]);
+  ++mod_count;
+  return *this;
+}
+
+
+template<class T, int N>
+bool SmallSet<T,N>::operator == (const SmallSet<T,N>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (used != rhs.size())
+    return false;
+
+  return rhs.contains_all(*this);
+}
+
+
+template<class T, int N>
+bool SmallSet<T,N>::operator != (const SmallSet<T,N>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T, int N>
+bool SmallSet<T,N>::operator <= (const SmallSet<T,N>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (used > rhs.size())
+    return false;
+
+  return rhs.contains_all(*this);
+}
+
+
+template<class T, int N>
+bool SmallSet<T,N>::operator < (const SmallSet<T,N>& rhs) const {
+  if (this == &rhs)
+    return false;
+  if (used >= rhs.size())
+    return false;
+
+  return rhs.contains_all(*this);
+}
+
+
+template<class T, int N>
+bool SmallSet<T,N>::operator >= (const SmallSet<T,N>& rhs) const {
+  return rhs <= *this;
+}
+
+
+template<class T, int N>
+bool SmallSet<T,N>::operator > (const SmallSet<T,N>& rhs) const {
+  return rhs < *this;
+}
+
+
+template<class T, int N>
+std::ostream& operator << (std::ostream& outs, const SmallSet<T,N>& s) {
+  outs << "set[";
+  for (int i=0; i<s.used; ++i)
+    outs << (i == 0 ? "" : ",") << s.set[i];
+  outs << "]";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class T, int N>
+auto SmallSet<T,N>::begin () const -> SmallSet<T,N>::Iterator {
+  return Iterator(const_cast<SmallSet<T,N>*>(this),0);
+}
+
+
+template<class T, int N>
+auto SmallSet<T,N>::end () const -> SmallSet<T,N>::Iterator {
+  return Iterator(const_cast<SmallSet<T,N>*>(this),used);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, int N>
+int SmallSet<T,N>::index_of(const T& element) const {
+  for (int i=0; i<used; ++i)
+    if (set[i] == element)
+      return i;
+
+  return -1;
+}
+
+
+template<class T, int N>
+int SmallSet<T,N>::erase_at(int i) {
+  for (; i < used-1; ++i)
+    set[i] = std::move(set[i+1]);
+  set[--used].~T();
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T, int N>
+void SmallSet<T,N>::destroy_all() {
+  for (int i=0; i<used; ++i)
+    set[i].~T();
+  if (!inline_storage())
+    ::operator delete(set);
+  set    = reinterpret_cast<T*>(local);
+  length = N;
+  used   = 0;
+}
+
+
+template<class T, int N>
+void SmallSet<T,N>::ensure_length(int new_length) {
+  if (length >= new_length)
+    return;
+
+  length = std::max(new_length,2*length);
+  T* old_set = set;
+  set = static_cast<T*>(::operator new(length*sizeof(T)));
+  for (int i=0; i<used; ++i) {
+    new (set+i) T(std::move(old_set[i]));
+    old_set[i].~T();
+  }
+  if (old_set != reinterpret_cast<T*>(local))
+    ::operator delete(old_set);
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class T, int N>
+SmallSet<T,N>::Iterator::Iterator(SmallSet<T,N>* iterate_over, int initial)
+: current(initial), ref_set(iterate_over), expected_mod_count(iterate_over->mod_count)
+{}
+
+
+template<class T, int N>
+SmallSet<T,N>::Iterator::~Iterator()
+{}
+
+
+template<class T, int N>
+T SmallSet<T,N>::Iterator::erase() {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("SmallSet::Iterator::erase");
+  if (!can_erase)
+    throw CannotEraseError("SmallSet::Iterator::erase Iterator cursor already erased");
+  if (current < 0 || current >= ref_set->used)
+    throw CannotEraseError("SmallSet::Iterator::erase Iterator cursor beyond data structure");
+
+  can_erase = false;
+  T to_return = ref_set->set[current];
+  ref_set->erase_at(current);   //current now indexes the next value
+  expected_mod_count = ref_set->mod_count;
+  return to_return;
+}
+
+
+template<class T, int N>
+std::string SmallSet<T,N>::Iterator::str() const {
+  std::ostringstream answer;
+  answer << ref_set->str() << "(current=" << current << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
+  return answer.str();
+}
+
+
+template<class T, int N>
+auto SmallSet<T,N>::Iterator::operator ++ () -> SmallSet<T,N>::Iterator& {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("SmallSet::Iterator::operator ++");
+
+  if (current >= ref_set->used)
+    return *this;
+
+  if (can_erase)
+    ++current;
+  else
+    can_erase = true;   //current already indexes the next value: just allow erase
+  return *this;
+}
+
+
+template<class T, int N>
+auto SmallSet<T,N>::Iterator::operator ++ (int) -> SmallSet<T,N>::Iterator {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("SmallSet::Iterator::operator ++(int)");
+
+  if (current >= ref_set->used)
+    return *this;
+
+  Iterator to_return(*this);
+  if (can_erase)
+    ++current;
+  else
+    can_erase = true;
+  return to_return;
+}
+
+
+template<class T, int N>
+bool SmallSet<T,N>::Iterator::operator == (const SmallSet<T,N>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("SmallSet::Iterator::operator ==");
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("SmallSet::Iterator::operator ==");
+  if (ref_set != rhsASI->ref_set)
+    throw ComparingDifferentIteratorsError("SmallSet::Iterator::operator ==");
+
+  return current == rhsASI->current;
+}
+
+
+template<class T, int N>
+bool SmallSet<T,N>::Iterator::operator != (const SmallSet<T,N>::Iterator& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T, int N>
+T& SmallSet<T,N>::Iterator::operator *() const {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("SmallSet::Iterator::operator *");
+  if (!can_erase || current < 0 || current >= ref_set->used) {
+    std::ostringstream where;
+    where << current << " when size = " << ref_set->size();
+    throw IteratorPositionIllegal("SmallSet::Iterator::operator * Iterator illegal: "+where.str());
+  }
+
+  return ref_set->set[current];
+}
+
+
+template<class T, int N>
+T* SmallSet<T,N>::Iterator::operator ->() const {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("SmallSet::Iterator::operator ->");
+  if (!can_erase || current < 0 || current >= ref_set->used) {
+    std::ostringstream where;
+    where << current << " when size = " << ref_set->size();
+    throw IteratorPositionIllegal("SmallSet::Iterator::operator -> Iterator illegal: "+where.str());
+  }
+
+  return &ref_set->set[current];
+}
+
+
+}
+
+#endif /* SMALL_SET_HPP_ */